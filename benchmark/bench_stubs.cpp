@@ -0,0 +1,41 @@
+/****************************************************************************************
+*  YAROCK                                                                               *
+*  Copyright (c) 2010-2014 Sebastien amardeilh <sebastien.amardeilh+yarock@gmail.com>   *
+*                                                                                       *
+*  This program is free software; you can redistribute it and/or modify it under        *
+*  the terms of the GNU General Public License as published by the Free Software        *
+*  Foundation; either version 2 of the License, or (at your option) any later           *
+*  version.                                                                             *
+*                                                                                       *
+*  This program is distributed in the hope that it will be useful, but WITHOUT ANY      *
+*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A      *
+*  PARTICULAR PURPOSE. See the GNU General Public License for more details.             *
+*                                                                                       *
+*  You should have received a copy of the GNU General Public License along with         *
+*  this program.  If not, see <http://www.gnu.org/licenses/>.                           *
+*****************************************************************************************/
+
+/*
+  network and info system symbols used by UltimateLyricsProvider, the
+  benchmark only calls the extraction and never sends a request
+*/
+#include "info_service.h"
+#include "networkaccess.h"
+
+INFO::InfoRequestData::InfoRequestData()
+{
+}
+
+void INFO::abortRequests( QMap<QObject*, INFO::InfoRequestData>&, quint64 )
+{
+}
+
+NetworkAccess* NetworkAccess::http()
+{
+    return 0;
+}
+
+NetworkReply* NetworkAccess::get(const QUrl)
+{
+    return 0;
+}
@@ -0,0 +1,117 @@
+/****************************************************************************************
+*  YAROCK                                                                               *
+*  Copyright (c) 2010-2014 Sebastien amardeilh <sebastien.amardeilh+yarock@gmail.com>   *
+*                                                                                       *
+*  This program is free software; you can redistribute it and/or modify it under        *
+*  the terms of the GNU General Public License as published by the Free Software        *
+*  Foundation; either version 2 of the License, or (at your option) any later           *
+*  version.                                                                             *
+*                                                                                       *
+*  This program is distributed in the hope that it will be useful, but WITHOUT ANY      *
+*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A      *
+*  PARTICULAR PURPOSE. See the GNU General Public License for more details.             *
+*                                                                                       *
+*  You should have received a copy of the GNU General Public License along with         *
+*  this program.  If not, see <http://www.gnu.org/licenses/>.                           *
+*****************************************************************************************/
+
+/*
+  halfscale_bench
+    -> compare the vectorised qt_halfScaledRow (SSE2 / AVX2 when the compiler
+       targets them) with the scalar AVG loop of qpixmapfilter
+    -> every row width from 1 to 67 pixels covers the vector bodies and the
+       scalar tails, both outputs must be bit-exact
+    -> timing of a full 32 bits cover sized half scale for both paths
+*/
+#include "views/local/qpixmapfilter.h"
+
+#include <QtGlobal>
+#include <QDebug>
+#include <QElapsedTimer>
+#include <QVector>
+
+static const int ITERATIONS = 200;
+static const int MAX_WIDTH  = 67;
+static const int IMAGE_SIZE = 512;
+
+#define AVG(a,b)  ( ((((a)^(b)) & 0xfefefefeUL) >> 1) + ((a)&(b)) )
+
+/* scalar reference, as the former qt_halfScaled row loop */
+static void scalarHalfScaledRow(const quint32 *p1, const quint32 *p2, quint32 *q, int ww)
+{
+    for (int x = ww; x; --x, ++q, p1 += 2, p2 += 2)
+        *q = AVG(AVG(p1[0], p1[1]), AVG(p2[0], p2[1]));
+}
+
+static quint32 randomPixel()
+{
+    return (quint32(qrand() & 0xffff) << 16) | quint32(qrand() & 0xffff);
+}
+
+/*
+********************************************************************************
+*                                                                              *
+*    main                                                                      *
+*                                                                              *
+********************************************************************************
+*/
+int main(int /*argc*/, char ** /*argv*/)
+{
+    qsrand(42);
+
+    int mismatches = 0;
+
+    for (int ww = 1; ww <= MAX_WIDTH; ++ww)
+    {
+      for (int run = 0; run < 100; ++run)
+      {
+        QVector<quint32> p1(2 * ww), p2(2 * ww), q(ww), r(ww);
+        for (int i = 0; i < 2 * ww; ++i) {
+          p1[i] = randomPixel();
+          p2[i] = randomPixel();
+        }
+
+        qt_halfScaledRow(p1.constData(), p2.constData(), q.data(), ww);
+        scalarHalfScaledRow(p1.constData(), p2.constData(), r.data(), ww);
+
+        for (int x = 0; x < ww; ++x) {
+          if (q.at(x) != r.at(x)) {
+            mismatches++;
+            qWarning() << "MISMATCH width" << ww << "pixel" << x
+                       << hex << q.at(x) << "scalar" << r.at(x);
+          }
+        }
+      }
+    }
+
+    /* timing on a cover sized image */
+    QVector<quint32> image(IMAGE_SIZE * IMAGE_SIZE);
+    QVector<quint32> dest(IMAGE_SIZE * IMAGE_SIZE / 4);
+    for (int i = 0; i < image.size(); ++i)
+      image[i] = randomPixel();
+
+    const int ww = IMAGE_SIZE / 2;
+    QElapsedTimer timer;
+
+    timer.start();
+    for (int i = 0; i < ITERATIONS; ++i)
+      for (int y = 0; y < IMAGE_SIZE / 2; ++y)
+        qt_halfScaledRow(image.constData() + 2 * y * IMAGE_SIZE,
+                         image.constData() + (2 * y + 1) * IMAGE_SIZE,
+                         dest.data() + y * ww, ww);
+    const qint64 vector_ms = timer.elapsed();
+
+    timer.start();
+    for (int i = 0; i < ITERATIONS; ++i)
+      for (int y = 0; y < IMAGE_SIZE / 2; ++y)
+        scalarHalfScaledRow(image.constData() + 2 * y * IMAGE_SIZE,
+                            image.constData() + (2 * y + 1) * IMAGE_SIZE,
+                            dest.data() + y * ww, ww);
+    const qint64 scalar_ms = timer.elapsed();
+
+    qDebug() << "widths 1 -" << MAX_WIDTH << "mismatches" << mismatches;
+    qDebug() << "total for" << ITERATIONS << IMAGE_SIZE << "x" << IMAGE_SIZE << "half scales, vector"
+             << vector_ms << "ms" << "scalar" << scalar_ms << "ms";
+
+    return mismatches == 0 ? 0 : 1;
+}
@@ -0,0 +1,478 @@
+/****************************************************************************************
+*  YAROCK                                                                               *
+*  Copyright (c) 2010-2014 Sebastien amardeilh <sebastien.amardeilh+yarock@gmail.com>   *
+*                                                                                       *
+*  This program is free software; you can redistribute it and/or modify it under        *
+*  the terms of the GNU General Public License as published by the Free Software        *
+*  Foundation; either version 2 of the License, or (at your option) any later           *
+*  version.                                                                             *
+*                                                                                       *
+*  This program is distributed in the hope that it will be useful, but WITHOUT ANY      *
+*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A      *
+*  PARTICULAR PURPOSE. See the GNU General Public License for more details.             *
+*                                                                                       *
+*  You should have received a copy of the GNU General Public License along with         *
+*  this program.  If not, see <http://www.gnu.org/licenses/>.                           *
+*****************************************************************************************/
+
+/*
+  lyrics_extract_bench
+    -> compare lyrics extraction of compiled provider rules with the former
+       algorithm (one extracted copy of the page per rule item)
+    -> every provider is run on every page, both outputs must be identical
+    -> extra pages : raw html files or captures written with
+       YAROCK_NETWORK_RECORD, request fields given with --artist= --album=
+       --title= --track=
+*/
+#include "ultimatelyricsprovider.h"
+#include "ultimatelyricsreader.h"
+
+#include <QCoreApplication>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QStringList>
+#include <QTextCodec>
+#include <QTextStream>
+#include <QUrl>
+#include <QXmlStreamReader>
+
+static const int ITERATIONS = 200;
+
+static const quint32 CAPTURE_MAGIC = 0x594e4554; /* YNET */
+
+/*
+********************************************************************************
+*                                                                              *
+*    former extraction algorithm                                               *
+*                                                                              *
+********************************************************************************
+*/
+struct FormerProvider
+{
+    QString                          name;
+    QString                          charset;
+    QList< QPair<QRegExp, QString> > url_formats;
+    QList<UltimateLyricsProvider::Rule> extract_rules;
+    QList<UltimateLyricsProvider::Rule> exclude_rules;
+    QStringList                      invalid_indicators;
+};
+
+static QString firstChar(const QString& text)
+{
+    if (text.isEmpty())
+      return QString();
+    return text[0].toLower();
+}
+
+static QString titleCase(const QString& text)
+{
+    if (text.length() == 0)
+      return QString();
+
+    if (text.length() == 1)
+      return text[0].toUpper();
+
+    return text[0].toUpper() + text.right(text.length() - 1).toLower();
+}
+
+static QString noSpace(const QString& text)
+{
+    QString ret(text);
+    ret.remove(' ');
+    return ret;
+}
+
+static void replaceField(const FormerProvider& provider, const QString& tag, const QString& value, QString* text)
+{
+    if (!text->contains(tag))
+      return;
+
+    QString value_copy(value);
+    for (int i = 0; i < provider.url_formats.size(); ++i)
+      value_copy.replace(provider.url_formats.at(i).first, provider.url_formats.at(i).second);
+
+    text->replace(tag, value_copy, Qt::CaseInsensitive);
+}
+
+static void replaceFields(const FormerProvider& provider, const INFO::InfoStringHash& hash, QString* text)
+{
+    replaceField(provider, "{artist}",  hash["artist"].toLower(),          text);
+    replaceField(provider, "{artist2}", noSpace(hash["artist"].toLower()), text);
+    replaceField(provider, "{album}",   hash["album"].toLower(),           text);
+    replaceField(provider, "{album2}",  noSpace(hash["album"].toLower()),  text);
+    replaceField(provider, "{title}",   hash["title"].toLower(),           text);
+    replaceField(provider, "{Artist}",  hash["artist"],                    text);
+    replaceField(provider, "{Album}",   hash["album"],                     text);
+    replaceField(provider, "{ARTIST}",  hash["artist"].toUpper(),          text);
+    replaceField(provider, "{year}",    hash["year"],                      text);
+    replaceField(provider, "{Title}",   hash["title"],                     text);
+    replaceField(provider, "{Title2}",  titleCase(hash["title"]),          text);
+    replaceField(provider, "{a}",       firstChar(hash["artist"]),         text);
+    replaceField(provider, "{track}",   hash["number"],                    text);
+}
+
+static QString extract(const QString& source, const QString& begin, const QString& end)
+{
+    int begin_idx = source.indexOf(begin);
+    if (begin_idx == -1)
+      return QString();
+    begin_idx += begin.length();
+
+    int end_idx = source.indexOf(end, begin_idx);
+    if (end_idx == -1)
+      return QString();
+
+    return source.mid(begin_idx, end_idx - begin_idx - 1);
+}
+
+static QString extractXmlTag(const QString& source, const QString& tag)
+{
+    QRegExp re("<(\\w+).*>");
+    if (re.indexIn(tag) == -1)
+      return QString();
+
+    return extract(source, tag, "</" + re.cap(1) + ">");
+}
+
+static QString exclude(const QString& source, const QString& begin, const QString& end)
+{
+    int begin_idx = source.indexOf(begin);
+    if (begin_idx == -1)
+      return source;
+
+    int end_idx = source.indexOf(end, begin_idx + begin.length());
+    if (end_idx == -1)
+      return source;
+
+    return source.left(begin_idx) + source.right(source.length() - end_idx - end.length());
+}
+
+static QString excludeXmlTag(const QString& source, const QString& tag)
+{
+    QRegExp re("<(\\w+).*>");
+    if (re.indexIn(tag) == -1)
+      return source;
+
+    return exclude(source, tag, "</" + re.cap(1) + ">");
+}
+
+static QString formerExtractLyrics(const FormerProvider& provider, const INFO::InfoStringHash& hash,
+                                   const QString& original_content)
+{
+    foreach (const QString& indicator, provider.invalid_indicators) {
+      if (original_content.contains(indicator))
+        return QString();
+    }
+
+    QString lyrics;
+    foreach (const UltimateLyricsProvider::Rule& rule, provider.extract_rules) {
+      UltimateLyricsProvider::Rule rule_copy(rule);
+      for (UltimateLyricsProvider::Rule::iterator it = rule_copy.begin() ; it != rule_copy.end() ; ++it)
+        replaceFields(provider, hash, &it->first);
+
+      QString content = original_content;
+      foreach (const UltimateLyricsProvider::RuleItem& item, rule_copy) {
+        if (item.second.isNull())
+          content = extractXmlTag(content, item.first);
+        else
+          content = extract(content, item.first, item.second);
+      }
+
+      if (!content.isEmpty()) {
+        lyrics = content;
+        break;
+      }
+    }
+
+    foreach (const UltimateLyricsProvider::Rule& rule, provider.exclude_rules) {
+      foreach (const UltimateLyricsProvider::RuleItem& item, rule) {
+        if (item.second.isNull())
+          lyrics = excludeXmlTag(lyrics, item.first);
+        else
+          lyrics = exclude(lyrics, item.first, item.second);
+      }
+    }
+
+    return lyrics;
+}
+
+/*
+********************************************************************************
+*                                                                              *
+*    provider file, raw rules for the former algorithm                         *
+*                                                                              *
+********************************************************************************
+*/
+static UltimateLyricsProvider::Rule parseRule(QXmlStreamReader* reader)
+{
+    UltimateLyricsProvider::Rule ret;
+
+    while (!reader->atEnd()) {
+      reader->readNext();
+
+      if (reader->tokenType() == QXmlStreamReader::EndElement)
+        break;
+
+      if (reader->tokenType() == QXmlStreamReader::StartElement) {
+        if (reader->name() == "item") {
+          QXmlStreamAttributes attr = reader->attributes();
+          if (attr.hasAttribute("tag"))
+            ret << UltimateLyricsProvider::RuleItem(attr.value("tag").toString(), QString());
+          else if (attr.hasAttribute("begin"))
+            ret << UltimateLyricsProvider::RuleItem(attr.value("begin").toString(),
+                                                    attr.value("end").toString());
+        }
+        reader->skipCurrentElement();
+      }
+    }
+    return ret;
+}
+
+static QList<FormerProvider> parseFormerProviders(const QString& filename)
+{
+    QList<FormerProvider> providers;
+
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly))
+      return providers;
+
+    QXmlStreamReader reader(&file);
+    while (!reader.atEnd()) {
+      reader.readNext();
+      if (reader.tokenType() != QXmlStreamReader::StartElement || reader.name() != "provider")
+        continue;
+
+      FormerProvider provider;
+      provider.name    = reader.attributes().value("name").toString();
+      provider.charset = reader.attributes().value("charset").toString();
+
+      while (!reader.atEnd()) {
+        reader.readNext();
+
+        if (reader.tokenType() == QXmlStreamReader::EndElement)
+          break;
+
+        if (reader.tokenType() != QXmlStreamReader::StartElement)
+          continue;
+
+        if (reader.name() == "extract")
+          provider.extract_rules << parseRule(&reader);
+        else if (reader.name() == "exclude")
+          provider.exclude_rules << parseRule(&reader);
+        else if (reader.name() == "invalidIndicator") {
+          provider.invalid_indicators << reader.attributes().value("value").toString();
+          reader.skipCurrentElement();
+        }
+        else if (reader.name() == "urlFormat") {
+          const QString replace = reader.attributes().value("replace").toString();
+          provider.url_formats << qMakePair(QRegExp("[" + QRegExp::escape(replace) + "]"),
+                                            reader.attributes().value("with").toString());
+          reader.skipCurrentElement();
+        }
+        else
+          reader.skipCurrentElement();
+      }
+
+      providers << provider;
+    }
+
+    return providers;
+}
+
+/*
+********************************************************************************
+*                                                                              *
+*    pages                                                                     *
+*                                                                              *
+********************************************************************************
+*/
+struct Page
+{
+    QString                name;
+    QByteArray             bytes;
+    INFO::InfoStringHash   hash;
+};
+
+/* raw file, or body of a capture written in network record mode */
+static bool readPage(const QString& filename, QByteArray* bytes)
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly))
+      return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic = 0, version = 0;
+    in >> magic >> version;
+
+    if (magic != CAPTURE_MAGIC) {
+      file.seek(0);
+      *bytes = file.readAll();
+      return true;
+    }
+
+    QString  url, error_string;
+    qint32   status, error, header_count;
+    QUrl     redirect;
+    in >> url >> status >> error >> error_string >> redirect >> header_count;
+
+    for (int i = 0; i < header_count; ++i) {
+      QByteArray name, value;
+      in >> name >> value;
+    }
+
+    in >> *bytes;
+    return in.status() == QDataStream::Ok;
+}
+
+/* pages.list : file;artist;album;title;track */
+static QList<Page> readPageList(const QString& dir)
+{
+    QList<Page> pages;
+
+    QFile file(dir + "/pages.list");
+    if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+      return pages;
+
+    QTextStream stream(&file);
+    stream.setCodec("UTF-8");
+
+    while (!stream.atEnd()) {
+      const QString line = stream.readLine().trimmed();
+      if (line.isEmpty() || line.startsWith('#'))
+        continue;
+
+      const QStringList fields = line.split(';');
+      if (fields.size() != 5)
+        continue;
+
+      Page page;
+      page.name           = fields.at(0);
+      page.hash["artist"] = fields.at(1);
+      page.hash["album"]  = fields.at(2);
+      page.hash["title"]  = fields.at(3);
+      page.hash["number"] = fields.at(4);
+
+      if (readPage(dir + "/" + page.name, &page.bytes))
+        pages << page;
+      else
+        qWarning() << "cannot read page" << page.name;
+    }
+
+    return pages;
+}
+
+/*
+********************************************************************************
+*                                                                              *
+*    main                                                                      *
+*                                                                              *
+********************************************************************************
+*/
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+
+    QList<Page> pages = readPageList(LYRICS_BENCH_PAGES_DIR);
+
+    INFO::InfoStringHash extra_hash;
+    QStringList          extra_files;
+    foreach (const QString& arg, app.arguments().mid(1)) {
+      if (arg.startsWith("--artist="))     extra_hash["artist"] = arg.mid(9);
+      else if (arg.startsWith("--album=")) extra_hash["album"]  = arg.mid(8);
+      else if (arg.startsWith("--title=")) extra_hash["title"]  = arg.mid(8);
+      else if (arg.startsWith("--track=")) extra_hash["number"] = arg.mid(8);
+      else extra_files << arg;
+    }
+
+    foreach (const QString& filename, extra_files) {
+      Page page;
+      page.name = filename;
+      page.hash = extra_hash;
+      if (readPage(filename, &page.bytes))
+        pages << page;
+      else
+        qWarning() << "cannot read page" << filename;
+    }
+
+    const QList<FormerProvider> former = parseFormerProviders(LYRICS_BENCH_PROVIDERS);
+    const QList<UltimateLyricsProvider*> compiled = UltimateLyricsReader().Parse(LYRICS_BENCH_PROVIDERS);
+
+    if (pages.isEmpty() || former.isEmpty() || former.size() != compiled.size()) {
+      qWarning() << "no page or provider to compare";
+      return 1;
+    }
+
+    for (int p = 0; p < former.size(); ++p) {
+      if (former.at(p).name != compiled.at(p)->name()) {
+        qWarning() << "provider list mismatch" << former.at(p).name;
+        return 1;
+      }
+    }
+
+    int     mismatches  = 0;
+    int     matches     = 0;
+    qint64  former_ms   = 0;
+    qint64  compiled_ms = 0;
+
+    foreach (const Page& page, pages)
+    {
+      INFO::InfoRequestData request;
+      request.requestId = 0;
+      request.type      = INFO::InfoTrackLyrics;
+      request.data      = QVariant::fromValue< INFO::InfoStringHash >( page.hash );
+
+      qint64 page_former_ms   = 0;
+      qint64 page_compiled_ms = 0;
+
+      for (int p = 0; p < former.size(); ++p)
+      {
+        const FormerProvider& provider = former.at(p);
+
+        QTextCodec* codec = QTextCodec::codecForName(provider.charset.toAscii().constData());
+        if (!codec)
+          continue;
+        const QString content = codec->toUnicode(page.bytes);
+
+        QString former_lyrics, compiled_lyrics;
+        QElapsedTimer timer;
+
+        timer.start();
+        for (int i = 0; i < ITERATIONS; ++i)
+          former_lyrics = formerExtractLyrics(provider, page.hash, content);
+        page_former_ms += timer.elapsed();
+
+        timer.start();
+        for (int i = 0; i < ITERATIONS; ++i)
+          compiled_lyrics = compiled.at(p)->ExtractLyrics(request, content);
+        page_compiled_ms += timer.elapsed();
+
+        if (former_lyrics != compiled_lyrics) {
+          mismatches++;
+          qWarning() << "MISMATCH" << page.name << provider.name
+                     << "former:" << former_lyrics.length() << "compiled:" << compiled_lyrics.length();
+        }
+        else if (!former_lyrics.isEmpty()) {
+          matches++;
+        }
+      }
+
+      qDebug() << qPrintable(page.name) << "size" << page.bytes.size()
+               << "former" << page_former_ms << "ms"
+               << "compiled" << page_compiled_ms << "ms";
+
+      former_ms   += page_former_ms;
+      compiled_ms += page_compiled_ms;
+    }
+
+    qDebug() << "pages" << pages.size() << "providers" << former.size()
+             << "lyrics found" << matches << "mismatches" << mismatches;
+    qDebug() << "total for" << ITERATIONS << "runs, former" << former_ms << "ms"
+             << "compiled" << compiled_ms << "ms";
+
+    qDeleteAll(compiled);
+
+    return mismatches == 0 ? 0 : 1;
+}
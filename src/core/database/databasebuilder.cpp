@@ -23,6 +23,7 @@
 
 #include "core/mediaitem/mediaitem.h"
 #include "core/mediaitem/playlist_parser.h"
+#include "covers/coverstore.h"
 
 #include "utilities.h"
 #include "debug.h"
@@ -43,7 +44,44 @@
 
 #include <QFuture>
 #include <QFutureWatcher>
+#include <QRunnable>
 
+/* cover decoding threads, tag reading keeps its own thread */
+static const int COVER_POOL_MAX_THREADS = 2;
+
+/*
+********************************************************************************
+*                                                                              *
+*    Class CoverArtJob                                                         *
+*      -> find cover art of one track for its album in cover pool              *
+*                                                                              *
+********************************************************************************
+*/
+class CoverArtJob : public QRunnable
+{
+  public:
+    CoverArtJob(const QString& coverName, const QString& trackFilename, bool checkDir, const bool* exit)
+      : m_cover_name(coverName), m_track_filename(trackFilename), m_check_dir(checkDir), m_exit(exit) {}
+
+    void run()
+    {
+      if(*m_exit || CoverStore::instance()->contains(m_cover_name))
+        return;
+
+      //! embedded cover first
+      if(DataBaseBuilder::storeCoverArt(m_cover_name, m_track_filename))
+        return;
+
+      if(m_check_dir && !*m_exit)
+        DataBaseBuilder::recupCoverArtFromDir(m_cover_name, m_track_filename);
+    }
+
+  private:
+    QString      m_cover_name;
+    QString      m_track_filename;
+    bool         m_check_dir;
+    const bool*  m_exit;
+};
 
 /*
 ********************************************************************************
@@ -55,6 +93,8 @@
 DataBaseBuilder::DataBaseBuilder()
 {
     m_exit            = false;
+
+    m_cover_pool.setMaxThreadCount( qBound(1, QThread::idealThreadCount() - 1, COVER_POOL_MAX_THREADS) );
 }
 
 /*******************************************************************************
@@ -115,6 +155,8 @@ void DataBaseBuilder::run()
 
     Debug::debug() << "- DataBaseBuilder -> starting Database update";
 
+    m_cover_lookups.clear();
+
     /*-----------------------------------------------------------*/
     /* Get files from filesystem                                 */
     /* ----------------------------------------------------------*/
@@ -194,6 +236,10 @@ void DataBaseBuilder::run()
     // Now write all data to the disk
     QSqlQuery("COMMIT TRANSACTION;",*m_sqlDb);
 
+    // Covers still being decoded (jobs return early on exit)
+    m_cover_pool.waitForDone();
+    m_cover_lookups.clear();
+
     Debug::debug() << "- DataBaseBuilder -> end Database update";
     if(!m_exit)
       emit buildingFinished();
@@ -216,9 +262,6 @@ void DataBaseBuilder::insertTrack(const QString& filename)
 
     Debug::debug() << "- DataBaseBuilder -> insert track :" << filename;
 
-    //! storage localtion
-    QString storageLocation = UTIL::CONFIGDIR + "/albums/";
-
     //! Read tag from URL file (with taglib)
     int disc_number = 0;
     MEDIA::TrackPtr track = MEDIA::FromLocalFile(fname, &disc_number);
@@ -244,10 +287,7 @@ void DataBaseBuilder::insertTrack(const QString& filename)
         );
 
     //! mise à jour du cover
-    storeCoverArt(storageLocation + cover_name, track->url);
-
-    if( DatabaseManager::instance()->DB_PARAM().checkCover )
-      recupCoverArtFromDir(storageLocation + cover_name, track->url);
+    queueCoverArt(cover_name, track->url);
 
     //! TRACK part in database
     QSqlQuery query(*m_sqlDb);
@@ -382,33 +422,54 @@ int DataBaseBuilder::insertAlbum(const QString & album, int artist_id,const QStr
 }
 
 
+/*******************************************************************************
+   DataBaseBuilder::queueCoverArt
+     -> embedded art is tried for each track until album has a cover,
+        directory is scanned once per album, done in cover pool
+*******************************************************************************/
+void DataBaseBuilder::queueCoverArt(const QString& coverName, const QString& trackFilename)
+{
+    //! check if cover art already exist
+    if(CoverStore::instance()->contains(coverName)) return;
+
+    const QString key = coverName + "|" + QFileInfo(trackFilename).absolutePath();
+
+    bool checkDir = false;
+    if(!m_cover_lookups.contains(key)) {
+      m_cover_lookups.insert(key);
+      checkDir = DatabaseManager::instance()->DB_PARAM().checkCover;
+    }
+
+    m_cover_pool.start(new CoverArtJob(coverName, trackFilename, checkDir, &m_exit));
+}
+
 /*******************************************************************************
    DataBaseBuilder::storeCoverArt
 *******************************************************************************/
-void DataBaseBuilder::storeCoverArt(const QString& coverFilePath, const QString& trackFilename)
+bool DataBaseBuilder::storeCoverArt(const QString& coverName, const QString& trackFilename)
 {
-    //Debug::debug() << "- DataBaseBuilder -> storeCoverArt " << coverFilePath;
+    //Debug::debug() << "- DataBaseBuilder -> storeCoverArt " << coverName;
 
     //! check if cover art already exist
-    QFile file(coverFilePath);
-    if(file.exists()) return;
+    if(CoverStore::instance()->contains(coverName)) return true;
+
+    //! get cover image from file, store scales it to all sizes
+    QImage image = QImage::fromData( MEDIA::LoadCoverByteArrayFromFile(trackFilename) );
+    if( image.isNull() )
+      return false;
 
-    //! get cover image from file
-    QImage image = MEDIA::LoadImageFromFile(trackFilename);
-    if( !image.isNull() )
-      image.save(coverFilePath, "png", -1);
+    return CoverStore::instance()->store(coverName, image);
 }
 
 /*******************************************************************************
    DataBaseBuilder::recupCoverArtFromDir
 *******************************************************************************/
-void DataBaseBuilder::recupCoverArtFromDir(const QString& coverFilePath, const QString& trackFilename)
+bool DataBaseBuilder::recupCoverArtFromDir(const QString& coverName, const QString& trackFilename)
 {
-    //Debug::debug() << "- DataBaseBuilder -> recupCoverArtFromDir " << coverFilePath;
+    //Debug::debug() << "- DataBaseBuilder -> recupCoverArtFromDir " << coverName;
 
     //! check if coverArt already exist
-    QFile file(coverFilePath);
-    if(file.exists()) return ;
+    if(CoverStore::instance()->contains(coverName)) return true;
 
     //! search album art into file source directory
     const QStringList imageFilters = QStringList() << "*.jpg" << "*.png";
@@ -425,12 +486,13 @@ void DataBaseBuilder::recupCoverArtFromDir(const QString& coverFilePath, const Q
       QImage image = QImage(file);
       //! check if not null image (occur when file is KO)
       if(!image.isNull()) {
-        image = image.scaled(QSize(110, 110), Qt::KeepAspectRatio, Qt::SmoothTransformation);
         //! check if save is OK
-        if(image.save(coverFilePath, "png", -1))
-          break;
+        if(CoverStore::instance()->store(coverName, image))
+          return true;
       }
     }
+
+    return false;
 }
 
 /*******************************************************************************
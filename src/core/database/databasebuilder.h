@@ -25,6 +25,8 @@
 #include <QSqlDatabase>
 #include <QString>
 #include <QHash>
+#include <QSet>
+#include <QThreadPool>
 
 /*
 ********************************************************************************
@@ -37,6 +39,8 @@
 //   - parse collection directory
 //   - read track file metada (using Taglib)
 //   - write sql database with track information
+//   - cover art lookup is done in a separate pool so image decoding does
+//     not slow down tag reading, album directory is scanned only once
 class DataBaseBuilder :  public QThread
 {
   Q_OBJECT
@@ -44,6 +48,9 @@ class DataBaseBuilder :  public QThread
     DataBaseBuilder();
     void setExit(bool b) {m_exit = b;}
 
+    static bool storeCoverArt(const QString& coverName, const QString& trackFilename);
+    static bool recupCoverArtFromDir(const QString& coverName, const QString& trackFilename);
+
   protected:
     void run();
 
@@ -63,8 +70,7 @@ class DataBaseBuilder :  public QThread
 
     void cleanUpDatabase();
 
-    void storeCoverArt(const QString& coverFilePath, const QString& trackFilename);
-    void recupCoverArtFromDir(const QString& coverFilePath, const QString& trackFilename);
+    void queueCoverArt(const QString& coverName, const QString& trackFilename);
 
     int insertGenre(const QString & genre);
     int insertYear(int year);
@@ -80,6 +86,10 @@ class DataBaseBuilder :  public QThread
 
     bool                 m_exit;
 
+    QThreadPool          m_cover_pool;
+    // covername|directory already scanned for image files
+    QSet<QString>        m_cover_lookups;
+
     QSqlDatabase        *m_sqlDb;
 
   signals:
@@ -20,6 +20,7 @@
 #include "core/player/engine.h"
 #include "core/mediaitem/mediaitem.h"
 #include "models/local/local_track_model.h"
+#include "smartplaylist/smartplaylist.h"
 #include "debug.h"
 
 #include <QDateTime>
@@ -168,6 +169,8 @@ void HistoManager::addToDatabase()
         MEDIA::ArtistPtr artist = MEDIA::ArtistPtr::staticCast(album->parent());
         artist->playcount++;
       }
+
+      SmartPlaylist::invalidateCache(SmartPlaylist::DEP_PLAYCOUNT);
     }
 
 
@@ -19,6 +19,7 @@
 // local
 #include "mediaitem.h"
 #include "core/database/database.h"
+#include "covers/coverstore.h"
 #include "utilities.h"
 #include "debug.h"
 
@@ -30,6 +31,7 @@
 
 #include <QVariant>
 #include <QFileInfo>
+#include <QHash>
 #include <QByteArray>
 #include <QBuffer>
 #include <QUrl>
@@ -104,8 +106,7 @@ QString MEDIA::Album::yearToString() const
 
 QImage MEDIA::Album::image() const
 {
-    QString path = QString(UTIL::CONFIGDIR + "/albums/" + coverpath);
-    return QImage(path);
+    return CoverStore::instance()->image(coverpath);
 }
 
 /*
@@ -518,6 +519,46 @@ MEDIA::TrackPtr MEDIA::FromLocalFile(const QString url, int* p_disc)
 }
 
 
+/*******************************************************************************
+    trackFromQuery
+    -> row of a TRACK_SELECT query to track, shared by MEDIA::FromDataBase
+*******************************************************************************/
+static const QString TRACK_SELECT = "SELECT id,filename,trackname, \
+       number,length,artist_name,genre_name,album_name,year,last_played, \
+       albumgain,albumpeakgain,trackgain,trackpeakgain,playcount,rating \
+       FROM view_tracks ";
+
+static MEDIA::TrackPtr trackFromQuery(const QSqlQuery& query, const QString& url)
+{
+    MEDIA::TrackPtr media = MEDIA::TrackPtr(new MEDIA::Track());
+
+    media->id         =  query.value(0).toInt();
+    media->url        =  url;
+    media->name       =  query.value(1).toString();
+    media->title      =  query.value(2).toString();
+    media->num        =  query.value(3).toUInt();
+    media->duration   =  query.value(4).toInt();
+    media->artist     =  query.value(5).toString();
+    media->genre      =  query.value(6).toString();
+    media->album      =  query.value(7).toString();
+    media->year       =  query.value(8).toUInt();
+    media->lastPlayed =  query.value(9).toInt();
+    media->albumGain  =  query.value(10).value<qreal>();
+    media->albumPeak  =  query.value(11).value<qreal>();
+    media->trackGain  =  query.value(12).value<qreal>();
+    media->trackPeak  =  query.value(13).value<qreal>();
+    media->playcount  =  query.value(14).toInt();
+    media->rating     =  query.value(15).toFloat();
+
+    //! default state value
+    media->isPlaying    =  false;
+    media->isBroken     =  false;
+    media->isPlayed     =  false;
+    media->isStopAfter  =  false;
+
+    return media;
+}
+
 /*******************************************************************************
     MEDIA::FromDataBase
     -> with track url
@@ -534,40 +575,10 @@ MEDIA::TrackPtr MEDIA::FromDataBase(const QString url)
     data.setValue(QFileInfo(url).canonicalFilePath());
     QString fname = db.sqlDb()->driver()->formatValue(data,false);
 
-    QSqlQuery tracksQuery("SELECT id,filename,trackname, \
-       number,length,artist_name,genre_name,album_name,year,last_played, \
-       albumgain,albumpeakgain,trackgain,trackpeakgain,playcount,rating \
-       FROM view_tracks WHERE filename="+fname+" LIMIT 1;",*db.sqlDb());
+    QSqlQuery tracksQuery(TRACK_SELECT + "WHERE filename="+fname+" LIMIT 1;",*db.sqlDb());
 
     if (tracksQuery.first()) {
-      MEDIA::TrackPtr media = MEDIA::TrackPtr(new MEDIA::Track());
-
-      //Debug::debug() << " Build MediaItem FROM DATABASE ok";
-      media->id         =  tracksQuery.value(0).toInt();
-      media->url        =  url;
-      media->name       =  tracksQuery.value(1).toString();
-      media->title      =  tracksQuery.value(2).toString();
-      media->num        =  tracksQuery.value(3).toUInt();
-      media->duration   =  tracksQuery.value(4).toInt();
-      media->artist     =  tracksQuery.value(5).toString();
-      media->genre      =  tracksQuery.value(6).toString();
-      media->album      =  tracksQuery.value(7).toString();
-      media->year       =  tracksQuery.value(8).toUInt();
-      media->lastPlayed =  tracksQuery.value(9).toInt();
-      media->albumGain  =  tracksQuery.value(10).value<qreal>();
-      media->albumPeak  =  tracksQuery.value(11).value<qreal>();
-      media->trackGain  =  tracksQuery.value(12).value<qreal>();
-      media->trackPeak  =  tracksQuery.value(13).value<qreal>();
-      media->playcount  =  tracksQuery.value(14).toInt();
-      media->rating     =  tracksQuery.value(15).toFloat();
-
-      //! default state value
-      media->isPlaying    =  false;
-      media->isBroken     =  false;
-      media->isPlayed     =  false;
-      media->isStopAfter  =  false;
-
-      return media;
+      return trackFromQuery(tracksQuery, url);
     }
     //Debug::debug() << " Build MediaItem FROM DATABASE not found " << url;
 
@@ -590,40 +601,10 @@ MEDIA::TrackPtr MEDIA::FromDataBase(int trackId)
   //! Try database connection
   if (db.connect()) {
 
-    QSqlQuery tracksQuery("SELECT id,filename,trackname, \
-       number,length,artist_name,genre_name,album_name,year,last_played, \
-       albumgain,albumpeakgain,trackgain,trackpeakgain,playcount,rating \
-       FROM view_tracks WHERE id="+QString::number(trackId)+" LIMIT 1;",*db.sqlDb());
+    QSqlQuery tracksQuery(TRACK_SELECT + "WHERE id="+QString::number(trackId)+" LIMIT 1;",*db.sqlDb());
 
     if (tracksQuery.first()) {
-      MEDIA::TrackPtr media = MEDIA::TrackPtr(new MEDIA::Track());
-
-      //Debug::debug() << " Build MediaItem FROM DATABASE ok";
-      media->id         =  tracksQuery.value(0).toInt();
-      media->url        =  tracksQuery.value(1).toString();
-      media->name       =  tracksQuery.value(1).toString();
-      media->title      =  tracksQuery.value(2).toString();
-      media->num        =  tracksQuery.value(3).toUInt();
-      media->duration   =  tracksQuery.value(4).toInt();
-      media->artist     =  tracksQuery.value(5).toString();
-      media->genre      =  tracksQuery.value(6).toString();
-      media->album      =  tracksQuery.value(7).toString();
-      media->year       =  tracksQuery.value(8).toUInt();
-      media->lastPlayed =  tracksQuery.value(9).toInt();
-      media->albumGain  =  tracksQuery.value(10).value<qreal>();
-      media->albumPeak  =  tracksQuery.value(11).value<qreal>();
-      media->trackGain  =  tracksQuery.value(12).value<qreal>();
-      media->trackPeak  =  tracksQuery.value(13).value<qreal>();
-      media->playcount  =  tracksQuery.value(14).toInt();
-      media->rating     =  tracksQuery.value(15).toFloat();
-
-      //! default state value
-      media->isPlaying    =  false;
-      media->isBroken     =  false;
-      media->isPlayed     =  false;
-      media->isStopAfter  =  false;
-
-      return media;
+      return trackFromQuery(tracksQuery, tracksQuery.value(1).toString());
     }
 
   } // end connect Db
@@ -631,6 +612,64 @@ MEDIA::TrackPtr MEDIA::FromDataBase(int trackId)
   return MEDIA::TrackPtr(0);
 }
 
+/*******************************************************************************
+    MEDIA::FromDataBase
+    -> with a list of track urls, resolved with one query per chunk of urls
+    -> returned list is aligned on urls, null pointer for tracks not found
+*******************************************************************************/
+QList<MEDIA::TrackPtr> MEDIA::FromDataBase(const QStringList& urls)
+{
+  const int CHUNK_SIZE = 500;
+
+  QList<MEDIA::TrackPtr> result;
+  for(int i = 0; i < urls.size(); i++)
+    result << MEDIA::TrackPtr(0);
+
+  Database db;
+  if (urls.isEmpty() || !db.connect())
+    return result;
+
+  /* canonical filename -> indexes in urls */
+  QMultiHash<QString, int> rows;
+  QStringList              fnames;
+
+  for(int i = 0; i < urls.size(); i++)
+  {
+    const QString canonical = QFileInfo(urls.at(i)).canonicalFilePath();
+    if(canonical.isEmpty())
+      continue;
+
+    if(!rows.contains(canonical)) {
+      QSqlField data("col",QVariant::String);
+      data.setValue(canonical);
+      fnames << db.sqlDb()->driver()->formatValue(data,false);
+    }
+    rows.insert(canonical, i);
+  }
+
+  for(int chunk = 0; chunk < fnames.size(); chunk += CHUNK_SIZE)
+  {
+    const QStringList values = fnames.mid(chunk, CHUNK_SIZE);
+
+    QSqlQuery tracksQuery(TRACK_SELECT + "WHERE filename IN ("+values.join(",")+");",*db.sqlDb());
+
+    while (tracksQuery.next())
+    {
+      const QString fname = tracksQuery.value(1).toString();
+
+      foreach(int i, rows.values(fname))
+      {
+        if(!result.at(i).isNull())
+          continue;
+
+        result[i] = trackFromQuery(tracksQuery, urls.at(i));
+      }
+    }
+  }
+
+  return result;
+}
+
 /*******************************************************************************
     MEDIA::coverName
 *******************************************************************************/
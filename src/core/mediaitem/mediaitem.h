@@ -243,6 +243,7 @@ Q_DECLARE_METATYPE( MEDIA::LinkPtr )
 Q_DECLARE_METATYPE( MEDIA::ArtistPtr )
 Q_DECLARE_METATYPE( MEDIA::AlbumPtr )
 Q_DECLARE_METATYPE( MEDIA::TrackPtr )
+Q_DECLARE_METATYPE( QList<MEDIA::TrackPtr> )
 Q_DECLARE_METATYPE( MEDIA::PlaylistPtr )
 
 
@@ -284,6 +285,7 @@ namespace MEDIA {
   TrackPtr FromLocalFile(const QString url, int* p_disc=0);
   TrackPtr FromDataBase(const QString url);
   TrackPtr FromDataBase(int trackId);
+  QList<TrackPtr> FromDataBase(const QStringList& urls);
 
   //! ------ cover utilities ---------------------------------------------------
   QString coverName(const QString& artist, const QString& album);
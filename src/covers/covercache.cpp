@@ -20,12 +20,86 @@
 #include "utilities.h"
 #include "debug.h"
 
-#include <QFile>
 #include <QPixmap>
 #include <QPainter>
+#include <QRunnable>
+#include <QThread>
+#include <QStringList>
 
 static const QString noCoverKey  = QString(":/images/emptycoverblue110x110.png");
 static const QString urlCoverKey = QString(":/images/media-url-110x110.png");
+
+/* memory budget for decoded covers */
+static const int COVER_CACHE_BUDGET = 32 * 1024; /* KB */
+
+/* memory budget for shadowed cover composites */
+static const int SHADOW_CACHE_BUDGET = 16 * 1024; /* KB */
+
+/* delay used to coalesce repaint requests */
+static const int LOADED_NOTIFY_DELAY = 40; /* ms */
+
+/* thread pool priorities */
+static const int PRIORITY_VISIBLE  = 1;
+static const int PRIORITY_PREFETCH = 0;
+
+static int pixmapCost(const QPixmap& pixmap)
+{
+    return qMax(1, pixmap.width() * pixmap.height() * pixmap.depth() / 8 / 1024);
+}
+
+static QString coverKey(const QString& name, int size)
+{
+    return name + "@" + QString::number(size);
+}
+
+static QString embeddedCoverKey(const QString& url, int size)
+{
+    return QString("tag:") + coverKey(url, size);
+}
+
+/*
+********************************************************************************
+*                                                                              *
+*    Class CoverLoader                                                         *
+*      -> decode one cover image in thread pool                                *
+*                                                                              *
+********************************************************************************
+*/
+class CoverLoader : public QRunnable
+{
+  public:
+    CoverLoader(const QString& key, const QString& source, int size, bool fromTags)
+      : m_key(key), m_source(source), m_size(size), m_from_tags(fromTags) {}
+
+    /* source is a cover name in store, or a track url for embedded cover */
+    static QImage load(const QString& source, int size, bool fromTags)
+    {
+      if(!fromTags)
+        return CoverStore::instance()->image(source, size);
+
+      QImage image = QImage::fromData( MEDIA::LoadCoverByteArrayFromFile(source) );
+      if(!image.isNull() && image.size() != QSize(size,size))
+        image = image.scaled(QSize(size,size), Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+      return image;
+    }
+
+    void run()
+    {
+      const QImage image = load(m_source, m_size, m_from_tags);
+
+      /* QPixmap is created in gui thread */
+      QMetaObject::invokeMethod(CoverCache::instance(), "slot_image_loaded", Qt::QueuedConnection,
+                                Q_ARG(QString, m_key), Q_ARG(QImage, image));
+    }
+
+  private:
+    QString  m_key;
+    QString  m_source;
+    int      m_size;
+    bool     m_from_tags;
+};
+
 /*
 ********************************************************************************
 *                                                                              *
@@ -40,46 +114,162 @@ CoverCache* CoverCache::instance()
     return INSTANCE;
 }
 
-CoverCache::CoverCache()
+CoverCache::CoverCache(QObject* parent) : QObject(parent)
 {
     INSTANCE = this;
+
+    m_cache.setMaxCost( COVER_CACHE_BUDGET );
+    m_shadow_cache.setMaxCost( SHADOW_CACHE_BUDGET );
+    m_pool.setMaxThreadCount( qBound(2, QThread::idealThreadCount(), 4) );
+
+    m_loaded_timer.setSingleShot(true);
+    m_loaded_timer.setInterval(LOADED_NOTIFY_DELAY);
+    connect(&m_loaded_timer, SIGNAL(timeout()), this, SIGNAL(coversLoaded()));
 }
 
 CoverCache::~CoverCache()
 {
+    m_pool.waitForDone();
+}
+
+/*******************************************************************************
+    cache helpers
+*******************************************************************************/
+QPixmap CoverCache::find(const QString& key, bool* found)
+{
+    QPixmap* pixmap = m_cache.object(key);
+    *found = (pixmap != 0);
+
+    return pixmap ? *pixmap : QPixmap();
 }
 
-QPixmap CoverCache::cover( const MEDIA::AlbumPtr album )
+QPixmap CoverCache::insert(const QString& key, const QImage& image)
+{
+    if(image.isNull()) {
+      m_missing.insert(key);
+      return QPixmap();
+    }
+
+    QPixmap pixmap = QPixmap::fromImage( image );
+    m_cache.insert(key, new QPixmap(pixmap), pixmapCost(pixmap));
+
+    return pixmap;
+}
+
+bool CoverCache::findShadowed(const QString& key, QPixmap* pixmap)
+{
+    QPixmap* shadowed = m_shadow_cache.object(key);
+    if(!shadowed)
+      return false;
+
+    *pixmap = *shadowed;
+    return true;
+}
+
+void CoverCache::insertShadowed(const QString& key, const QPixmap& pixmap)
+{
+    m_shadow_cache.insert(key, new QPixmap(pixmap), pixmapCost(pixmap));
+}
+
+void CoverCache::request(const QString& key, const QString& source, int size, bool fromTags, int priority)
+{
+    if(m_pending.contains(key))
+      return;
+
+    m_pending.insert(key);
+    m_pool.start(new CoverLoader(key, source, size, fromTags), priority);
+}
+
+void CoverCache::slot_image_loaded(const QString& key, const QImage& image)
+{
+    m_pending.remove(key);
+
+    /* cover changed while decoding */
+    if(m_invalidated.remove(key))
+      return;
+
+    insert(key, image);
+
+    if(!image.isNull() && !m_loaded_timer.isActive())
+      m_loaded_timer.start();
+}
+
+QPixmap CoverCache::no_cover_pixmap()
 {
     QPixmap pixmap;
+    if( QPixmapCache::find( noCoverKey, &pixmap ) )
+      return pixmap;
 
-    QPixmapCache::Key key = m_keys.value( album );
+    pixmap = QPixmap(":/images/emptycoverblue110x110.png");
+    QPixmapCache::insert( noCoverKey, pixmap );
+    return pixmap;
+}
 
-    if( key != QPixmapCache::Key() && QPixmapCache::find( key, &pixmap ) )
+/*******************************************************************************
+    album covers
+*******************************************************************************/
+/* content key is asked once to the store, names without cover are not kept */
+QString CoverCache::content_key(const QString& name)
+{
+    QHash<QString, QString>::const_iterator it = m_content.constFind(name);
+    if(it != m_content.constEnd())
+      return it.value();
+
+    const QString key = CoverStore::instance()->contentKey(name);
+    if(key != name)
+      m_content.insert(name, key);
+
+    return key;
+}
+
+QPixmap CoverCache::cover( const MEDIA::AlbumPtr album, int size )
+{
+    const QString key = coverKey(content_key(album->coverpath), size);
+
+    bool found;
+    QPixmap pixmap = find(key, &found);
+    if(found)
       return pixmap;
 
+    if(m_missing.contains(key))
+      return no_cover_pixmap();
+
     /* no pixmap in cache */
-    QImage image = album->image();
+    pixmap = insert(key, CoverLoader::load(album->coverpath, size, false));
 
-    if(!image.isNull())
-    {
-      pixmap = QPixmap::fromImage( image );
-      m_keys[album] = QPixmapCache::insert( pixmap );
-      return pixmap;
-    }
-    else
-    {
-      if( QPixmapCache::find( noCoverKey, &pixmap ) )
-        return pixmap;
+    return pixmap.isNull() ? no_cover_pixmap() : pixmap;
+}
 
-      pixmap = QPixmap(":/images/emptycoverblue110x110.png");
-      QPixmapCache::insert( noCoverKey, pixmap );
+QPixmap CoverCache::coverAsync( const MEDIA::AlbumPtr album, int size )
+{
+    const QString key = coverKey(content_key(album->coverpath), size);
+
+    bool found;
+    QPixmap pixmap = find(key, &found);
+    if(found)
       return pixmap;
-    }
-    return pixmap;
+
+    if(!m_missing.contains(key))
+      request(key, album->coverpath, size, false, PRIORITY_VISIBLE);
+
+    /* placeholder until decoded */
+    return no_cover_pixmap();
+}
+
+void CoverCache::prefetch( const MEDIA::AlbumPtr album )
+{
+    const QString key = coverKey(content_key(album->coverpath), CoverStore::SIZE_MEDIUM);
+
+    if(m_cache.contains(key) || m_missing.contains(key))
+      return;
+
+    request(key, album->coverpath, CoverStore::SIZE_MEDIUM, false, PRIORITY_PREFETCH);
 }
 
-QPixmap CoverCache::cover(const MEDIA::TrackPtr track )
+/*******************************************************************************
+    track covers
+*******************************************************************************/
+QPixmap CoverCache::cover(const MEDIA::TrackPtr track, int size )
 {
     QPixmap pixmap = QPixmap();
 
@@ -110,16 +300,19 @@ QPixmap CoverCache::cover(const MEDIA::TrackPtr track )
     }
     else if (track->id == -1)
     {
-        QPixmap pixmap = MEDIA::LoadCoverFromFile( track->url, QSize(110,110) );
-        if(!pixmap.isNull())
-          return pixmap;
+        //! embedded cover, read with taglib only once and out of gui thread
+        const QString key = embeddedCoverKey(track->url, size);
 
-        if( QPixmapCache::find( noCoverKey, &pixmap ) )
+        bool found;
+        pixmap = find(key, &found);
+        if(found)
           return pixmap;
 
-        pixmap = QPixmap(":/images/emptycoverblue110x110.png");
-        QPixmapCache::insert( noCoverKey, pixmap );
-        return pixmap;
+        if(!m_missing.contains(key))
+          request(key, track->url, size, true, PRIORITY_VISIBLE);
+
+        /* placeholder until decoded */
+        return no_cover_pixmap();
     }
     else // track exist in collection
     {
@@ -127,28 +320,61 @@ QPixmap CoverCache::cover(const MEDIA::TrackPtr track )
         if(track->parent() &&  track->parent()->type() == TYPE_ALBUM) {
           MEDIA::AlbumPtr album = MEDIA::AlbumPtr::staticCast(track->parent());
           if(album)
-            return cover(album);
+            return cover(album, size);
         }
 
 
-        //! 2: check cover path in /<config fir>/albums/
-        QString path = UTIL::CONFIGDIR + "/albums/" + track->coverName();
-        if( QFile(path).exists() )
-          return QPixmap(path);
-        else
-          return QPixmap(":/images/emptycoverblue110x110.png");
+        //! 2: check cover name in store
+        const QString name = track->coverName();
+        const QString key  = coverKey(content_key(name), size);
+
+        bool found;
+        pixmap = find(key, &found);
+        if(found)
+          return pixmap;
+
+        if(!m_missing.contains(key))
+          pixmap = insert(key, CoverLoader::load(name, size, false));
+
+        return pixmap.isNull() ? no_cover_pixmap() : pixmap;
     }
 
     return pixmap;
 }
 
+void CoverCache::reloadMissing()
+{
+    if(m_missing.isEmpty())
+      return;
+
+    m_missing.clear();
+    m_content.clear();
+
+    if(!m_loaded_timer.isActive())
+      m_loaded_timer.start();
+}
+
 void CoverCache::invalidate( const MEDIA::AlbumPtr album )
 {
-    if( !m_keys.contains( album ) )
-        return;
+    /* content key of the replaced cover, store may already know the new one */
+    QStringList contents = QStringList() << album->coverpath;
+    if(m_content.contains(album->coverpath))
+      contents << m_content.take(album->coverpath);
 
-    QPixmapCache::Key key = m_keys.value( album );
-    QPixmapCache::remove( key );
+    foreach(const QString& content, contents)
+    {
+      foreach(const int size, CoverStore::sizes())
+      {
+        const QString key = coverKey(content, size);
+
+        m_cache.remove(key);
+        m_missing.remove(key);
+
+        /* drop result of a decode started before the change */
+        if(m_pending.remove(key))
+          m_invalidated.insert(key);
+      }
+    }
 }
 
 
@@ -167,6 +393,3 @@ QPixmap CoverCache::get_stream_pixmap(MEDIA::TrackPtr track)
      
      return pixTemp;
 }
-
-
-
@@ -21,26 +21,58 @@
 
 
 #include "core/mediaitem/mediaitem.h"
+#include "covers/coverstore.h"
 
+#include <QObject>
 #include <QPixmap>
 #include <QPixmapCache>
+#include <QImage>
 #include <QHash>
+#include <QCache>
+#include <QSet>
+#include <QThreadPool>
+#include <QTimer>
 /*
 ********************************************************************************
 *                                                                              *
 *    Class CoverCache                                                          *
+*      -> covers are read from CoverStore and kept in a LRU cache with a       *
+*         memory budget, one entry per cover content and size, albums          *
+*         sharing the same image share the same pixmap                         *
+*      -> cover() decodes on cache miss, coverAsync() returns a placeholder    *
+*         and decodes in a thread pool, coversLoaded() is then emitted         *
+*      -> embedded covers of tracks outside collection are always decoded      *
+*         in thread pool, views showing them repaint on coversLoaded()         *
 *                                                                              *
 ********************************************************************************
 */
-class CoverCache
+class CoverCache : public QObject
 {
+Q_OBJECT
 public:
-    CoverCache();
+    CoverCache(QObject* parent = 0);
     static CoverCache* instance();
     void invalidate( const MEDIA::AlbumPtr album );
 
-    QPixmap cover( const MEDIA::AlbumPtr album);
-    QPixmap cover( const MEDIA::TrackPtr track);
+    QPixmap cover( const MEDIA::AlbumPtr album, int size = CoverStore::SIZE_MEDIUM);
+    QPixmap cover( const MEDIA::TrackPtr track, int size = CoverStore::SIZE_MEDIUM);
+
+    QPixmap coverAsync( const MEDIA::AlbumPtr album, int size = CoverStore::SIZE_MEDIUM);
+    void prefetch( const MEDIA::AlbumPtr album);
+
+    /* covers may have been added on disk */
+    void reloadMissing();
+
+    /* covers composed with their drop shadow, key is built from
+       composite style, size and source pixmaps cacheKey */
+    bool findShadowed(const QString& key, QPixmap* pixmap);
+    void insertShadowed(const QString& key, const QPixmap& pixmap);
+
+signals:
+    void coversLoaded();
+
+private slots:
+    void slot_image_loaded(const QString& key, const QImage& image);
 
 private:
     static CoverCache* INSTANCE;
@@ -49,6 +81,24 @@ private:
     /* hash from media Object pointer to QPixmapCache:key internal key */
     QHash< const MEDIA::MediaPtr, QPixmapCache::Key > m_keys;
 
+    /* decoded covers, key is cover content or embedded cover url with size */
+    QCache<QString, QPixmap>  m_cache;
+    QHash<QString, QString>   m_content;
+    QSet<QString>             m_missing;
+    QSet<QString>             m_pending;
+    QSet<QString>             m_invalidated;
+
+    QCache<QString, QPixmap>  m_shadow_cache;
+
+    QThreadPool               m_pool;
+    QTimer                    m_loaded_timer;
+
+    QString content_key(const QString& name);
+    QPixmap find(const QString& key, bool* found);
+    QPixmap insert(const QString& key, const QImage& image);
+    void request(const QString& key, const QString& source, int size, bool fromTags, int priority);
+
+    QPixmap no_cover_pixmap();
     QPixmap get_stream_pixmap(MEDIA::TrackPtr track);
     
     Q_DISABLE_COPY( CoverCache )
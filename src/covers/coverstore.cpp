@@ -0,0 +1,772 @@
+/****************************************************************************************
+*  YAROCK                                                                               *
+*  Copyright (c) 2010-2014 Sebastien amardeilh <sebastien.amardeilh+yarock@gmail.com>   *
+*                                                                                       *
+*  This program is free software; you can redistribute it and/or modify it under        *
+*  the terms of the GNU General Public License as published by the Free Software        *
+*  Foundation; either version 2 of the License, or (at your option) any later           *
+*  version.                                                                             *
+*                                                                                       *
+*  This program is distributed in the hope that it will be useful, but WITHOUT ANY      *
+*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A      *
+*  PARTICULAR PURPOSE. See the GNU General Public License for more details.             *
+*                                                                                       *
+*  You should have received a copy of the GNU General Public License along with         *
+*  this program.  If not, see <http://www.gnu.org/licenses/>.                           *
+*****************************************************************************************/
+
+#include "coverstore.h"
+#include "utilities.h"
+#include "debug.h"
+
+#include <QBuffer>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QMutexLocker>
+#include <QRunnable>
+
+#include <cstring>
+
+/*
+  pack layout
+    header : magic, version
+    record : magic, key, blob count, blob descriptors, blob data
+             (blob data is 4 bytes aligned, a record without blob removes the key)
+
+  keys
+    #<sha1>    : image content, all sizes
+    cover name : one alias blob holding the content key
+                 (first pack version stored the sizes under the cover name)
+*/
+static const quint32 STORE_MAGIC   = 0x59434f56; /* YCOV */
+static const quint32 STORE_VERSION = 1;
+static const quint32 RECORD_MAGIC  = 0x434f5652; /* COVR */
+static const qint64  HEADER_SIZE   = 8;
+
+/* pack is rewritten at startup once it is mostly made of dead records */
+static const qint64  COMPACT_MIN_DEAD = 4 * 1024 * 1024;
+
+static const int     JPEG_QUALITY = 90;
+
+enum BlobFormat {
+  FORMAT_RAW_RGB888 = 0,
+  FORMAT_RAW_ARGB32 = 1,
+  FORMAT_JPEG       = 2,
+  FORMAT_PNG        = 3,
+  FORMAT_ALIAS      = 4
+};
+
+static const QChar CONTENT_PREFIX = QChar('#');
+
+static QString packPath()
+{
+    return UTIL::CONFIGDIR + "/covers.pack";
+}
+
+/* covers were stored as one png file per album before the pack */
+static QString legacyDir()
+{
+    return UTIL::CONFIGDIR + "/albums/";
+}
+
+static QString legacyPath(const QString& name)
+{
+    return legacyDir() + name;
+}
+
+static QString exportPath(const QString& name)
+{
+    return UTIL::CONFIGDIR + "/artwork/" + name;
+}
+
+static qint64 align4(qint64 pos)
+{
+    return (pos + 3) & ~qint64(3);
+}
+
+static int rawBytesPerLine(quint8 format, int width)
+{
+    return width * (format == FORMAT_RAW_ARGB32 ? 4 : 3);
+}
+
+/*
+********************************************************************************
+*                                                                              *
+*    Class LegacyImporter                                                      *
+*      -> one shot migration of legacy album covers                            *
+*                                                                              *
+********************************************************************************
+*/
+class LegacyImporter : public QRunnable
+{
+  public:
+    void run()
+    {
+      CoverStore::instance()->importLegacy();
+    }
+};
+
+/*
+********************************************************************************
+*                                                                              *
+*    Class CoverStore                                                          *
+*                                                                              *
+********************************************************************************
+*/
+CoverStore* CoverStore::INSTANCE = 0;
+
+CoverStore* CoverStore::instance()
+{
+    return INSTANCE;
+}
+
+QList<int> CoverStore::sizes()
+{
+    return QList<int>() << SIZE_SMALL << SIZE_MEDIUM << SIZE_LARGE;
+}
+
+CoverStore::CoverStore()
+{
+    INSTANCE     = this;
+    m_map        = 0;
+    m_map_size   = 0;
+    m_dead_bytes = 0;
+    m_exit       = false;
+
+    open();
+
+    if(QDir(legacyDir()).exists()) {
+      m_pool.setMaxThreadCount(1);
+      m_pool.start(new LegacyImporter());
+    }
+}
+
+CoverStore::~CoverStore()
+{
+    m_exit = true;
+    m_pool.waitForDone();
+
+    if(m_map)
+      m_file.unmap(m_map);
+    m_file.close();
+}
+
+/*******************************************************************************
+    pack file
+*******************************************************************************/
+bool CoverStore::open()
+{
+    m_file.setFileName( packPath() );
+
+    if(!m_file.open(QIODevice::ReadWrite)) {
+      Debug::warning() << "[CoverStore] cannot open" << packPath();
+      return false;
+    }
+
+    if(m_file.size() == 0 || !load_index())
+    {
+      m_file.resize(0);
+      m_index.clear();
+      m_refs.clear();
+      m_dead_bytes = 0;
+
+      QDataStream out(&m_file);
+      out << STORE_MAGIC << STORE_VERSION;
+      m_file.flush();
+    }
+
+    Debug::debug() << "[CoverStore] covers :" << m_index.size() << "pack size :" << m_file.size();
+
+    if(m_dead_bytes > COMPACT_MIN_DEAD && m_dead_bytes > m_file.size() / 2)
+      compact();
+
+    return true;
+}
+
+bool CoverStore::load_index()
+{
+    m_index.clear();
+    m_dead_bytes = 0;
+
+    m_file.seek(0);
+    QDataStream in(&m_file);
+    in.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic = 0, version = 0;
+    in >> magic >> version;
+    if(magic != STORE_MAGIC || version != STORE_VERSION)
+      return false;
+
+    const qint64 file_size = m_file.size();
+    qint64 valid_end = HEADER_SIZE;
+
+    while(valid_end < file_size)
+    {
+      quint32 record_magic = 0;
+      QString name;
+      quint8  count = 0;
+
+      in >> record_magic;
+      if(in.status() != QDataStream::Ok || record_magic != RECORD_MAGIC)
+        break;
+
+      in >> name >> count;
+
+      Entry entry;
+      for(int i = 0; i < count; ++i) {
+        Blob blob;
+        in >> blob.size >> blob.format >> blob.width >> blob.height >> blob.length;
+        entry.blobs << blob;
+      }
+
+      if(in.status() != QDataStream::Ok)
+        break;
+
+      qint64 pos = m_file.pos();
+      for(int i = 0; i < entry.blobs.size(); ++i) {
+        pos = align4(pos);
+        entry.blobs[i].offset = pos;
+        pos += entry.blobs[i].length;
+      }
+
+      if(pos > file_size)
+        break;
+
+      if(entry.blobs.size() == 1 && entry.blobs.at(0).format == FORMAT_ALIAS) {
+        m_file.seek(entry.blobs.at(0).offset);
+        entry.alias = QString::fromUtf8(m_file.read(entry.blobs.at(0).length));
+      }
+
+      if(!m_file.seek(pos))
+        break;
+
+      entry.bytes = pos - valid_end;
+      valid_end   = pos;
+
+      drop_entry(name);
+      if(entry.blobs.isEmpty())
+        m_dead_bytes += entry.bytes;
+      else
+        m_index.insert(name, entry);
+    }
+
+    /* record left incomplete by a crash */
+    if(valid_end < file_size) {
+      Debug::warning() << "[CoverStore] truncate damaged pack at" << valid_end;
+      m_file.resize(valid_end);
+    }
+
+    /* count references, drop dangling aliases and unused contents */
+    m_refs.clear();
+    foreach(const QString& key, m_index.keys()) {
+      const QString alias = m_index.value(key).alias;
+      if(alias.isEmpty())
+        continue;
+
+      if(m_index.contains(alias))
+        m_refs[alias]++;
+      else
+        drop_entry(key);
+    }
+
+    foreach(const QString& key, m_index.keys())
+      if(key.startsWith(CONTENT_PREFIX) && !m_refs.contains(key))
+        drop_entry(key);
+
+    return true;
+}
+
+void CoverStore::compact()
+{
+    Debug::debug() << "[CoverStore] compact pack, dead bytes :" << m_dead_bytes;
+
+    const QString tmp_path = packPath() + ".tmp";
+    QFile::remove(tmp_path);
+
+    QFile out(tmp_path);
+    if(!out.open(QIODevice::WriteOnly))
+      return;
+
+    {
+      QDataStream header(&out);
+      header << STORE_MAGIC << STORE_VERSION;
+    }
+
+    qint64 pos = HEADER_SIZE;
+
+    QHash<QString, Entry>::const_iterator it = m_index.constBegin();
+    for( ; it != m_index.constEnd(); ++it)
+    {
+      const QList<QByteArray> blob_payloads = payloads(it.value().blobs);
+      if(blob_payloads.size() != it.value().blobs.size()) {
+        out.remove();
+        return;
+      }
+
+      const QByteArray record = record_bytes(it.key(), it.value().blobs, blob_payloads, pos, 0);
+      if(out.write(record) != record.size()) {
+        out.remove();
+        return;
+      }
+      pos += record.size();
+    }
+    out.close();
+
+    if(m_map) {
+      m_file.unmap(m_map);
+      m_map      = 0;
+      m_map_size = 0;
+    }
+    m_file.close();
+
+    QFile::remove(packPath());
+    QFile::rename(tmp_path, packPath());
+
+    if(m_file.open(QIODevice::ReadWrite))
+      load_index();
+}
+
+bool CoverStore::map_blob(const Blob& blob)
+{
+    if(blob.offset + blob.length <= m_map_size)
+      return true;
+
+    /* pack has grown since last mapping */
+    if(m_map)
+      m_file.unmap(m_map);
+
+    m_map_size = m_file.size();
+    m_map      = m_file.map(0, m_map_size);
+
+    if(!m_map) {
+      m_map_size = 0;
+      return false;
+    }
+
+    return blob.offset + blob.length <= m_map_size;
+}
+
+/* copy of blobs data, shorter list when pack can not be mapped */
+QList<QByteArray> CoverStore::payloads(const QVector<Blob>& blobs)
+{
+    QList<QByteArray> result;
+    foreach(const Blob& blob, blobs) {
+      if(!map_blob(blob))
+        break;
+      result << QByteArray(reinterpret_cast<const char*>(m_map + blob.offset), blob.length);
+    }
+
+    return result;
+}
+
+/*******************************************************************************
+    records
+*******************************************************************************/
+bool CoverStore::encode(const QImage& source, QVector<Blob>* blobs, QList<QByteArray>* payloads)
+{
+    if(source.isNull())
+      return false;
+
+    foreach(const int size, sizes())
+    {
+      const bool fits = source.width() <= size && source.height() <= size;
+
+      const QImage image = fits ? source :
+          source.scaled(QSize(size, size), Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+      Blob blob;
+      blob.size   = size;
+      blob.width  = image.width();
+      blob.height = image.height();
+      blob.offset = 0;
+
+      QByteArray bytes;
+      if(size == SIZE_MEDIUM)
+      {
+        /* grid size : raw pixels, no decoding on read */
+        blob.format = image.hasAlphaChannel() ? FORMAT_RAW_ARGB32 : FORMAT_RAW_RGB888;
+
+        const QImage raw = image.convertToFormat(blob.format == FORMAT_RAW_ARGB32 ?
+                                                 QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB888);
+        const int bpl = rawBytesPerLine(blob.format, raw.width());
+
+        bytes.resize(bpl * raw.height());
+        for(int y = 0; y < raw.height(); ++y)
+          memcpy(bytes.data() + y * bpl, raw.scanLine(y), bpl);
+      }
+      else
+      {
+        QBuffer buffer(&bytes);
+        buffer.open(QIODevice::WriteOnly);
+
+        if(image.hasAlphaChannel()) {
+          blob.format = FORMAT_PNG;
+          image.save(&buffer, "png");
+        }
+        else {
+          blob.format = FORMAT_JPEG;
+          image.save(&buffer, "jpg", JPEG_QUALITY);
+        }
+      }
+
+      blob.length = bytes.size();
+      blobs->append(blob);
+      payloads->append(bytes);
+
+      /* source too small for larger sizes */
+      if(fits)
+        break;
+    }
+
+    return true;
+}
+
+QString CoverStore::content_key(const QList<QByteArray>& payloads)
+{
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    foreach(const QByteArray& bytes, payloads)
+      hash.addData(bytes);
+
+    return CONTENT_PREFIX + QString(hash.result().toHex());
+}
+
+QByteArray CoverStore::record_bytes(const QString& name, const QVector<Blob>& blobs,
+                                    const QList<QByteArray>& payloads, qint64 start, QVector<Blob>* placed)
+{
+    QByteArray record;
+    {
+      QDataStream out(&record, QIODevice::WriteOnly);
+      out.setVersion(QDataStream::Qt_4_6);
+
+      out << RECORD_MAGIC << name << quint8(blobs.size());
+      foreach(const Blob& blob, blobs)
+        out << blob.size << blob.format << blob.width << blob.height << blob.length;
+    }
+
+    for(int i = 0; i < blobs.size(); ++i)
+    {
+      const qint64 pos = align4(start + record.size());
+      record.append(QByteArray(pos - start - record.size(), '\0'));
+      record.append(payloads.at(i));
+
+      if(placed) {
+        placed->append(blobs.at(i));
+        placed->last().offset = pos;
+      }
+    }
+
+    return record;
+}
+
+bool CoverStore::write_record(const QString& name, const QVector<Blob>& blobs, const QList<QByteArray>& payloads)
+{
+    if(!m_file.isOpen())
+      return false;
+
+    const qint64 start = m_file.size();
+
+    Entry entry;
+    const QByteArray record = record_bytes(name, blobs, payloads, start, &entry.blobs);
+    entry.bytes = record.size();
+
+    if(blobs.size() == 1 && blobs.at(0).format == FORMAT_ALIAS)
+      entry.alias = QString::fromUtf8(payloads.at(0));
+
+    if(!m_file.seek(start) || m_file.write(record) != record.size() || !m_file.flush())
+    {
+      Debug::warning() << "[CoverStore] error writing cover" << name;
+      m_file.resize(start);
+      return false;
+    }
+
+    const QString old_alias = m_index.value(name).alias;
+
+    drop_entry(name);
+    if(entry.blobs.isEmpty())
+      m_dead_bytes += entry.bytes;
+    else
+      m_index.insert(name, entry);
+
+    /* take new reference before releasing the old one, may be the same */
+    if(!entry.alias.isEmpty())
+      m_refs[entry.alias]++;
+    if(!old_alias.isEmpty())
+      unref(old_alias);
+
+    return true;
+}
+
+bool CoverStore::write_alias(const QString& name, const QString& key)
+{
+    const QByteArray bytes = key.toUtf8();
+
+    Blob blob;
+    blob.size   = 0;
+    blob.format = FORMAT_ALIAS;
+    blob.width  = 0;
+    blob.height = 0;
+    blob.length = bytes.size();
+    blob.offset = 0;
+
+    return write_record(name, QVector<Blob>() << blob, QList<QByteArray>() << bytes);
+}
+
+/* content is written only when no other cover uses the same image */
+bool CoverStore::write_cover(const QString& name, const QVector<Blob>& blobs, const QList<QByteArray>& payloads)
+{
+    const QString key = content_key(payloads);
+
+    if(!m_index.contains(key) && !write_record(key, blobs, payloads))
+      return false;
+
+    return write_alias(name, key);
+}
+
+void CoverStore::drop_entry(const QString& name)
+{
+    if(m_index.contains(name))
+      m_dead_bytes += m_index.take(name).bytes;
+}
+
+/* content without cover name is dead, compaction will reclaim it */
+void CoverStore::unref(const QString& key)
+{
+    if(--m_refs[key] > 0)
+      return;
+
+    m_refs.remove(key);
+    drop_entry(key);
+}
+
+bool CoverStore::has_cover(const QString& name) const
+{
+    return !name.startsWith(CONTENT_PREFIX) && m_index.contains(name);
+}
+
+QString CoverStore::resolve(const QString& name) const
+{
+    const QString alias = m_index.value(name).alias;
+    return alias.isEmpty() ? name : alias;
+}
+
+/* raw sizes are copied to image, compressed sizes to bytes (lock held) */
+bool CoverStore::read_blob(const QString& name, int size, QImage* image, QByteArray* bytes)
+{
+    const QVector<Blob> blobs = m_index.value(resolve(name)).blobs;
+    if(blobs.isEmpty())
+      return false;
+
+    /* exact size, else smallest larger size, else largest one (blobs are sorted) */
+    int best = -1;
+    for(int i = 0; i < blobs.size(); ++i)
+      if(blobs.at(i).size >= size && (best == -1 || blobs.at(i).size < blobs.at(best).size))
+        best = i;
+
+    if(best == -1)
+      best = blobs.size() - 1;
+
+    const Blob& blob = blobs.at(best);
+    if(!map_blob(blob))
+      return false;
+
+    const uchar* data = m_map + blob.offset;
+
+    if(blob.format == FORMAT_RAW_RGB888 || blob.format == FORMAT_RAW_ARGB32)
+    {
+      const int bpl = rawBytesPerLine(blob.format, blob.width);
+      if(quint32(bpl * blob.height) != blob.length)
+        return false;
+
+      *image = QImage(blob.width, blob.height, blob.format == FORMAT_RAW_ARGB32 ?
+                      QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB888);
+
+      for(int y = 0; y < blob.height; ++y)
+        memcpy(image->scanLine(y), data + y * bpl, bpl);
+    }
+    else
+    {
+      *bytes = QByteArray(reinterpret_cast<const char*>(data), blob.length);
+    }
+
+    return true;
+}
+
+/* true when cover is in pack, legacy file is encoded outside the lock
+   (caller must not hold it) */
+bool CoverStore::import_legacy(const QString& name)
+{
+    {
+      QMutexLocker locker(&m_mutex);
+      if(has_cover(name))
+        return true;
+    }
+
+    if(name.isEmpty() || !QFile::exists(legacyPath(name)))
+      return false;
+
+    QVector<Blob>     blobs;
+    QList<QByteArray> payloads;
+    if(!encode(QImage(legacyPath(name)), &blobs, &payloads))
+      return false;
+
+    QMutexLocker locker(&m_mutex);
+
+    /* stored or imported meanwhile */
+    if(has_cover(name))
+      return true;
+
+    return write_cover(name, blobs, payloads);
+}
+
+void CoverStore::remove_export(const QString& name)
+{
+    QFile::remove(exportPath(name));
+}
+
+/*******************************************************************************
+    public api
+*******************************************************************************/
+/* legacy covers are only checked, import is left to background job */
+bool CoverStore::contains(const QString& name)
+{
+    {
+      QMutexLocker locker(&m_mutex);
+      if(has_cover(name))
+        return true;
+    }
+
+    return !name.isEmpty() && QFile::exists(legacyPath(name));
+}
+
+QString CoverStore::contentKey(const QString& name)
+{
+    QMutexLocker locker(&m_mutex);
+
+    return has_cover(name) ? resolve(name) : name;
+}
+
+QImage CoverStore::image(const QString& name, int size)
+{
+    QImage     image;
+    QByteArray bytes;
+    bool       legacy;
+    {
+      QMutexLocker locker(&m_mutex);
+
+      legacy = !has_cover(name);
+      if(!legacy && !read_blob(name, size, &image, &bytes))
+        return QImage();
+    }
+
+    /* not imported yet : legacy file is read as is */
+    if(legacy && !name.isEmpty() && QFile::exists(legacyPath(name)))
+      image = QImage(legacyPath(name));
+
+    /* compressed sizes are decoded outside the lock */
+    if(!bytes.isEmpty())
+      image = QImage::fromData(bytes);
+
+    if(!image.isNull() && (image.width() > size || image.height() > size))
+      image = image.scaled(QSize(size, size), Qt::KeepAspectRatio, Qt::SmoothTransformation);
+
+    return image;
+}
+
+bool CoverStore::store(const QString& name, const QImage& source)
+{
+    if(name.isEmpty())
+      return false;
+
+    /* scaling and encoding outside the lock */
+    QVector<Blob>     blobs;
+    QList<QByteArray> payloads;
+    if(!encode(source, &blobs, &payloads))
+      return false;
+
+    QMutexLocker locker(&m_mutex);
+    remove_export(name);
+
+    return write_cover(name, blobs, payloads);
+}
+
+void CoverStore::remove(const QString& name)
+{
+    QMutexLocker locker(&m_mutex);
+
+    QFile::remove(legacyPath(name));
+    remove_export(name);
+
+    if(has_cover(name))
+      write_record(name, QVector<Blob>(), QList<QByteArray>());
+}
+
+bool CoverStore::rename(const QString& from, const QString& to)
+{
+    if(from == to)
+      return true;
+
+    /* legacy cover is moved into the pack first */
+    if(!import_legacy(from))
+      return false;
+
+    QMutexLocker locker(&m_mutex);
+
+    if(!has_cover(from))
+      return false;
+
+    const QString key = resolve(from);
+
+    if(key != from)
+    {
+      /* only the alias moves */
+      if(!write_alias(to, key))
+        return false;
+    }
+    else
+    {
+      /* cover written by first pack version, content is shared from now */
+      const QVector<Blob> blobs = m_index.value(from).blobs;
+      const QList<QByteArray> blob_payloads = payloads(blobs);
+
+      if(blob_payloads.size() != blobs.size() || !write_cover(to, blobs, blob_payloads))
+        return false;
+    }
+
+    write_record(from, QVector<Blob>(), QList<QByteArray>());
+
+    QFile::remove(legacyPath(from));
+    remove_export(from);
+    remove_export(to);
+
+    return true;
+}
+
+void CoverStore::importLegacy()
+{
+    const QStringList names = QDir(legacyDir()).entryList(QDir::Files);
+    Debug::debug() << "[CoverStore] import legacy covers :" << names.size();
+
+    foreach(const QString& name, names)
+    {
+      if(m_exit)
+        break;
+
+      import_legacy(name);
+    }
+}
+
+QString CoverStore::exportFile(const QString& name)
+{
+    const QString path = exportPath(name);
+    if(QFile::exists(path))
+      return path;
+
+    const QImage cover = image(name, SIZE_LARGE);
+    if(cover.isNull())
+      return QString();
+
+    QDir().mkpath(UTIL::CONFIGDIR + "/artwork");
+
+    return cover.save(path, "png") ? path : QString();
+}
@@ -0,0 +1,126 @@
+/****************************************************************************************
+*  YAROCK                                                                               *
+*  Copyright (c) 2010-2014 Sebastien amardeilh <sebastien.amardeilh+yarock@gmail.com>   *
+*                                                                                       *
+*  This program is free software; you can redistribute it and/or modify it under        *
+*  the terms of the GNU General Public License as published by the Free Software        *
+*  Foundation; either version 2 of the License, or (at your option) any later           *
+*  version.                                                                             *
+*                                                                                       *
+*  This program is distributed in the hope that it will be useful, but WITHOUT ANY      *
+*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A      *
+*  PARTICULAR PURPOSE. See the GNU General Public License for more details.             *
+*                                                                                       *
+*  You should have received a copy of the GNU General Public License along with         *
+*  this program.  If not, see <http://www.gnu.org/licenses/>.                           *
+*****************************************************************************************/
+
+#ifndef _COVER_STORE_H_
+#define _COVER_STORE_H_
+
+#include <QString>
+#include <QImage>
+#include <QFile>
+#include <QHash>
+#include <QVector>
+#include <QList>
+#include <QMutex>
+#include <QThreadPool>
+
+/*
+********************************************************************************
+*                                                                              *
+*    Class CoverStore                                                          *
+*      -> all album covers packed in a single file, keyed by cover name        *
+*      -> each cover holds several pre-scaled sizes, the grid size is kept     *
+*         as raw pixels, other sizes as jpeg (png when alpha)                  *
+*      -> images are stored once by content hash, cover names are aliases      *
+*         counted as references on the content                                 *
+*      -> the pack is append only and memory mapped for reading                *
+*      -> covers of the legacy album directory are moved into the pack by a    *
+*         background job started at creation                                   *
+*                                                                              *
+********************************************************************************
+*/
+class CoverStore
+{
+  public:
+    enum Size { SIZE_SMALL = 80, SIZE_MEDIUM = 110, SIZE_LARGE = 200 };
+
+    CoverStore();
+    ~CoverStore();
+    static CoverStore* instance();
+    static QList<int> sizes();
+
+    bool    contains(const QString& name);
+    QImage  image(const QString& name, int size = SIZE_MEDIUM);
+
+    /* same key for covers sharing the same image */
+    QString contentKey(const QString& name);
+
+    bool    store(const QString& name, const QImage& source);
+    void    remove(const QString& name);
+    bool    rename(const QString& from, const QString& to);
+
+    /* plain image file for external consumers (mpris) */
+    QString exportFile(const QString& name);
+
+    /* move all legacy album covers into the pack (runs in background) */
+    void importLegacy();
+
+  private:
+    struct Blob {
+      quint16  size;
+      quint8   format;
+      quint16  width;
+      quint16  height;
+      quint32  length;
+      qint64   offset;
+    };
+
+    struct Entry {
+      QVector<Blob>  blobs;
+      qint64         bytes;
+      QString        alias;   /* content key for cover name entries */
+    };
+
+    static CoverStore* INSTANCE;
+
+    QFile                  m_file;
+    uchar*                 m_map;
+    qint64                 m_map_size;
+    QHash<QString, Entry>  m_index;
+    QHash<QString, int>    m_refs;
+    qint64                 m_dead_bytes;
+    QMutex                 m_mutex;
+    QThreadPool            m_pool;
+    bool                   m_exit;
+
+    bool open();
+    bool load_index();
+    void compact();
+    bool map_blob(const Blob& blob);
+
+    static bool encode(const QImage& source, QVector<Blob>* blobs, QList<QByteArray>* payloads);
+    static QString content_key(const QList<QByteArray>& payloads);
+    static QByteArray record_bytes(const QString& name, const QVector<Blob>& blobs,
+                                   const QList<QByteArray>& payloads, qint64 start, QVector<Blob>* placed);
+
+    bool write_record(const QString& name, const QVector<Blob>& blobs, const QList<QByteArray>& payloads);
+    bool write_alias(const QString& name, const QString& key);
+    bool write_cover(const QString& name, const QVector<Blob>& blobs, const QList<QByteArray>& payloads);
+    void drop_entry(const QString& name);
+    void unref(const QString& key);
+
+    bool    has_cover(const QString& name) const;
+    QString resolve(const QString& name) const;
+    QList<QByteArray> payloads(const QVector<Blob>& blobs);
+    bool read_blob(const QString& name, int size, QImage* image, QByteArray* bytes);
+
+    bool import_legacy(const QString& name);
+    void remove_export(const QString& name);
+
+    Q_DISABLE_COPY( CoverStore )
+};
+
+#endif // _COVER_STORE_H_
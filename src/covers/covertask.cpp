@@ -15,6 +15,7 @@
 *  this program.  If not, see <http://www.gnu.org/licenses/>.                           *
 *****************************************************************************************/
 #include "covertask.h"
+#include "coverstore.h"
 
 #include "info_system.h"
 
@@ -26,9 +27,28 @@
 #include <QSqlQuery>
 #include <QVariant>
 
+#include <QDataStream>
 #include <QFile>
 #include <QImage>
 
+/* requests in flight */
+static const int DEFAULT_PARALLEL_REQUESTS = 4;
+
+/* InfoSystem does not answer when no cover is found */
+static const int REQUEST_TIMEOUT   = 10000; /* ms */
+static const int TIMER_INTERVAL    = 500;   /* ms */
+
+/* first retry delay, doubled for each attempt */
+static const int MAX_ATTEMPTS      = 3;
+static const int RETRY_BACKOFF     = 5000;  /* ms */
+
+/* albums without cover are not searched again before */
+static const int MISSING_EXPIRY    = 30;    /* days */
+
+static QString missingCachePath()
+{
+    return UTIL::CONFIGDIR + "/covers_missing.dat";
+}
 
 /*
 ********************************************************************************
@@ -46,21 +66,28 @@ CoverTask::CoverTask(QObject *parent) : QObject(parent)
     m_isFullDbSearch      = true;
     m_exit                = false;
     m_isRunning           = false;
+    m_parallel            = DEFAULT_PARALLEL_REQUESTS;
+    m_max                 = 0;
+    m_done                = 0;
+    m_missing_changed     = false;
     
-    m_timeout.setInterval( 10000 );
-    m_timeout.setSingleShot( false );
-    connect( &m_timeout, SIGNAL( timeout() ), SLOT( slot_request_timeout() ) );    
+    m_timer.setInterval( TIMER_INTERVAL );
+    m_timer.setSingleShot( false );
+    connect( &m_timer, SIGNAL( timeout() ), SLOT( slot_check_timeouts() ) );
+
+    load_missing();
 }
 
 CoverTask::~CoverTask()
 {
+    save_missing();
 }
 
 
 //! -- CoverTask::setRequest -------------------------------------------------
 void CoverTask::setRequest(const QString& artist, const QString& album)
 {
-    m_requests.clear();
+    m_queue.clear();
     
     INFO::InfoRequestData request;
 
@@ -74,10 +101,9 @@ void CoverTask::setRequest(const QString& artist, const QString& album)
 
     request.data = QVariant::fromValue< INFO::InfoStringHash >( hash );
     
-    const QString path = UTIL::CONFIGDIR + "/albums/" + hash["covername"];
-
-    if(!QFile::exists(path))
-      m_requests.insert(request.requestId, request);
+    /* explicit request, missing cache is not checked */
+    if(!CoverStore::instance()->contains( hash["covername"] ))
+      enqueue(request);
 
     m_isFullDbSearch = false;
 }
@@ -87,112 +113,190 @@ void CoverTask::setRequest(const QString& artist, const QString& album)
 void CoverTask::start()
 {
     Debug::debug() << Q_FUNC_INFO;
+    m_exit = false;
+
     if(m_isFullDbSearch)
       slot_check_database();
     /*else
       -> take request as parameter  */
 
     m_isRunning = true;
-    m_max = m_requests.size();
+    m_max       = m_queue.size();
+    m_done      = 0;
+
+    connect( InfoSystem::instance(),
+             SIGNAL( info( INFO::InfoRequestData, QVariant ) ),
+             SLOT( slot_system_info( INFO::InfoRequestData, QVariant ) ),  Qt::UniqueConnection );
+
+    m_timer.start();
 
     slot_process_cover_search();
+}
 
-    //! Start thread event loop --> makes signals and slots work
-    QEventLoop eventLoop;
-    eventLoop.exec();
-    
-    m_isFullDbSearch      = true;
-    m_requests.clear();
+void CoverTask::setExit(bool b)
+{
+    m_exit = b;
+
+    if(m_exit && m_isRunning)
+      slot_finish_cover_search();
 }
 
 //! -- slot_finish_cover_search ------------------------------------------------
 void CoverTask::slot_finish_cover_search()
 {
     Debug::debug() << Q_FUNC_INFO;
-    m_timeout.stop();
+    if(!m_isRunning)
+      return;
+
+    m_timer.stop();
+    disconnect( InfoSystem::instance(), 0, this, 0 );
+
+    m_queue.clear();
+    m_running.clear();
+    save_missing();
+
     m_isRunning       = false;
     m_isFullDbSearch  = true;
     emit finished();
 }
 
 
-void CoverTask::slot_request_timeout()
+//! -- jobs --------------------------------------------------------------------
+void CoverTask::enqueue(const INFO::InfoRequestData& request)
 {
-    if(!m_requests.isEmpty())
-      m_requests.take(m_requests.keys().first());
-    
-    slot_process_cover_search();
+    Job job;
+    job.request    = request;
+    job.attempts   = 0;
+    job.not_before = 0;
+    job.started    = 0;
+
+    m_queue.append(job);
+}
+
+bool CoverTask::take_job(quint64 id, Job* job)
+{
+    if(m_running.contains(id)) {
+      *job = m_running.take(id);
+      return true;
+    }
+
+    /* late answer for a request waiting for retry */
+    for(int i = 0; i < m_queue.size(); ++i) {
+      if(m_queue.at(i).request.requestId == id) {
+        *job = m_queue.takeAt(i);
+        return true;
+      }
+    }
+
+    return false;
+}
+
+void CoverTask::retry_or_give_up(Job job)
+{
+    if(job.attempts < MAX_ATTEMPTS)
+    {
+      job.not_before = QDateTime::currentMSecsSinceEpoch() + (qint64(RETRY_BACKOFF) << (job.attempts - 1));
+      m_queue.append(job);
+      return;
+    }
+
+    const QString covername = job.request.data.value< INFO::InfoStringHash >().value("covername");
+    Debug::debug() << "       [CoverTask] no cover found for" << covername;
+
+    m_missing.insert(covername, QDateTime::currentDateTime());
+    m_missing_changed = true;
+
+    job_done();
+}
+
+void CoverTask::job_done()
+{
+    m_done++;
+
+    if(m_max > 0)
+      emit progress ( qMin(m_done, m_max) * 100 / m_max );
 }
 
 
 //! -- slot_process_cover_search -----------------------------------------------
 void CoverTask::slot_process_cover_search()
 {
-    Debug::debug() << Q_FUNC_INFO << " request size:" << m_requests.size();
+    if(!m_isRunning)
+      return;
+
+    if(m_exit || (m_queue.isEmpty() && m_running.isEmpty())) {
+      slot_finish_cover_search();
+      return;
+    }
+
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
 
-    if(!m_requests.isEmpty() && !m_exit) 
+    for(int i = 0; i < m_queue.size() && m_running.size() < m_parallel; )
     {
-      emit progress ( ((m_max - m_requests.values().size())*100)/m_max );
-      
-      INFO::InfoRequestData request = m_requests.value(m_requests.keys().first());
-    
-      connect( InfoSystem::instance(),
-             SIGNAL( info( INFO::InfoRequestData, QVariant ) ),
-             SLOT( slot_system_info( INFO::InfoRequestData, QVariant ) ),  Qt::UniqueConnection );
+      if(m_queue.at(i).not_before > now) {
+        ++i;
+        continue;
+      }
+
+      Job job = m_queue.takeAt(i);
+      job.attempts++;
+      job.started = now;
+      m_running.insert(job.request.requestId, job);
 
-      InfoSystem::instance()->getInfo( request );
-      
-      /* timer is needed as we dont have info signal from InfoSystem each time */
-      m_timeout.start();
+      InfoSystem::instance()->getInfo( job.request );
     }
-    else 
+}
+
+void CoverTask::slot_check_timeouts()
+{
+    const qint64 now = QDateTime::currentMSecsSinceEpoch();
+
+    foreach(const quint64 id, m_running.keys())
     {
-       m_timeout.stop();
-       slot_finish_cover_search();
+      if(now - m_running.value(id).started > REQUEST_TIMEOUT)
+        retry_or_give_up( m_running.take(id) );
     }
+
+    slot_process_cover_search();
 }
 
 void CoverTask::slot_system_info( INFO::InfoRequestData request, QVariant output)
 {
-    m_timeout.stop();
-    Debug::debug() << Q_FUNC_INFO << "get info for request.id " << request.requestId;
- 
-    if(!m_requests.contains(request.requestId)) {
-      slot_process_cover_search();
+    if(request.type != INFO::InfoAlbumCoverArt || output.isNull())
       return;
-    }
 
-    m_requests.take(request.requestId);
+    /* several services may answer, first valid cover wins */
+    const bool running = m_running.contains(request.requestId);
 
-    if(output.isNull()) {
-      slot_process_cover_search();
+    Job job;
+    if(!take_job(request.requestId, &job))
       return;
-    }
-    
+
+    Debug::debug() << Q_FUNC_INFO << "get info for request.id " << request.requestId;
+
     /* get request info */
     INFO::InfoStringHash hash = request.data.value< INFO::InfoStringHash >();
    
-    /* filepath for cover file */
-    const QString filePath = UTIL::CONFIGDIR + "/albums/" + hash["covername"];
-
-    QFile file(filePath);
-    if(file.exists())
+    if(CoverStore::instance()->contains( hash["covername"] ))
     {
-      Debug::debug() << "       [CoverTask] file exists, start next cover search";
+      Debug::debug() << "       [CoverTask] cover exists, start next cover search";
     }
-    else if (!file.open(QIODevice::WriteOnly))
+    else if (!CoverStore::instance()->store(hash["covername"], QImage::fromData(output.toByteArray())))
     {
       Debug::debug() << "       [CoverTask] error writing album image";
-    }
-    else
-    {
-      const QByteArray bytes = output.toByteArray();
 
-      QImage image = QImage::fromData(bytes);
-      image = image.scaled(QSize(110, 110), Qt::KeepAspectRatio, Qt::SmoothTransformation);
-      image.save(filePath, "png", -1);
+      /* another service or attempt may still answer */
+      if(running)
+        m_running.insert(job.request.requestId, job);
+      else
+        m_queue.append(job);
+      return;
     }
-    
+
+    if(m_missing.remove(hash["covername"]))
+      m_missing_changed = true;
+
+    job_done();
     slot_process_cover_search();
 }
 
@@ -205,17 +309,22 @@ void CoverTask::slot_check_database()
     Database db;
     if (!db.connect())  return;
 
-    m_requests.clear();
+    m_queue.clear();
+
+    const QDateTime expiry = QDateTime::currentDateTime().addDays( -MISSING_EXPIRY );
     
     //! albums database loop
     QSqlQuery query("SELECT name,cover,artist_name FROM view_albums",*db.sqlDb());
     
     while (query.next())
     {
-        
-        const QString path = UTIL::CONFIGDIR + "/albums/" + query.value(1).toString();
+        const QString covername = query.value(1).toString();
+
+        /* searched recently without result */
+        if(m_missing.contains(covername) && m_missing.value(covername) > expiry)
+          continue;
 
-        if(!QFile::exists(path)) 
+        if(!CoverStore::instance()->contains( covername ))
         {
           INFO::InfoRequestData request;
           request.requestId = INFO::infosystemRequestId();
@@ -224,13 +333,43 @@ void CoverTask::slot_check_database()
           INFO::InfoStringHash hash;
           hash["artist"] = query.value(2).toString();
           hash["album"]  = query.value(0).toString();
-          hash["covername"]  = query.value(1).toString();
+          hash["covername"]  = covername;
 
           request.data = QVariant::fromValue< INFO::InfoStringHash >( hash );
 
-          m_requests.insert(request.requestId, request);
+          enqueue(request);
         }
     } // fin while album query
 }
 
 
+//! -- missing covers cache ----------------------------------------------------
+void CoverTask::load_missing()
+{
+    QFile file(missingCachePath());
+    if(!file.open(QIODevice::ReadOnly))
+      return;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_4_6);
+    in >> m_missing;
+
+    if(in.status() != QDataStream::Ok)
+      m_missing.clear();
+}
+
+void CoverTask::save_missing()
+{
+    if(!m_missing_changed)
+      return;
+
+    QFile file(missingCachePath());
+    if(!file.open(QIODevice::WriteOnly))
+      return;
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << m_missing;
+
+    m_missing_changed = false;
+}
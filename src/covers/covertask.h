@@ -22,13 +22,18 @@
 #include <QStringList>
 #include <QObject>
 #include <QByteArray>
-#include <QMap>
+#include <QList>
+#include <QHash>
+#include <QDateTime>
 #include <QTimer>
 
 /*
 ********************************************************************************
 *                                                                              *
 *    Class CoverTask                                                           *
+*      -> several cover requests are kept in flight, requests without          *
+*         answer are retried with backoff then remembered as missing           *
+*      -> per host rate limits are applied by NetworkAccess                    *
 *                                                                              *
 ********************************************************************************
 */
@@ -38,29 +43,52 @@ Q_OBJECT
  public:
     explicit CoverTask(QObject *parent = 0);
     ~CoverTask();
-    void setExit(bool b) {m_exit = b;}
+    void setExit(bool b);
     void setRequest(const QString& artist, const QString& album);
+    void setParallelRequests(int count) {m_parallel = qMax(1, count);}
 
     bool isRunning() {return m_isRunning;};
     void start();
 
   private slots:
     void slot_check_database();
-    void slot_request_timeout();
+    void slot_check_timeouts();
     void slot_finish_cover_search();
     void slot_process_cover_search();
     void slot_system_info( INFO::InfoRequestData, QVariant );
     
   private:
-    bool                   m_isRunning;
-    QMap<quint64, INFO::InfoRequestData> m_requests;
-    QTimer                 m_timeout;
+    struct Job {
+      INFO::InfoRequestData  request;
+      int                    attempts;
+      qint64                 not_before;  /* ms since epoch, retry delay */
+      qint64                 started;     /* ms since epoch */
+    };
+
+    QList<Job>             m_queue;
+    QHash<quint64, Job>    m_running;
+    QTimer                 m_timer;
     
+    /* cover name -> last failed search */
+    QHash<QString, QDateTime> m_missing;
+    bool                   m_missing_changed;
+
+    int                    m_parallel;
     int                    m_max;
+    int                    m_done;
     bool                   m_exit;
+    bool                   m_isRunning;
 
     //! perform search on all missing cover or on specific request
     bool                   m_isFullDbSearch;
+
+    void enqueue(const INFO::InfoRequestData& request);
+    bool take_job(quint64 id, Job* job);
+    void retry_or_give_up(Job job);
+    void job_done();
+
+    void load_missing();
+    void save_missing();
     
   signals:
     void finished();
@@ -22,6 +22,7 @@
 #include "core/player/engine_base.h"
 #include "widgets/audiocontrols.h"
 #include "global_actions.h"
+#include "covers/coverstore.h"
 #include "utilities.h"
 #include "constants.h"
 #include "debug.h"
@@ -252,11 +253,11 @@ QVariantMap Mpris2::metadata() const
         metadataMap.insert( "xesam:genre",  track->genre );
         metadataMap.insert( "mpris:length", static_cast<qlonglong>(track->duration) * 1000000 );
 
-        const QString coverpath = UTIL::CONFIGDIR + "/albums/" + track->coverName();
+        const QString coverpath = CoverStore::instance()->exportFile( track->coverName() );
       
         //Debug::debug() << "coverpath = " << coverpath;
       
-        if( QFile(coverpath).exists() )
+        if( !coverpath.isEmpty() )
           metadataMap.insert( "mpris:artUrl", QString( QUrl::fromLocalFile( coverpath ).toEncoded() ) );
         
         if (track->rating != -1.0)
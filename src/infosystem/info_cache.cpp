@@ -0,0 +1,461 @@
+/****************************************************************************************
+*  YAROCK                                                                               *
+*  Copyright (c) 2010-2014 Sebastien amardeilh <sebastien.amardeilh+yarock@gmail.com>   *
+*                                                                                       *
+*  This program is free software; you can redistribute it and/or modify it under        *
+*  the terms of the GNU General Public License as published by the Free Software        *
+*  Foundation; either version 2 of the License, or (at your option) any later           *
+*  version.                                                                             *
+*                                                                                       *
+*  This program is distributed in the hope that it will be useful, but WITHOUT ANY      *
+*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A      *
+*  PARTICULAR PURPOSE. See the GNU General Public License for more details.             *
+*                                                                                       *
+*  You should have received a copy of the GNU General Public License along with         *
+*  this program.  If not, see <http://www.gnu.org/licenses/>.                           *
+*****************************************************************************************/
+#include "info_cache.h"
+#include "utilities.h"
+#include "debug.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QPair>
+#include <QRunnable>
+#include <QSet>
+#include <QtAlgorithms>
+
+/*
+  cache directory layout
+    <md5>  : magic, version, info type, store time, result
+    index  : magic, version, entry count, entries (md5, type, bytes, store time, access time)
+*/
+static const quint32 ENTRY_MAGIC   = 0x59494e46; /* YINF */
+static const quint32 INDEX_MAGIC   = 0x59494e58; /* YINX */
+static const quint32 CACHE_VERSION = 1;
+
+/* disk budget, eviction goes down to 90% of it */
+static const qint64  CACHE_BUDGET  = 64 * 1024 * 1024;
+
+/* index is saved after this number of changes, and on exit */
+static const int     INDEX_SAVE_CHANGES = 32;
+
+static const int     DAY = 24 * 3600;
+
+static QString cacheDir()
+{
+    return UTIL::CONFIGDIR + "/infocache";
+}
+
+static QString entryPath(const QString& key)
+{
+    return cacheDir() + "/" + key;
+}
+
+static QString indexPath()
+{
+    return cacheDir() + "/index";
+}
+
+/*
+********************************************************************************
+*                                                                              *
+*    Class InfoCacheJob                                                        *
+*      -> one disk operation of the cache, run in cache thread pool            *
+*                                                                              *
+********************************************************************************
+*/
+class InfoCacheJob : public QRunnable
+{
+  public:
+    enum Operation { READ, WRITE, REMOVE };
+
+    InfoCacheJob(Operation op, const QString& path, const QByteArray& bytes = QByteArray())
+      : m_op(op), m_path(path), m_bytes(bytes), m_cache(0), m_ticket(-1) {}
+
+    InfoCacheJob(QObject* cache, int ticket, const QString& path)
+      : m_op(READ), m_path(path), m_cache(cache), m_ticket(ticket) {}
+
+    void run()
+    {
+      switch(m_op)
+      {
+        case READ   : read();                 break;
+        case WRITE  : write();                break;
+        case REMOVE : QFile::remove(m_path);  break;
+      }
+    }
+
+  private:
+    void read()
+    {
+      QVariant output;
+
+      QFile file(m_path);
+      if(file.open(QIODevice::ReadOnly))
+      {
+        QDataStream in(&file);
+        in.setVersion(QDataStream::Qt_4_6);
+
+        quint32 magic = 0, version = 0, stored = 0;
+        qint32  type  = 0;
+        in >> magic >> version >> type >> stored;
+
+        if(magic == ENTRY_MAGIC && version == CACHE_VERSION)
+          in >> output;
+
+        if(in.status() != QDataStream::Ok)
+          output = QVariant();
+      }
+
+      QMetaObject::invokeMethod(m_cache, "slot_read_done", Qt::QueuedConnection,
+                                Q_ARG(int, m_ticket), Q_ARG(QVariant, output));
+    }
+
+    /* written aside then renamed, a reader never sees a partial file */
+    void write()
+    {
+      const QString tmp_path = m_path + ".tmp";
+
+      QFile file(tmp_path);
+      if(!file.open(QIODevice::WriteOnly) || file.write(m_bytes) != m_bytes.size()) {
+        Debug::warning() << "[InfoCache] error writing" << m_path;
+        file.remove();
+        return;
+      }
+      file.close();
+
+      QFile::remove(m_path);
+      QFile::rename(tmp_path, m_path);
+    }
+
+    Operation   m_op;
+    QString     m_path;
+    QByteArray  m_bytes;
+    QObject*    m_cache;
+    int         m_ticket;
+};
+
+/*
+********************************************************************************
+*                                                                              *
+*    Class InfoCache                                                           *
+*                                                                              *
+********************************************************************************
+*/
+InfoCache::InfoCache(QObject* parent) : QObject(parent)
+{
+    m_bytes       = 0;
+    m_next_ticket = 0;
+    m_changes     = 0;
+
+    m_stats.memory_hits = 0;
+    m_stats.disk_hits   = 0;
+    m_stats.misses      = 0;
+    m_stats.expired     = 0;
+    m_stats.evicted     = 0;
+    m_stats.entries     = 0;
+    m_stats.bytes       = 0;
+
+    /* one thread keeps read, write and remove of a file in order */
+    m_pool.setMaxThreadCount(1);
+
+    QDir().mkpath(cacheDir());
+    load_index();
+
+    Debug::debug() << "[InfoCache] entries :" << m_index.size() << "size :" << m_bytes;
+}
+
+InfoCache::~InfoCache()
+{
+    const Stats s = stats();
+    Debug::debug() << "[InfoCache] memory hits :" << s.memory_hits
+                   << "disk hits :" << s.disk_hits
+                   << "misses :"    << s.misses
+                   << "expired :"   << s.expired
+                   << "evicted :"   << s.evicted;
+
+    save_index();
+    m_pool.waitForDone();
+}
+
+int InfoCache::timeToLive(INFO::InfoType type)
+{
+    switch(type)
+    {
+      /* covers are kept by CoverStore, lyrics by ServiceLyrics */
+      case INFO::InfoAlbumCoverArt      :
+      case INFO::InfoTrackLyrics        : return 0;
+
+      case INFO::InfoArtistNews         :
+      case INFO::InfoArtistBlog         :
+      case INFO::InfoArtistHotttness    :
+      case INFO::InfoArtistFamiliarity  :
+      case INFO::InfoChart              :
+      case INFO::InfoMiscTopTerms       : return DAY;
+
+      case INFO::InfoArtistSimilars     :
+      case INFO::InfoTrackSimilars      :
+      case INFO::InfoArtistSongs        :
+      case INFO::InfoArtistReviews      :
+      case INFO::InfoArtistTerms        : return 7 * DAY;
+
+      case INFO::InfoArtistBiography    :
+      case INFO::InfoArtistProfile      :
+      case INFO::InfoArtistLinks        :
+      case INFO::InfoArtistImages       :
+      case INFO::InfoArtistReleases     : return 30 * DAY;
+
+      case INFO::InfoAlbumInfo          :
+      case INFO::InfoAlbumSongs         : return 90 * DAY;
+
+      default                           : return 0;
+    }
+}
+
+InfoCache::Stats InfoCache::stats() const
+{
+    Stats s  = m_stats;
+    s.entries = m_index.size();
+    s.bytes   = m_bytes;
+    return s;
+}
+
+bool InfoCache::is_expired(const Entry& entry, uint now) const
+{
+    const int ttl = timeToLive( INFO::InfoType(entry.type) );
+
+    return ttl <= 0 || entry.stored + ttl < now;
+}
+
+/*******************************************************************************
+    lookup / insert
+*******************************************************************************/
+void InfoCache::lookup(const INFO::InfoRequestData& request, QObject* service)
+{
+    const QString key = INFO::requestMd5(request);
+    const uint    now = QDateTime::currentDateTime().toTime_t();
+
+    QHash<QString, Entry>::iterator it = m_index.find(key);
+    if(it == m_index.end()) {
+      m_stats.misses++;
+      emit notFound(request, service);
+      return;
+    }
+
+    if(is_expired(*it, now)) {
+      m_stats.expired++;
+      m_stats.misses++;
+      remove_entry(key);
+      emit notFound(request, service);
+      return;
+    }
+
+    it->accessed = now;
+    m_changes++;
+
+    Pending pending;
+    pending.request = request;
+    pending.service = service;
+
+    const int ticket = m_next_ticket++;
+    m_pending.insert(ticket, pending);
+    m_pool.start(new InfoCacheJob(this, ticket, entryPath(key)));
+}
+
+void InfoCache::slot_read_done(int ticket, QVariant output)
+{
+    if(!m_pending.contains(ticket))
+      return;
+
+    const Pending pending = m_pending.take(ticket);
+
+    if(output.isNull())
+    {
+      /* damaged or removed file */
+      m_stats.misses++;
+      remove_entry( INFO::requestMd5(pending.request) );
+
+      if(pending.service)
+        emit notFound(pending.request, pending.service.data());
+      return;
+    }
+
+    m_stats.disk_hits++;
+    emit found(pending.request, output);
+}
+
+void InfoCache::insert(const INFO::InfoRequestData& request, const QVariant& output)
+{
+    if(timeToLive(request.type) <= 0 || output.isNull())
+      return;
+
+    const QString key = INFO::requestMd5(request);
+    const uint    now = QDateTime::currentDateTime().toTime_t();
+
+    QByteArray bytes;
+    {
+      QDataStream out(&bytes, QIODevice::WriteOnly);
+      out.setVersion(QDataStream::Qt_4_6);
+      out << ENTRY_MAGIC << CACHE_VERSION << qint32(request.type) << quint32(now) << output;
+    }
+
+    if(m_index.contains(key))
+      m_bytes -= m_index.value(key).bytes;
+
+    Entry entry;
+    entry.type     = request.type;
+    entry.bytes    = bytes.size();
+    entry.stored   = now;
+    entry.accessed = now;
+
+    m_index.insert(key, entry);
+    m_bytes += entry.bytes;
+    m_changes++;
+
+    m_pool.start(new InfoCacheJob(InfoCacheJob::WRITE, entryPath(key), bytes));
+
+    evict();
+
+    if(m_changes >= INDEX_SAVE_CHANGES)
+      save_index();
+}
+
+/*******************************************************************************
+    index
+*******************************************************************************/
+void InfoCache::remove_entry(const QString& key)
+{
+    if(!m_index.contains(key))
+      return;
+
+    m_bytes -= m_index.take(key).bytes;
+    m_changes++;
+
+    m_pool.start(new InfoCacheJob(InfoCacheJob::REMOVE, entryPath(key)));
+}
+
+/* least recently used entries first */
+void InfoCache::evict()
+{
+    if(m_bytes <= CACHE_BUDGET)
+      return;
+
+    QList< QPair<uint, QString> > entries;
+    QHash<QString, Entry>::const_iterator it = m_index.constBegin();
+    for( ; it != m_index.constEnd(); ++it)
+      entries << qMakePair(it.value().accessed, it.key());
+
+    qSort(entries);
+
+    const qint64 target = CACHE_BUDGET / 10 * 9;
+    for(int i = 0; i < entries.size() && m_bytes > target; ++i) {
+      remove_entry(entries.at(i).second);
+      m_stats.evicted++;
+    }
+}
+
+void InfoCache::save_index()
+{
+    QByteArray bytes;
+    {
+      QDataStream out(&bytes, QIODevice::WriteOnly);
+      out.setVersion(QDataStream::Qt_4_6);
+      out << INDEX_MAGIC << CACHE_VERSION << qint32(m_index.size());
+
+      QHash<QString, Entry>::const_iterator it = m_index.constBegin();
+      for( ; it != m_index.constEnd(); ++it)
+        out << it.key() << qint32(it.value().type) << qint32(it.value().bytes)
+            << quint32(it.value().stored) << quint32(it.value().accessed);
+    }
+
+    m_changes = 0;
+    m_pool.start(new InfoCacheJob(InfoCacheJob::WRITE, indexPath(), bytes));
+}
+
+/* files written after last index save (crash) are taken back from their header */
+void InfoCache::load_index()
+{
+    QHash<QString, Entry> saved;
+
+    QFile index_file(indexPath());
+    if(index_file.open(QIODevice::ReadOnly))
+    {
+      QDataStream in(&index_file);
+      in.setVersion(QDataStream::Qt_4_6);
+
+      quint32 magic = 0, version = 0;
+      qint32  count = 0;
+      in >> magic >> version >> count;
+
+      if(magic == INDEX_MAGIC && version == CACHE_VERSION)
+      {
+        for(int i = 0; i < count && in.status() == QDataStream::Ok; ++i)
+        {
+          QString key;
+          qint32  type, bytes;
+          quint32 stored, accessed;
+          in >> key >> type >> bytes >> stored >> accessed;
+
+          Entry entry;
+          entry.type     = type;
+          entry.bytes    = bytes;
+          entry.stored   = stored;
+          entry.accessed = accessed;
+          saved.insert(key, entry);
+        }
+      }
+    }
+
+    const uint now = QDateTime::currentDateTime().toTime_t();
+
+    const QFileInfoList files = QDir(cacheDir()).entryInfoList(QDir::Files);
+    foreach(const QFileInfo& info, files)
+    {
+      const QString key = info.fileName();
+      if(key == "index")
+        continue;
+
+      Entry entry;
+      bool valid = false;
+
+      if(saved.contains(key) && saved.value(key).bytes == info.size())
+      {
+        entry = saved.value(key);
+        valid = true;
+      }
+      else if(!key.endsWith(".tmp"))
+      {
+        QFile file(info.filePath());
+        if(file.open(QIODevice::ReadOnly))
+        {
+          QDataStream in(&file);
+          in.setVersion(QDataStream::Qt_4_6);
+
+          quint32 magic = 0, version = 0, stored = 0;
+          qint32  type  = 0;
+          in >> magic >> version >> type >> stored;
+
+          valid = in.status() == QDataStream::Ok && magic == ENTRY_MAGIC && version == CACHE_VERSION;
+
+          entry.type     = type;
+          entry.bytes    = info.size();
+          entry.stored   = stored;
+          entry.accessed = stored;
+        }
+      }
+
+      if(!valid || is_expired(entry, now)) {
+        QFile::remove(info.filePath());
+        continue;
+      }
+
+      m_index.insert(key, entry);
+      m_bytes += entry.bytes;
+    }
+
+    evict();
+}
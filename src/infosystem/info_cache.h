@@ -0,0 +1,106 @@
+/****************************************************************************************
+*  YAROCK                                                                               *
+*  Copyright (c) 2010-2014 Sebastien amardeilh <sebastien.amardeilh+yarock@gmail.com>   *
+*                                                                                       *
+*  This program is free software; you can redistribute it and/or modify it under        *
+*  the terms of the GNU General Public License as published by the Free Software        *
+*  Foundation; either version 2 of the License, or (at your option) any later           *
+*  version.                                                                             *
+*                                                                                       *
+*  This program is distributed in the hope that it will be useful, but WITHOUT ANY      *
+*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A      *
+*  PARTICULAR PURPOSE. See the GNU General Public License for more details.             *
+*                                                                                       *
+*  You should have received a copy of the GNU General Public License along with         *
+*  this program.  If not, see <http://www.gnu.org/licenses/>.                           *
+*****************************************************************************************/
+#ifndef _INFO_CACHE_H_
+#define _INFO_CACHE_H_
+
+#include "info_system.h"
+
+#include <QObject>
+#include <QVariant>
+#include <QHash>
+#include <QPointer>
+#include <QThreadPool>
+
+/*
+********************************************************************************
+*                                                                              *
+*    Class InfoCache                                                           *
+*      -> persistent cache of infosystem results, one file per request md5     *
+*      -> entries expire after a delay depending on info type, the least       *
+*         recently used entries are removed when cache exceed its budget       *
+*      -> files are read and written in a single thread pool, keeping disk     *
+*         operations ordered and away from infosystem worker thread            *
+*                                                                              *
+********************************************************************************
+*/
+class InfoCache : public QObject
+{
+Q_OBJECT
+
+public:
+    InfoCache(QObject* parent = 0);
+    ~InfoCache();
+
+    struct Stats
+    {
+      int     memory_hits;
+      int     disk_hits;
+      int     misses;
+      int     expired;
+      int     evicted;
+      int     entries;
+      qint64  bytes;
+    };
+
+    /* answer with found() or notFound(), service is given back on miss */
+    void lookup(const INFO::InfoRequestData& request, QObject* service);
+    void insert(const INFO::InfoRequestData& request, const QVariant& output);
+
+    void countMemoryHit() { m_stats.memory_hits++; }
+    Stats stats() const;
+
+    /* seconds, 0 for info not kept on disk */
+    static int timeToLive(INFO::InfoType type);
+
+signals:
+    void found(INFO::InfoRequestData requestData, QVariant output);
+    void notFound(INFO::InfoRequestData requestData, QObject* service);
+
+private slots:
+    void slot_read_done(int ticket, QVariant output);
+
+private:
+    struct Entry
+    {
+      int     type;
+      int     bytes;
+      uint    stored;
+      uint    accessed;
+    };
+
+    struct Pending
+    {
+      INFO::InfoRequestData request;
+      QPointer<QObject>     service;
+    };
+
+    QThreadPool                m_pool;
+    QHash<QString, Entry>      m_index;
+    QHash<int, Pending>        m_pending;
+    qint64                     m_bytes;
+    int                        m_next_ticket;
+    int                        m_changes;
+    Stats                      m_stats;
+
+    void load_index();
+    void save_index();
+    void remove_entry(const QString& key);
+    void evict();
+    bool is_expired(const Entry& entry, uint now) const;
+};
+
+#endif // _INFO_CACHE_H_
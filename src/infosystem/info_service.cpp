@@ -15,6 +15,7 @@
 *  this program.  If not, see <http://www.gnu.org/licenses/>.                           *
 *****************************************************************************************/
 #include "info_service.h"
+#include "networkaccess.h"
 
 
 /*
@@ -26,6 +27,7 @@
 */ 
 INFO::InfoService::InfoService() : QObject()
 {
+    m_priority = 0;
 }
 
 
@@ -47,3 +49,48 @@ INFO::InfoService::name() const
     return m_name;
 }
 
+
+void
+INFO::InfoService::setPriority( int priority, INFO::InfoType type )
+{
+    if( type == INFO::InfoNoInfo )
+    {
+      m_priority = priority;
+      m_priorities.clear();
+    }
+    else
+    {
+      m_priorities[ type ] = priority;
+    }
+}
+
+
+int
+INFO::InfoService::priority( INFO::InfoType type ) const
+{
+    return m_priorities.value( type, m_priority );
+}
+
+
+void
+INFO::InfoService::cancelInfo( INFO::InfoRequestData requestData )
+{
+    INFO::abortRequests( m_requests, requestData.requestId );
+}
+
+
+void
+INFO::abortRequests( QMap<QObject*, INFO::InfoRequestData>& requests, quint64 requestId )
+{
+    foreach( QObject* reply, requests.keys() )
+    {
+      if( requests.value(reply).requestId != requestId )
+        continue;
+
+      requests.remove( reply );
+
+      NetworkReply* networkReply = qobject_cast<NetworkReply*>( reply );
+      if( networkReply )
+        networkReply->abort();
+    }
+}
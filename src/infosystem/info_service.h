@@ -22,9 +22,14 @@
 #include <QObject>
 #include <QVariant>
 #include <QSet>
+#include <QHash>
+#include <QMap>
 
 namespace INFO
 {
+/* abort running network replies of a request and forget them */
+void abortRequests( QMap<QObject*, INFO::InfoRequestData>& requests, quint64 requestId );
+
 /*
 ********************************************************************************
 *                                                                              *
@@ -46,6 +51,10 @@ public:
 
     QSet< INFO::InfoType > supportedInfoTypes() const { return m_supportedInfoTypes; }
 
+    /* services with higher priority are asked first, InfoNoInfo sets all types */
+    void setPriority( int priority, INFO::InfoType type = INFO::InfoNoInfo );
+    int priority( INFO::InfoType type ) const;
+
 signals:
     void info( INFO::InfoRequestData requestData, QVariant output );
     void finished( INFO::InfoRequestData requestData );
@@ -56,10 +65,20 @@ protected slots:
     virtual void getInfo( INFO::InfoRequestData requestData ) = 0;
     virtual void fetchInfo( INFO::InfoRequestData requestData ) = 0;
 
+    /* abort network requests of another service answer */
+    virtual void cancelInfo( INFO::InfoRequestData requestData );
+
 protected:
     InfoType        m_type;
     QString         m_name;
     QSet< INFO::InfoType > m_supportedInfoTypes;
+
+    /* running network replies */
+    QMap<QObject*, INFO::InfoRequestData> m_requests;
+
+private:
+    int                  m_priority;
+    QHash< int, int >    m_priorities;
 };
 
 } // namespace INFO
@@ -180,6 +180,17 @@ InfoSystem::getInfo( const INFO::InfoRequestData& requestData )
 }
 
 
+void
+InfoSystem::setServicePriority( const QString& name, INFO::InfoType type, int priority )
+{
+    if ( !m_workerThread->worker() )
+      return;
+
+    QMetaObject::invokeMethod( m_workerThread->worker(), "setServicePriority", Qt::QueuedConnection,
+                               Q_ARG( QString, name ), Q_ARG( int, type ), Q_ARG( int, priority ) );
+}
+
+
 /*
 ********************************************************************************
 *                                                                              *
@@ -106,6 +106,9 @@ public:
 
     bool getInfo( const INFO::InfoRequestData& requestData );
 
+    /* services with higher priority are asked first for this type */
+    void setServicePriority( const QString& name, INFO::InfoType type, int priority );
+
 signals:
     void info( INFO::InfoRequestData requestData, QVariant output );
     void finished( INFO::InfoRequestData requestData );
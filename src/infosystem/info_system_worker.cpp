@@ -23,6 +23,14 @@
 #include "services/service_musicbrainz.h"
 #include "services/service_lyrics.h"
 
+#include <QTimerEvent>
+
+/* head start given to a service before next one is asked (ms) */
+static const int RACE_HEAD_START = 2000;
+
+/* delay for last service to answer (ms) */
+static const int RACE_TIMEOUT    = 30000;
+
 /*
 ********************************************************************************
 *                                                                              *
@@ -34,6 +42,7 @@ InfoSystemWorker::InfoSystemWorker() : QObject()
 {
     Debug::debug() << Q_FUNC_INFO;
 
+    m_diskCache = 0;
 }
 
 InfoSystemWorker::~InfoSystemWorker()
@@ -45,6 +54,8 @@ InfoSystemWorker::~InfoSystemWorker()
         if( service )
           delete service;
     }
+
+    delete m_diskCache;
 }
 
 
@@ -53,6 +64,23 @@ InfoSystemWorker::init(  )
 {
     Debug::debug() << Q_FUNC_INFO;
 
+    /* persistent cache, results from previous sessions */
+    m_diskCache = new InfoCache();
+
+    connect(
+        m_diskCache,
+        SIGNAL( found( INFO::InfoRequestData, QVariant ) ),
+        this,
+        SLOT( slot_diskCacheFound( INFO::InfoRequestData, QVariant ) )
+    );
+
+    connect(
+        m_diskCache,
+        SIGNAL( notFound( INFO::InfoRequestData, QObject* ) ),
+        this,
+        SLOT( slot_diskCacheNotFound( INFO::InfoRequestData, QObject* ) )
+    );
+
     /* create all InfoServices */
     m_services.append(new ServiceEchonest());
     m_services.append(new ServiceLastFm());
@@ -80,6 +108,14 @@ InfoSystemWorker::init(  )
             SLOT( slot_updateCache( INFO::InfoRequestData, QVariant) ),
             Qt::QueuedConnection
         );
+
+        connect(
+            service,
+            SIGNAL( finished( INFO::InfoRequestData ) ),
+            this,
+            SLOT( slot_serviceFinished( INFO::InfoRequestData ) ),
+            Qt::QueuedConnection
+        );
                 
         
         QMetaObject::invokeMethod( service, "init", Qt::QueuedConnection );
@@ -89,24 +125,202 @@ InfoSystemWorker::init(  )
 
 void InfoSystemWorker::getInfo( INFO::InfoRequestData requestData )
 {
-    bool foundOne = false;
     //Debug::debug() << Q_FUNC_INFO;
-    
-    foreach (INFO::InfoService* service, m_services) 
+    const QString md5Hash = INFO::requestMd5(requestData);
+
+    QList<INFO::InfoRequestData> waiters;
+
+    if( m_races.contains( md5Hash ) )
     {
-        if( service->supportedInfoTypes().contains(requestData.type) ) 
+        Race& running = m_races[ md5Hash ];
+
+        /* same request already running, answer will be shared */
+        if( running.request.requestId != requestData.requestId && !has_waiter( running, requestData.requestId ) )
+        {
+            running.waiters << requestData;
+            return;
+        }
+
+        /* retry of a request timed out on caller side, services are asked again */
+        Race stale = m_races.take( md5Hash );
+        stop_race( stale );
+
+        stale.waiters.prepend( stale.request );
+        foreach (const INFO::InfoRequestData& waiter, stale.waiters)
         {
-          QMetaObject::invokeMethod( service, "getInfo", Qt::QueuedConnection, Q_ARG( INFO::InfoRequestData, requestData ) );
-          foundOne = true;
+            if( waiter.requestId != requestData.requestId )
+              waiters << waiter;
         }
     }
 
-    if ( !foundOne )
+    const QList<INFO::InfoService*> services = services_for( requestData.type );
+
+    if ( services.isEmpty() )
     {
         emit info( requestData, QVariant() );
+        return;
+    }
+
+    Race race;
+    race.request      = requestData;
+    race.waiters      = waiters;
+    race.candidates   = services;
+    race.cache_missed = false;
+    race.timer        = 0;
+
+    m_races.insert( md5Hash, race );
+    start_next( md5Hash );
+}
+
+
+void InfoSystemWorker::setServicePriority(QString name, int type, int priority)
+{
+    foreach (INFO::InfoService* service, m_services)
+    {
+        if( service->name() == name )
+          service->setPriority( priority, INFO::InfoType(type) );
+    }
+}
+
+
+/* stable order, services with same priority keep creation order */
+QList<INFO::InfoService*> InfoSystemWorker::services_for(INFO::InfoType type) const
+{
+    QList<INFO::InfoService*> services;
+
+    foreach (INFO::InfoService* service, m_services)
+    {
+        if( !service->supportedInfoTypes().contains(type) )
+          continue;
+
+        int i = 0;
+        while( i < services.size() && services.at(i)->priority(type) >= service->priority(type) )
+          i++;
+
+        services.insert( i, service );
+    }
+
+    return services;
+}
+
+
+void InfoSystemWorker::start_next(const QString& key)
+{
+    Race& race = m_races[ key ];
+    stop_timer( race );
+
+    if( race.candidates.isEmpty() )
+    {
+        /* every service failed */
+        if( race.running.isEmpty() ) {
+          m_races.remove( key );
+          return;
+        }
+
+        race.timer = startTimer( RACE_TIMEOUT );
+        m_race_timers.insert( race.timer, key );
+        return;
+    }
+
+    INFO::InfoService* service = race.candidates.takeFirst();
+    race.running << service;
+
+    QMetaObject::invokeMethod( service, "getInfo", Qt::QueuedConnection, Q_ARG( INFO::InfoRequestData, race.request ) );
+
+    race.timer = startTimer( race.candidates.isEmpty() ? RACE_TIMEOUT : RACE_HEAD_START );
+    m_race_timers.insert( race.timer, key );
+}
+
+
+void InfoSystemWorker::stop_timer(Race& race)
+{
+    if( !race.timer )
+      return;
+
+    killTimer( race.timer );
+    m_race_timers.remove( race.timer );
+    race.timer = 0;
+}
+
+
+/* abort network requests of running services */
+void InfoSystemWorker::stop_race(Race& race)
+{
+    stop_timer( race );
+
+    foreach (INFO::InfoService* service, race.running)
+      QMetaObject::invokeMethod( service, "cancelInfo", Qt::QueuedConnection, Q_ARG( INFO::InfoRequestData, race.request ) );
+
+    race.running.clear();
+}
+
+
+bool InfoSystemWorker::has_waiter(const Race& race, quint64 requestId) const
+{
+    foreach (const INFO::InfoRequestData& waiter, race.waiters)
+    {
+        if( waiter.requestId == requestId )
+          return true;
     }
+    return false;
 }
 
+
+void InfoSystemWorker::timerEvent(QTimerEvent* event)
+{
+    const QString key = m_race_timers.take( event->timerId() );
+    killTimer( event->timerId() );
+
+    if( !m_races.contains( key ) )
+      return;
+
+    Race& race = m_races[ key ];
+    race.timer = 0;
+
+    /* running service is too slow, next one joins the race */
+    if( !race.candidates.isEmpty() ) {
+      start_next( key );
+      return;
+    }
+
+    Debug::debug() << "[InfoSystemWorker] no answer for request type" << race.request.type;
+
+    stop_race( race );
+    m_races.remove( key );
+}
+
+
+void InfoSystemWorker::service_failed(const QString& key, INFO::InfoService* service)
+{
+    if( !m_races.contains( key ) )
+      return;
+
+    Race& race = m_races[ key ];
+    race.running.removeAll( service );
+
+    /* no need to wait for head start */
+    if( race.running.isEmpty() )
+      start_next( key );
+}
+
+
+void InfoSystemWorker::deliver(const QString& key, const QVariant& output)
+{
+    /* late answer of a race already won */
+    if( !m_races.contains( key ) )
+      return;
+
+    Race race = m_races.take( key );
+    stop_race( race );
+
+    /* notify info ready */
+    emit info( race.request, output );
+
+    foreach (const INFO::InfoRequestData& waiter, race.waiters)
+      emit info( waiter, output );
+}
+
+
 void InfoSystemWorker::slot_checkCache(INFO::InfoRequestData requestData)
 {
     //Debug::debug() << Q_FUNC_INFO;
@@ -115,32 +329,72 @@ void InfoSystemWorker::slot_checkCache(INFO::InfoRequestData requestData)
     
     /* check if info is already in cache */
     const QString md5Hash = INFO::requestMd5(requestData);
+
+    if( !m_races.contains( md5Hash ) )
+      return;
     
     if( m_dataCache.contains( md5Hash) ) 
     {
-      /* notify info ready */
-      emit info( requestData, QVariant( *( m_dataCache[ md5Hash ] ) ) ); 
+      m_diskCache->countMemoryHit();
+
+      deliver( md5Hash, QVariant( *( m_dataCache[ md5Hash ] ) ) );
     }
-    else
+    else if( m_races.value( md5Hash ).cache_missed )
     {
       /* trigger caller service fetch */
       QMetaObject::invokeMethod( sendingObj, "fetchInfo", Q_ARG( INFO::InfoRequestData, requestData ));
     }
+    else
+    {
+      /* disk cache is read in background, answer comes back with a signal */
+      m_diskCache->lookup( requestData, sendingObj );
+    }
+}
+
+
+void InfoSystemWorker::slot_diskCacheFound(INFO::InfoRequestData requestData, QVariant output)
+{
+    const QString md5Hash = INFO::requestMd5(requestData);
+    m_dataCache.insert(md5Hash, new QVariant(output) );
+
+    deliver( md5Hash, output );
+}
+
+
+void InfoSystemWorker::slot_diskCacheNotFound(INFO::InfoRequestData requestData, QObject* service)
+{
+    const QString md5Hash = INFO::requestMd5(requestData);
+
+    if( !m_races.contains( md5Hash ) )
+      return;
+
+    m_races[ md5Hash ].cache_missed = true;
+
+    /* trigger caller service fetch */
+    QMetaObject::invokeMethod( service, "fetchInfo", Q_ARG( INFO::InfoRequestData, requestData ));
 }
 
 
 void InfoSystemWorker::slot_updateCache(INFO::InfoRequestData requestData, QVariant output)
 {
     //Debug::debug() << Q_FUNC_INFO;
+    const QString md5Hash = INFO::requestMd5(requestData);
   
-    if( !output.isNull() ) 
+    if( output.isNull() ) 
     {
-        /* put data in cache */
-        const QString md5Hash = INFO::requestMd5(requestData);
-     
-        m_dataCache.insert(md5Hash, new QVariant(output) );
-
-        /* notify info ready */
-        emit info( requestData, output ); 
+        service_failed( md5Hash, qobject_cast<INFO::InfoService*>( sender() ) );
+        return;
     }
+
+    /* put data in cache, late answers too */
+    m_dataCache.insert(md5Hash, new QVariant(output) );
+    m_diskCache->insert(requestData, output);
+
+    deliver( md5Hash, output );
+}
+
+
+void InfoSystemWorker::slot_serviceFinished(INFO::InfoRequestData requestData)
+{
+    service_failed( INFO::requestMd5(requestData), qobject_cast<INFO::InfoService*>( sender() ) );
 }
@@ -19,10 +19,12 @@
 
 #include "info_system.h"
 #include "info_service.h"
+#include "info_cache.h"
 
 #include <QObject>
 #include <QVariant>
 #include <QList>
+#include <QHash>
 #include <QCache>
 
 
@@ -30,6 +32,12 @@
 ********************************************************************************
 *                                                                              *
 *    Class InfoSystemWorker                                                    *
+*      -> services supporting a request are raced by priority, the first       *
+*         one gets a head start, the next one is asked when it fails or        *
+*         is too slow                                                          *
+*      -> first result wins, other services requests are aborted               *
+*      -> identical requests running at the same time share one race, a        *
+*         request sent again with the same id restarts it                      *
 *                                                                              *
 ********************************************************************************
 */ 
@@ -47,12 +55,45 @@ signals:
 public slots:
     void init();
     void getInfo(INFO::InfoRequestData requestData );
+    void setServicePriority(QString name, int type, int priority);
     void slot_checkCache(INFO::InfoRequestData requestData);
     void slot_updateCache(INFO::InfoRequestData requestData, QVariant output);
 
+protected:
+    void timerEvent(QTimerEvent* event);
+
+private slots:
+    void slot_serviceFinished(INFO::InfoRequestData requestData);
+    void slot_diskCacheFound(INFO::InfoRequestData requestData, QVariant output);
+    void slot_diskCacheNotFound(INFO::InfoRequestData requestData, QObject* service);
+
+private:
+    struct Race
+    {
+      INFO::InfoRequestData          request;
+      QList<INFO::InfoRequestData>   waiters;     /* coalesced requests */
+      QList<INFO::InfoService*>      candidates;  /* not asked yet */
+      QList<INFO::InfoService*>      running;
+      bool                           cache_missed;
+      int                            timer;
+    };
+
+    QList<INFO::InfoService*> services_for(INFO::InfoType type) const;
+    void start_next(const QString& key);
+    void service_failed(const QString& key, INFO::InfoService* service);
+    void deliver(const QString& key, const QVariant& output);
+    void stop_timer(Race& race);
+    void stop_race(Race& race);
+    bool has_waiter(const Race& race, quint64 requestId) const;
+
 private:
     QList< INFO::InfoService* > m_services;
     QCache< QString, QVariant > m_dataCache;
+    InfoCache*                  m_diskCache;
+
+    /* running races, key is request md5 */
+    QHash< QString, Race >      m_races;
+    QHash< int, QString >       m_race_timers;
 };
 
 #endif // _INFO_SYSTEM_WORKER_H_
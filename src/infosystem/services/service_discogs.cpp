@@ -43,6 +43,12 @@ ServiceDiscogs::ServiceDiscogs() : InfoService()
     Debug::debug() << Q_FUNC_INFO;
 
     setName("discogs");
+
+    /* 25 requests per minute for anonymous clients */
+    HTTP()->setHostRateLimit("api.discogs.com", 2400);
+
+    /* slowest rate limit, asked last */
+    setPriority(0);
     
      m_supportedInfoTypes << INFO::InfoAlbumSongs 
                           /*<< INFO::InfoAlbumCoverArt  */
@@ -57,9 +57,6 @@ private slots:
     void slot_parse_artist_release_response(QByteArray);
     void slot_parse_album_search_response(QByteArray);
     void slot_image_received(QByteArray);
-    
-private:
-    QMap<QObject*, INFO::InfoRequestData> m_requests;
 };
 
 #endif // _SERVICE_DISCOGS_H_
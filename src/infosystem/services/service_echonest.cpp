@@ -40,6 +40,11 @@ ServiceEchonest::ServiceEchonest() : InfoService()
     Debug::debug() << Q_FUNC_INFO;
 
     setName("echonest");
+
+    /* 120 requests per minute */
+    HTTP()->setHostRateLimit("developer.echonest.com", 500);
+
+    setPriority(1);
     
     m_supportedInfoTypes << INFO::InfoArtistBiography 
                          << INFO::InfoArtistImages 
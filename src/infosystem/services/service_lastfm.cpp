@@ -38,6 +38,12 @@ ServiceLastFm::ServiceLastFm() : InfoService()
     Debug::debug() << Q_FUNC_INFO;
 
     setName("lastfm");
+
+    /* 5 requests per second */
+    HTTP()->setHostRateLimit("ws.audioscrobbler.com", 200);
+
+    /* fast answers and few limits, asked first */
+    setPriority(2);
     
     m_supportedInfoTypes << INFO::InfoAlbumCoverArt
                          << INFO::InfoAlbumInfo
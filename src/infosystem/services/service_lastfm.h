@@ -56,9 +56,6 @@ private slots:
     void slot_parse_album_info(QByteArray);
     void slot_image_received(QByteArray);
     void slot_request_error();
-
-private:
-    QMap<QObject*, INFO::InfoRequestData> m_requests;
 };
 
 #endif // _SERVICE_LASTFM_H_
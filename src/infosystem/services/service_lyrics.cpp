@@ -26,6 +26,34 @@
 #include "debug.h"
 
 #include <QFutureWatcher>
+#include <QDataStream>
+#include <QTimerEvent>
+
+/* providers asked together */
+static const int WAVE_SIZE    = 3;
+
+/* delay before next wave joins, or best answer is kept (ms) */
+static const int WAVE_TIMEOUT = 3000;
+
+static const quint32 STORE_MAGIC   = 0x594c5952; /* YLYR */
+static const quint32 STORE_VERSION = 1;
+
+static QString lyricsKey(INFO::InfoRequestData requestData)
+{
+    INFO::InfoStringHash input = requestData.data.value< INFO::InfoStringHash >();
+
+    QCryptographicHash hash(QCryptographicHash::Sha1);
+    hash.addData(input["artist"].toLower().toUtf8().constData());
+    hash.addData(input["title"].toLower().toUtf8().constData());
+
+    return QString(hash.result().toHex());
+}
+
+/* lyrics found on providers, user lyrics are in <key>.txt */
+static QString storedLyricsPath(INFO::InfoRequestData requestData)
+{
+    return UTIL::CONFIGDIR + "/lyrics/" + lyricsKey(requestData) + ".dat";
+}
 
 /*
 ********************************************************************************
@@ -88,8 +116,8 @@ void ServiceLyrics::slot_ultimate_lyrics_parsed()
          m_providers << provider;
          Debug::debug() << "    [ServiceLyrics] slot_ultimate_lyrics_parsed # Provider Name =" << name;
  
-         connect(provider, SIGNAL(InfoReady(INFO::InfoRequestData, const QString&)), this, SLOT(slot_lyrics_fetched(INFO::InfoRequestData,const QString&)), Qt::QueuedConnection);
-         connect(provider, SIGNAL(Finished(INFO::InfoRequestData)), this, SLOT(slot_fetch_lyrics(INFO::InfoRequestData)), Qt::QueuedConnection);
+         connect(provider, SIGNAL(InfoReady(INFO::InfoRequestData, const QString&, const QString&)), this, SLOT(slot_lyrics_fetched(INFO::InfoRequestData,const QString&, const QString&)), Qt::QueuedConnection);
+         connect(provider, SIGNAL(Finished(INFO::InfoRequestData)), this, SLOT(slot_lyrics_not_found(INFO::InfoRequestData)), Qt::QueuedConnection);
   
          break;
        }
@@ -174,18 +202,41 @@ void ServiceLyrics::fetchInfo( INFO::InfoRequestData requestData )
 {
     //Debug::debug() << Q_FUNC_INFO;
 
-    if ( requestData.type == INFO::InfoTrackLyrics) 
+    if ( requestData.type != INFO::InfoTrackLyrics) 
     {
-      m_current_providers.clear();
-      m_current_providers.append(m_providers);
-    
-      if( !check_local_lyrics(requestData) )
-        slot_fetch_lyrics(requestData);
+        emit finished( requestData );
+        return;
     }
-    else 
+
+    if( check_local_lyrics(requestData) || check_stored_lyrics(requestData) )
+      return;
+
+    if( m_providers.isEmpty() || m_searches.contains(requestData.requestId) )
     {
         emit finished( requestData );
+        return;
     }
+
+    Search search;
+    search.request   = requestData;
+    search.pending   = m_providers;
+    search.best_rank = -1;
+    search.timer     = 0;
+
+    m_searches.insert( requestData.requestId, search );
+    start_wave( requestData.requestId );
+}
+
+/*******************************************************************************
+  ServiceLyrics::cancelInfo
+*******************************************************************************/
+void ServiceLyrics::cancelInfo( INFO::InfoRequestData requestData )
+{
+    if( !m_searches.contains(requestData.requestId) )
+      return;
+
+    Search search = m_searches.take( requestData.requestId );
+    stop_search( search );
 }
 
 
@@ -194,13 +245,7 @@ void ServiceLyrics::fetchInfo( INFO::InfoRequestData requestData )
 *******************************************************************************/
 bool ServiceLyrics::check_local_lyrics(INFO::InfoRequestData requestData)
 {
-    INFO::InfoStringHash input = requestData.data.value< INFO::InfoStringHash >();
-
-    QCryptographicHash hash(QCryptographicHash::Sha1);
-    hash.addData(input["artist"].toLower().toUtf8().constData());
-    hash.addData(input["title"].toLower().toUtf8().constData());
-
-    const QString path = QString(UTIL::CONFIGDIR + "/lyrics/" + hash.result().toHex() + ".txt");
+    const QString path = QString(UTIL::CONFIGDIR + "/lyrics/" + lyricsKey(requestData) + ".txt");
 
     if( QFile::exists(path) )
     {
@@ -226,35 +271,197 @@ bool ServiceLyrics::check_local_lyrics(INFO::InfoRequestData requestData)
 }
 
 /*******************************************************************************
-  ServiceLyrics::slot_fetch_lyrics
+  ServiceLyrics::check_stored_lyrics
 *******************************************************************************/
-void ServiceLyrics::slot_fetch_lyrics(INFO::InfoRequestData requestData)
+bool ServiceLyrics::check_stored_lyrics(INFO::InfoRequestData requestData)
 {
-    if(m_current_providers.isEmpty()) return;
+    QFile file( storedLyricsPath(requestData) );
+    if( !file.open(QIODevice::ReadOnly) )
+      return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_4_6);
 
-    UltimateLyricsProvider *provider = m_current_providers.takeFirst();
+    quint32      magic = 0, version = 0;
+    QVariantHash output;
+    in >> magic >> version;
 
-    provider->FetchInfo(requestData);
+    if( magic != STORE_MAGIC || version != STORE_VERSION )
+      return false;
+
+    in >> output;
+    if( in.status() != QDataStream::Ok || output.value("lyrics").toString().isEmpty() )
+      return false;
+
+    emit info(requestData, output);
+
+    return true;
+}
+
+/*******************************************************************************
+  ServiceLyrics::store_lyrics
+*******************************************************************************/
+void ServiceLyrics::store_lyrics(INFO::InfoRequestData requestData, const QVariantHash& output)
+{
+    QFile file( storedLyricsPath(requestData) );
+    if( !file.open(QIODevice::WriteOnly) ) {
+      Debug::warning() << "    [ServiceLyrics] cannot store lyrics" << file.fileName();
+      return;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_4_6);
+    out << STORE_MAGIC << STORE_VERSION << output;
+}
+
+/*******************************************************************************
+  ServiceLyrics::start_wave
+*******************************************************************************/
+void ServiceLyrics::start_wave(quint64 id)
+{
+    Search& search = m_searches[id];
+
+    if( search.timer ) {
+      killTimer( search.timer );
+      m_search_timers.remove( search.timer );
+      search.timer = 0;
+    }
+
+    /* previous waves still running keep their chance */
+    for(int i = 0; i < WAVE_SIZE && !search.pending.isEmpty(); i++)
+    {
+      UltimateLyricsProvider *provider = search.pending.takeFirst();
+      search.running << provider;
+      provider->FetchInfo( search.request );
+    }
+
+    if( search.running.isEmpty() )
+    {
+      /* no provider left */
+      const INFO::InfoRequestData request = search.request;
+      m_searches.remove(id);
+      emit finished( request );
+      return;
+    }
+
+    search.timer = startTimer( WAVE_TIMEOUT );
+    m_search_timers.insert( search.timer, id );
+}
+
+/*******************************************************************************
+  ServiceLyrics::check_search
+    -> answer is given when no better ranked provider is still running
+*******************************************************************************/
+void ServiceLyrics::check_search(quint64 id)
+{
+    Search& search = m_searches[id];
+
+    if( search.best_rank == -1 )
+    {
+      if( search.running.isEmpty() )
+        start_wave(id);
+      return;
+    }
+
+    foreach(UltimateLyricsProvider* provider, search.running)
+      if( m_providers.indexOf(provider) < search.best_rank )
+        return;
+
+    deliver(id);
+}
+
+/*******************************************************************************
+  ServiceLyrics::deliver
+*******************************************************************************/
+void ServiceLyrics::deliver(quint64 id)
+{
+    Search search = m_searches.take(id);
+    stop_search( search );
+
+    store_lyrics( search.request, search.best );
+
+    emit info( search.request, search.best );
+}
+
+/*******************************************************************************
+  ServiceLyrics::stop_search
+*******************************************************************************/
+void ServiceLyrics::stop_search(Search& search)
+{
+    if( search.timer ) {
+      killTimer( search.timer );
+      m_search_timers.remove( search.timer );
+      search.timer = 0;
+    }
+
+    foreach(UltimateLyricsProvider* provider, search.running)
+      provider->CancelInfo( search.request );
+
+    search.running.clear();
+}
+
+/*******************************************************************************
+  ServiceLyrics::timerEvent
+*******************************************************************************/
+void ServiceLyrics::timerEvent(QTimerEvent* event)
+{
+    const quint64 id = m_search_timers.take( event->timerId() );
+    killTimer( event->timerId() );
+
+    if( !m_searches.contains(id) )
+      return;
+
+    Search& search = m_searches[id];
+    search.timer = 0;
+
+    /* better ranked providers are too slow */
+    if( search.best_rank != -1 )
+      deliver(id);
+    else
+      start_wave(id);
+}
+
+/*******************************************************************************
+  ServiceLyrics::slot_lyrics_not_found
+*******************************************************************************/
+void ServiceLyrics::slot_lyrics_not_found(INFO::InfoRequestData requestData)
+{
+    UltimateLyricsProvider* provider = qobject_cast<UltimateLyricsProvider*>(sender());
+
+    if( !provider || !m_searches.contains(requestData.requestId) )
+      return;
+
+    m_searches[requestData.requestId].running.removeAll(provider);
+    check_search( requestData.requestId );
 }
 
 
 /*******************************************************************************
   ServiceLyrics::slot_lyrics_fethed
 *******************************************************************************/
-void ServiceLyrics::slot_lyrics_fetched(INFO::InfoRequestData requestData, const QString& lyric)
+void ServiceLyrics::slot_lyrics_fetched(INFO::InfoRequestData requestData, const QString& lyric, const QString& url)
 {
     // get provider sender
     UltimateLyricsProvider* provider = qobject_cast<UltimateLyricsProvider*>(sender());
 
-    if(provider) 
+    /* late answer of a finished search */
+    if( !provider || !m_searches.contains(requestData.requestId) )
+      return;
+
+    Search& search = m_searches[requestData.requestId];
+    search.running.removeAll(provider);
+
+    const int rank = m_providers.indexOf(provider);
+    if( search.best_rank == -1 || rank < search.best_rank )
     {
         QVariantHash output;
         output[ "provider" ] = provider->name();
         output[ "lyrics" ]   = lyric;
-        output[ "url" ]      = provider->lyricsUrl();
+        output[ "url" ]      = url;
 
-        emit info(requestData, output);
+        search.best      = output;
+        search.best_rank = rank;
     }
-}
-
 
+    check_search( requestData.requestId );
+}
@@ -18,6 +18,8 @@
 #define _SERVICE_LYRICS_H
 
 #include <QString>
+#include <QHash>
+#include <QVariant>
 
 #include "info_service.h"
 #include "info_system.h"
@@ -30,6 +32,9 @@ typedef QList<UltimateLyricsProvider*> ProviderList;
 ********************************************************************************
 *                                                                              *
 *    Class ServiceLyrics                                                       *
+*      -> providers are asked in waves following user order, the first wave    *
+*         answer is kept once every better ranked provider failed              *
+*      -> found lyrics are stored per track and never fetched again            *
 *                                                                              *
 ********************************************************************************
 */
@@ -47,19 +52,43 @@ protected slots:
     virtual void init();
     void getInfo( INFO::InfoRequestData requestData );
     void fetchInfo( INFO::InfoRequestData requestData );
+    void cancelInfo( INFO::InfoRequestData requestData );
+
+  protected:
+    void timerEvent(QTimerEvent* event);
 
   private:
+    struct Search
+    {
+      INFO::InfoRequestData  request;
+      ProviderList           pending;
+      ProviderList           running;
+      QVariantHash           best;
+      int                    best_rank;
+      int                    timer;
+    };
+
     bool check_local_lyrics(INFO::InfoRequestData requestData);
+    bool check_stored_lyrics(INFO::InfoRequestData requestData);
+    void store_lyrics(INFO::InfoRequestData requestData, const QVariantHash& output);
+
+    void start_wave(quint64 id);
+    void check_search(quint64 id);
+    void deliver(quint64 id);
+    void stop_search(Search& search);
 
   private slots:
     void slot_ultimate_lyrics_parsed();
-    void slot_fetch_lyrics(INFO::InfoRequestData requestData);
-    void slot_lyrics_fetched(INFO::InfoRequestData requestData,const QString& lyric);
+    void slot_lyrics_fetched(INFO::InfoRequestData requestData,const QString& lyric, const QString& url);
+    void slot_lyrics_not_found(INFO::InfoRequestData requestData);
 
   private:
     UltimateLyricsReader   *m_ultimateLyricsReader;
     ProviderList            m_providers;
-    ProviderList            m_current_providers;
+
+    /* running searches, key is request id */
+    QHash<quint64, Search>  m_searches;
+    QHash<int, quint64>     m_search_timers;
 };
 
 #endif // _SERVICE_LYRICS_H
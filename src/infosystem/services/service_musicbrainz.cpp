@@ -34,6 +34,11 @@ ServiceMusicBrainz::ServiceMusicBrainz() : InfoService()
     Debug::debug() << Q_FUNC_INFO;
 
     setName("musicbrainz");
+
+    /* 1 request per second */
+    HTTP()->setHostRateLimit("musicbrainz.org", 1000);
+
+    setPriority(1);
     
     m_supportedInfoTypes << INFO::InfoArtistReleases
                          << INFO::InfoAlbumCoverArt;
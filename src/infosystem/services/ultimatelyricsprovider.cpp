@@ -19,6 +19,7 @@
 //! thanks for all good works to Clementine developers ;)
 
 #include "ultimatelyricsprovider.h"
+#include "info_service.h"
 #include "core/mediaitem/mediaitem.h"
 #include "networkaccess.h"
 #include "debug.h"
@@ -32,14 +33,52 @@
 */
 UltimateLyricsProvider::UltimateLyricsProvider()
 {
+    codec_ = 0;
+}
+
+void UltimateLyricsProvider::set_charset(const QString& charset)
+{
+    charset_ = charset;
+    codec_   = QTextCodec::codecForName(charset_.toAscii().constData());
+}
+
+void UltimateLyricsProvider::add_url_format(const QString& replace, const QString& with)
+{
+    url_formats_ << qMakePair(QRegExp("[" + QRegExp::escape(replace) + "]"), with);
+}
+
+/* xml tag items are turned into begin/end items, end tag is found once */
+UltimateLyricsProvider::Program UltimateLyricsProvider::CompileRule(const Rule& rule)
+{
+    static const QRegExp tag_re("<(\\w+).*>");
+
+    Program program;
+    foreach (const RuleItem& item, rule) {
+      Step step;
+      step.begin  = item.first;
+      step.fields = item.first.contains('{');
+      step.valid  = true;
+
+      if (item.second.isNull()) {
+        QRegExp re(tag_re);
+        step.valid = re.indexIn(item.first) != -1;
+        step.end   = step.valid ? "</" + re.cap(1) + ">" : QString();
+      }
+      else {
+        step.end = item.second;
+      }
+
+      program << step;
+    }
+
+    return program;
 }
 
 void UltimateLyricsProvider::FetchInfo(INFO::InfoRequestData request)
 {
     //Debug::debug() << name() << " fetch info ";
 
-    const QTextCodec* codec = QTextCodec::codecForName(charset_.toAscii().constData());
-    if (!codec) {
+    if (!codec_) {
       qWarning() << "Invalid codec" << charset_;
       emit Finished(request);
       return;
@@ -47,12 +86,7 @@ void UltimateLyricsProvider::FetchInfo(INFO::InfoRequestData request)
 
     //! Fill in fields in the URL
     //Debug::debug() << " ---- UltimateLyricsProvider::base url " << url_;
-
-    lyrics_url_ = url_;
-    ReplaceFields(request, &lyrics_url_);
-
-    //Debug::debug() << " ---- UltimateLyricsProvider::complete url " << lyrics_url_;
-    QUrl url(lyrics_url_);
+    QUrl url(LyricsUrl(request));
 
     QObject *reply = HTTP()->get( url );
     m_requests[reply] = request;
@@ -62,6 +96,22 @@ void UltimateLyricsProvider::FetchInfo(INFO::InfoRequestData request)
 }
 
 
+void UltimateLyricsProvider::CancelInfo(INFO::InfoRequestData request)
+{
+    INFO::abortRequests(m_requests, request.requestId);
+}
+
+
+/* base url + metadata, computed per request as searches run concurrently */
+QString UltimateLyricsProvider::LyricsUrl(INFO::InfoRequestData request) const
+{
+    QString lyrics_url = url_;
+    ReplaceFields(request, &lyrics_url);
+
+    return lyrics_url;
+}
+
+
 void UltimateLyricsProvider::signalFinish()
 {
     QObject* reply = qobject_cast<QObject*>(sender());
@@ -82,49 +132,12 @@ void UltimateLyricsProvider::LyricsFetched(QByteArray bytes)
 
     INFO::InfoRequestData request =  m_requests.take(reply);
 
-    const QTextCodec* codec = QTextCodec::codecForName(charset_.toAscii().constData());
-    const QString original_content = codec->toUnicode(bytes);
-    //Debug::debug() << "[UltimateLyricsProvider] original_content :" << original_content;
-
-    QString lyrics;
-
-    // Check for invalid indicators
-    foreach (const QString& indicator, invalid_indicators_) {
-      if (original_content.contains(indicator)) {
-        emit Finished(request);
-        return;
-      }
-    }
-
-    
-    // Apply extract rules
-    foreach (const Rule& rule, extract_rules_) {
-      // Modify the rule for this request's metadata
-      Rule rule_copy(rule);
-      for (Rule::iterator it = rule_copy.begin() ; it != rule_copy.end() ; ++it) {
-        ReplaceFields(request, &it->first);
-      }
-
-      QString content = original_content;
-      ApplyExtractRule(rule_copy, &content);
-      //Debug::debug() << "Extract rule" << rule_copy << "matched" << content.length();
-
-      if (!content.isEmpty()) {
-        lyrics = content;
-        break;
-      }
-    }
-
-    // Apply exclude rules
-    foreach (const Rule& rule, exclude_rules_) {
-      ApplyExcludeRule(rule, &lyrics);
-    }
-
+    const QString lyrics = ExtractLyrics(request, codec_->toUnicode(bytes));
     //Debug::debug() << "[UltimateLyricsProvider] lyrics :" << lyrics;
     
     if (!lyrics.isEmpty()) {
       //Debug::debug() << "[UltimateLyricsProvider] :" << name_ << " emit InfoReady !!";
-      emit InfoReady(request, lyrics);
+      emit InfoReady(request, lyrics, LyricsUrl(request));
     }
     else {
       /* WARNING CHANGE FOR YAROCK : only emit Finished in case of No Lyrics WARNING*/
@@ -134,64 +147,77 @@ void UltimateLyricsProvider::LyricsFetched(QByteArray bytes)
 }
 
 
-void UltimateLyricsProvider::ApplyExtractRule(const Rule& rule, QString* content) const
+/* lyrics of a provider page, empty when page is invalid or rules do not match */
+QString UltimateLyricsProvider::ExtractLyrics(INFO::InfoRequestData request, const QString& original_content) const
 {
-    foreach (const RuleItem& item, rule) {
-      if (item.second.isNull()) {
-        *content = ExtractXmlTag(*content, item.first);
-      }
-      else {
-        *content = Extract(*content, item.first, item.second);
-      }
-    }
-}
-
+    //Debug::debug() << "[UltimateLyricsProvider] original_content :" << original_content;
 
-QString UltimateLyricsProvider::ExtractXmlTag(const QString& source, const QString& tag)
-{
-    QRegExp re("<(\\w+).*>");
-    if (re.indexIn(tag) == -1)
-      return QString();
+    QString lyrics;
 
-    return Extract(source, tag, "</" + re.cap(1) + ">");
-}
+    // Check for invalid indicators
+    foreach (const QString& indicator, invalid_indicators_) {
+      if (original_content.contains(indicator))
+        return QString();
+    }
 
+    
+    // Apply extract rules, page is only copied for the matching part
+    foreach (const Program& rule, extract_rules_) {
+      int from = 0;
+      int to   = original_content.length();
 
-QString UltimateLyricsProvider::Extract(const QString& source, const QString& begin, const QString& end)
-{
-    int begin_idx = source.indexOf(begin);
-    if (begin_idx == -1)
-      return QString();
-    begin_idx += begin.length();
+      if (ApplyExtractRule(rule, request, original_content, &from, &to)) {
+        lyrics = original_content.mid(from, to - from);
+        break;
+      }
+    }
 
-    int end_idx = source.indexOf(end, begin_idx);
-    if (end_idx == -1)
-      return QString();
+    // Apply exclude rules
+    foreach (const Program& rule, exclude_rules_) {
+      ApplyExcludeRule(rule, &lyrics);
+    }
 
-    return source.mid(begin_idx, end_idx - begin_idx - 1);
+    return lyrics;
 }
 
 
-void UltimateLyricsProvider::ApplyExcludeRule(const Rule& rule, QString* content) const
+/* each step narrows the [from, to) window of source, matches must stay inside it */
+bool UltimateLyricsProvider::ApplyExtractRule(const Program& rule, INFO::InfoRequestData request,
+                                              const QString& source, int* from, int* to) const
 {
-    foreach (const RuleItem& item, rule) {
-      if (item.second.isNull()) {
-        *content = ExcludeXmlTag(*content, item.first);
-      }
-      else {
-        *content = Exclude(*content, item.first, item.second);
-      }
+    foreach (const Step& step, rule) {
+      if (!step.valid)
+        return false;
+
+      QString begin = step.begin;
+      if (step.fields)
+        ReplaceFields(request, &begin);
+
+      int begin_idx = source.indexOf(begin, *from);
+      if (begin_idx == -1 || begin_idx + begin.length() > *to)
+        return false;
+      begin_idx += begin.length();
+
+      const int end_idx = source.indexOf(step.end, begin_idx);
+      if (end_idx == -1 || end_idx + step.end.length() > *to)
+        return false;
+
+      /* last char before end is dropped, an empty match keeps the window end */
+      *from = begin_idx;
+      if (end_idx - begin_idx - 1 >= 0)
+        *to = end_idx - 1;
     }
+
+    return *to > *from;
 }
 
 
-QString UltimateLyricsProvider::ExcludeXmlTag(const QString& source, const QString& tag)
+void UltimateLyricsProvider::ApplyExcludeRule(const Program& rule, QString* content) const
 {
-    QRegExp re("<(\\w+).*>");
-    if (re.indexIn(tag) == -1)
-      return source;
-
-    return Exclude(source, tag, "</" + re.cap(1) + ">");
+    foreach (const Step& step, rule) {
+      if (step.valid)
+        *content = Exclude(*content, step.begin, step.end);
+    }
 }
 
 
@@ -236,10 +262,8 @@ void UltimateLyricsProvider::ReplaceField(const QString& tag, const QString& val
 
     // Apply URL character replacement
     QString value_copy(value);
-    foreach (const UrlFormat& format, url_formats_) {
-      QRegExp re("[" + QRegExp::escape(format.first) + "]");
-      value_copy.replace(re, format.second);
-    }
+    for (int i = 0; i < url_formats_.size(); ++i)
+      value_copy.replace(url_formats_.at(i).first, url_formats_.at(i).second);
 
     text->replace(tag, value_copy, Qt::CaseInsensitive);
 }
@@ -23,9 +23,12 @@
 
 #include <QObject>
 #include <QPair>
+#include <QRegExp>
 #include <QStringList>
 
 #include "info_system.h"
+
+class QTextCodec;
 /*
 ********************************************************************************
 *                                                                              *
@@ -49,31 +52,42 @@ public:
   void set_name(const QString& name) { name_ = name; }
   void set_title(const QString& title) { title_ = title; }
   void set_url(const QString& url) { url_ = url; }
-  void set_charset(const QString& charset) { charset_ = charset; }
+  void set_charset(const QString& charset);
 
-  void add_url_format(const QString& replace, const QString& with) {
-    url_formats_ << UrlFormat(replace, with); }
+  void add_url_format(const QString& replace, const QString& with);
 
-  void add_extract_rule(const Rule& rule) { extract_rules_ << rule; }
-  void add_exclude_rule(const Rule& rule) { exclude_rules_ << rule; }
+  void add_extract_rule(const Rule& rule) { extract_rules_ << CompileRule(rule); }
+  void add_exclude_rule(const Rule& rule) { exclude_rules_ << CompileRule(rule); }
   void add_invalid_indicator(const QString& indicator) { invalid_indicators_ << indicator; }
 
   QString name() const { return name_; }
 
   void FetchInfo(INFO::InfoRequestData request);
-  QString lyricsUrl() {return lyrics_url_;}
+  void CancelInfo(INFO::InfoRequestData request);
+
+  /* page to lyrics, empty if none (public for lyrics_extract_bench) */
+  QString ExtractLyrics(INFO::InfoRequestData request, const QString& content) const;
 
 private slots:
   void signalFinish();
   void LyricsFetched(QByteArray bytes);
 
 private:
-  void ApplyExtractRule(const Rule& rule, QString* content) const;
-  void ApplyExcludeRule(const Rule& rule, QString* content) const;
+  /* rule item compiled at parse time, xml tag items get their end tag */
+  struct Step {
+    QString begin;
+    QString end;
+    bool    fields;   /* begin holds {fields} replaced for each request */
+    bool    valid;
+  };
+  typedef QList<Step> Program;
+
+  static Program CompileRule(const Rule& rule);
+
+  bool ApplyExtractRule(const Program& rule, INFO::InfoRequestData request,
+                        const QString& source, int* from, int* to) const;
+  void ApplyExcludeRule(const Program& rule, QString* content) const;
 
-  static QString ExtractXmlTag(const QString& source, const QString& tag);
-  static QString Extract(const QString& source, const QString& begin, const QString& end);
-  static QString ExcludeXmlTag(const QString& source, const QString& tag);
   static QString Exclude(const QString& source, const QString& begin, const QString& end);
   static QString FirstChar(const QString& text);
   static QString TitleCase(const QString& text);
@@ -81,6 +95,7 @@ private:
 
   void ReplaceField(const QString& tag, const QString& value, QString* text) const;
   void ReplaceFields(INFO::InfoRequestData request, QString* text) const;
+  QString LyricsUrl(INFO::InfoRequestData request) const;
 
 private:
   QMap<QObject*, INFO::InfoRequestData> m_requests;
@@ -88,16 +103,16 @@ private:
   QString name_;
   QString title_;
   QString url_;        // base url
-  QString lyrics_url_; // base url + metadata
   QString charset_;
+  QTextCodec* codec_;
 
-  QList<UrlFormat> url_formats_;
-  QList<Rule> extract_rules_;
-  QList<Rule> exclude_rules_;
+  QList< QPair<QRegExp, QString> > url_formats_;
+  QList<Program> extract_rules_;
+  QList<Program> exclude_rules_;
   QStringList invalid_indicators_;
 
 signals:
-  void InfoReady(INFO::InfoRequestData request, const QString &lyrics);
+  void InfoReady(INFO::InfoRequestData request, const QString &lyrics, const QString &url);
   void Finished(INFO::InfoRequestData request);
 };
 
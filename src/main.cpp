@@ -174,7 +174,6 @@ int main(int argc, char *argv[])
     QDir().mkpath(UTIL::CONFIGDIR);
     QDir().mkpath(UTIL::CONFIGDIR + "/radio");
     QDir().mkpath(UTIL::CONFIGDIR + "/download");
-    QDir().mkpath(UTIL::CONFIGDIR + "/albums");
     QDir().mkpath(UTIL::CONFIGDIR + "/lyrics");
 
     //! Qt Type registration
@@ -189,6 +188,7 @@ int main(int argc, char *argv[])
     qRegisterMetaType<MEDIA::ArtistPtr>();
     qRegisterMetaType<MEDIA::AlbumPtr>();
     qRegisterMetaType<MEDIA::TrackPtr>();
+    qRegisterMetaType< QList<MEDIA::TrackPtr> >();
     qRegisterMetaType<MEDIA::PlaylistPtr>();
 
     //! mainwindows start
@@ -41,6 +41,7 @@
 
 #include "playqueue/playqueue_model.h"
 #include "playqueue/task_manager.h"
+#include "playqueue/playqueue_session.h"
 
 
 // views
@@ -67,6 +68,7 @@
 
 #include "networkaccess.h"
 #include "covercache.h"
+#include "coverstore.h"
 
 #include "global_actions.h"
 #include "constants.h"
@@ -146,6 +148,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
 
     //! ############### global instance #####################################
     new RatingPainter();
+    new CoverStore();
     new CoverCache();
     
     //! ############### init menu part  ################################
@@ -157,6 +160,7 @@ MainWindow::MainWindow(QWidget *parent) : QMainWindow(parent)
 
     //! ############### init playqueue part  ################################
     m_playqueue = new Playqueue();
+    m_playqueue_session = new PlayqueueSession(m_playqueue, this);
         
     _playlistView    = new PlaylistView(this, m_playqueue);
     _nowplayingview  = new NowPlayingView(this);
@@ -261,18 +265,14 @@ MainWindow::~MainWindow()
     if(SETTINGS()->_restartPlayingAtStartup)
       savePlayingTrack();
 
+    //! Save current playqueue session (before stop to keep played state)
+    m_playqueue_session->save();
+
     _player->stop();
 
-    //! Save current playlist to file
-    if(m_playqueue->rowCount() <= 0)
-    {
-        if( QFile::exists(UTIL::CONFIGDIR + "/last.xspf") )
-          QFile::remove(UTIL::CONFIGDIR + "/last.xspf");
-    }
-    else
-    {
-      m_playqueue->manager()->playlistSaveToFile(QString(UTIL::CONFIGDIR).append("/last.xspf"));
-    }
+    //! playqueue from previous versions has been restored, not needed anymore
+    if( QFile::exists(UTIL::CONFIGDIR + "/last.xspf") )
+      QFile::remove(UTIL::CONFIGDIR + "/last.xspf");
 
     m_thread_manager->stopThread();
 
@@ -1156,8 +1156,15 @@ void MainWindow::slot_database_start()
 
     if(is_first_start) {
       //! ############### restore last playqueue content ########################
-      if( SETTINGS()->_restorePlayqueue && QFile::exists(UTIL::CONFIGDIR + "/last.xspf") )
-        m_playqueue->manager()->playlistAddFile(QString(UTIL::CONFIGDIR).append("/last.xspf"));
+      if( SETTINGS()->_restorePlayqueue )
+      {
+        if( !m_playqueue_session->restoreOnPopulated() && QFile::exists(UTIL::CONFIGDIR + "/last.xspf") )
+          m_playqueue->manager()->playlistAddFile(QString(UTIL::CONFIGDIR).append("/last.xspf"));
+      }
+      else
+      {
+        m_playqueue_session->discard();
+      }
 
       is_first_start = false;
     }
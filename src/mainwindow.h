@@ -39,6 +39,7 @@ class CentralToolBar;
 
 // Model
 class PlayqueueModel;
+class PlayqueueSession;
 class LocalTrackModel;
 class LocalPlaylistModel;
 class StreamModel;
@@ -163,6 +164,7 @@ Q_OBJECT
     PlaylistView          *_playlistView;
     
     PlayqueueModel        *m_playqueue;
+    PlayqueueSession      *m_playqueue_session;
 
     PlaylistWidget        *_playlistwidget;
     NowPlayingView        *_nowplayingview;
@@ -21,6 +21,7 @@
 #include "debug.h"
 
 #include <QRegExp>
+#include <QMutexLocker>
 
 LocalTrackModel* LocalTrackModel::INSTANCE = 0;
 
@@ -67,6 +68,19 @@ void LocalTrackModel::clear()
 }
 
 
+QSharedPointer<const SuggestionIndex> LocalTrackModel::suggestionIndex()
+{
+    QMutexLocker locker(&m_suggestion_mutex);
+    return m_suggestion_index;
+}
+
+void LocalTrackModel::setSuggestionIndex(QSharedPointer<const SuggestionIndex> index)
+{
+    QMutexLocker locker(&m_suggestion_mutex);
+    m_suggestion_index = index;
+}
+
+
 bool LocalTrackModel::isEmpty() const
 {
     return m_rootItem->childCount() == 0;
@@ -153,21 +167,41 @@ float LocalTrackModel::getItemAutoRating(const MEDIA::MediaPtr media)
 //! ------------------------- filtering method ---------------------------------
 bool LocalTrackModel::matches(const QString text) const
 {
-    if(m_filter_pattern.length() < 3)
-      return text.startsWith ( m_filter_pattern, Qt::CaseInsensitive );
-    else
-      return text.contains ( m_filter_pattern, Qt::CaseInsensitive );
+    return matches(text, m_filter_pattern);
 }
 
+bool LocalTrackModel::isArtistFiltered(const MEDIA::ArtistPtr artistItem)
+{
+    return isArtistFiltered(artistItem, m_filter_pattern);
+}
 
+bool LocalTrackModel::isAlbumFiltered(const MEDIA::AlbumPtr albumItem)
+{
+    return isAlbumFiltered(albumItem, m_filter_pattern);
+}
 
-bool LocalTrackModel::isArtistFiltered(const MEDIA::ArtistPtr artistItem)
+bool LocalTrackModel::isTrackFiltered(const MEDIA::TrackPtr trackItem)
 {
-    if (m_filter_pattern.isEmpty()) return true;
+    return isTrackFiltered(trackItem, m_filter_pattern);
+}
+
+
+bool LocalTrackModel::matches(const QString& text, const QString& filter)
+{
+    if(filter.length() < 3)
+      return text.startsWith ( filter, Qt::CaseInsensitive );
+    else
+      return text.contains ( filter, Qt::CaseInsensitive );
+}
+
+
+bool LocalTrackModel::isArtistFiltered(const MEDIA::ArtistPtr artistItem, const QString& filter)
+{
+    if (filter.isEmpty()) return true;
     if (!artistItem) return false;
 
     //! check artist item
-    if(matches(artistItem->name))
+    if(matches(artistItem->name, filter))
       return true;
    
     //! check child album
@@ -175,7 +209,7 @@ bool LocalTrackModel::isArtistFiltered(const MEDIA::ArtistPtr artistItem)
     {
       MEDIA::AlbumPtr albumItem = MEDIA::AlbumPtr::staticCast( artistItem->child(i) );
 
-      if(matches(albumItem->name))
+      if(matches(albumItem->name, filter))
         return true;
 
       //! check child track
@@ -183,7 +217,7 @@ bool LocalTrackModel::isArtistFiltered(const MEDIA::ArtistPtr artistItem)
       {
         MEDIA::TrackPtr trackItem = MEDIA::TrackPtr::staticCast( albumItem->child(j) );
 
-        if(matches(trackItem->url) || matches(trackItem->genre))
+        if(matches(trackItem->url, filter) || matches(trackItem->genre, filter))
           return true;
        }
     }
@@ -191,18 +225,18 @@ bool LocalTrackModel::isArtistFiltered(const MEDIA::ArtistPtr artistItem)
     return false;
 }
 
-bool LocalTrackModel::isAlbumFiltered(const MEDIA::AlbumPtr albumItem)
+bool LocalTrackModel::isAlbumFiltered(const MEDIA::AlbumPtr albumItem, const QString& filter)
 {
-    if (m_filter_pattern.isEmpty()) return true;
+    if (filter.isEmpty()) return true;
     if (!albumItem) return false;
 
     //! check album item
-    if(matches(albumItem->name))
+    if(matches(albumItem->name, filter))
       return true;
 
     //! check artist parent
     MEDIA::ArtistPtr artistItem = MEDIA::ArtistPtr::staticCast( albumItem->parent() );
-    if(matches(artistItem->name))
+    if(matches(artistItem->name, filter))
       return true;
   
     //! check child track
@@ -210,7 +244,7 @@ bool LocalTrackModel::isAlbumFiltered(const MEDIA::AlbumPtr albumItem)
     {
       MEDIA::TrackPtr trackItem = MEDIA::TrackPtr::staticCast( albumItem->child(i) );
 
-      if(matches(trackItem->url) || matches(trackItem->genre))
+      if(matches(trackItem->url, filter) || matches(trackItem->genre, filter))
         return true;
     }
 
@@ -218,14 +252,14 @@ bool LocalTrackModel::isAlbumFiltered(const MEDIA::AlbumPtr albumItem)
 }
 
 
-bool LocalTrackModel::isTrackFiltered(const MEDIA::TrackPtr trackItem)
+bool LocalTrackModel::isTrackFiltered(const MEDIA::TrackPtr trackItem, const QString& filter)
 {
-    if (m_filter_pattern.isEmpty()) return true;
+    if (filter.isEmpty()) return true;
     if (!trackItem) return false;
 
     //! check track item
-    if (matches(trackItem->url) || matches(trackItem->genre) ||
-        matches(trackItem->artist) || matches(trackItem->album))
+    if (matches(trackItem->url, filter) || matches(trackItem->genre, filter) ||
+        matches(trackItem->artist, filter) || matches(trackItem->album, filter))
       return true;
 
     return false;
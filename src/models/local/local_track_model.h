@@ -22,8 +22,11 @@
 #include <QString>
 #include <QStringList>
 #include <QObject>
+#include <QSharedPointer>
+#include <QMutex>
 
 #include "core/mediaitem/mediaitem.h"
+#include "suggestion_index.h"
 
 /*
 ********************************************************************************
@@ -60,6 +63,17 @@ Q_OBJECT
      bool isAlbumFiltered(const MEDIA::AlbumPtr albumItem);
      bool isArtistFiltered(const MEDIA::ArtistPtr  artistItem);
      void setFilter(const QString & f) {m_filter_pattern = f;}
+     QString filter() const {return m_filter_pattern;}
+
+     //! filtering method with explicit pattern (reentrant)
+     static bool matches(const QString& text, const QString& filter);
+     static bool isTrackFiltered(const MEDIA::TrackPtr trackItem, const QString& filter);
+     static bool isAlbumFiltered(const MEDIA::AlbumPtr albumItem, const QString& filter);
+     static bool isArtistFiltered(const MEDIA::ArtistPtr  artistItem, const QString& filter);
+
+     //! search suggestion index (thread safe)
+     QSharedPointer<const SuggestionIndex> suggestionIndex();
+     void setSuggestionIndex(QSharedPointer<const SuggestionIndex> index);
 
      //! list of MediaItem
      QHash<int, MEDIA::TrackPtr> trackItemHash;
@@ -75,6 +89,9 @@ Q_OBJECT
      MEDIA::MediaPtr  m_rootItem;
      MEDIA::TrackPtr  m_playing_track;
      QString          m_filter_pattern;
+
+     QSharedPointer<const SuggestionIndex>  m_suggestion_index;
+     QMutex                                 m_suggestion_mutex;
      
 };
 
@@ -17,6 +17,7 @@
 
 #include "local_track_populator.h"
 #include "local_track_model.h"
+#include "suggestion_index.h"
 #include "core/mediaitem/mediaitem.h"
 
 #include "core/database/database.h"
@@ -91,6 +92,8 @@ void LocalTrackPopulator::run()
     QVariant track_id  = -1;
     QString prev_album_hash = QString();
 
+    QSharedPointer<SuggestionIndex> suggestion_index(new SuggestionIndex());
+
     QSqlQuery query_1("SELECT artist_id,artist_name,artist_favorite,artist_playcount,artist_rating, \
                               album_id,album_name,album_year,album_cover,album_favorite,album_playcount,album_rating,album_disc, \
                               id,trackname,filename,number,genre_name,length,albumgain,albumpeakgain,trackgain,trackpeakgain,last_played,playcount,rating \
@@ -178,6 +181,7 @@ void LocalTrackPopulator::run()
         trackItem->setParent(albumItem);
         m_model->trackItemHash[trackItem->id] = trackItem;
         m_model->trackByGenre << trackItem;
+        suggestion_index->addTrack(trackItem);
 
         _progress++;
       }
@@ -218,6 +222,12 @@ void LocalTrackPopulator::run()
     //! Sort Media Track Item list By Genre
     qSort(m_model->trackByGenre.begin(), m_model->trackByGenre.end(),MEDIA::compareTrackItemGenre);
 
+    //! Build search popup suggestion index
+    if(!m_exit) {
+      suggestion_index->build();
+      m_model->setSuggestionIndex(suggestion_index);
+    }
+
            
     /*-----------------------------------------------------------*/
     /* End                                                       */
@@ -0,0 +1,238 @@
+/****************************************************************************************
+*  YAROCK                                                                               *
+*  Copyright (c) 2010-2014 Sebastien amardeilh <sebastien.amardeilh+yarock@gmail.com>   *
+*                                                                                       *
+*  This program is free software; you can redistribute it and/or modify it under        *
+*  the terms of the GNU General Public License as published by the Free Software        *
+*  Foundation; either version 2 of the License, or (at your option) any later           *
+*  version.                                                                             *
+*                                                                                       *
+*  This program is distributed in the hope that it will be useful, but WITHOUT ANY      *
+*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A      *
+*  PARTICULAR PURPOSE. See the GNU General Public License for more details.             *
+*                                                                                       *
+*  You should have received a copy of the GNU General Public License along with         *
+*  this program.  If not, see <http://www.gnu.org/licenses/>.                           *
+*****************************************************************************************/
+
+#include "suggestion_index.h"
+#include "debug.h"
+
+#include <QSet>
+#include <QtAlgorithms>
+
+/*******************************************************************************
+    compareSuffix
+      lexicographic compare of str[offset..] with other
+*******************************************************************************/
+static int compareSuffix(const QString& str, int offset, const QString& other, int other_offset = 0)
+{
+    const QChar* a = str.constData() + offset;
+    const QChar* b = other.constData() + other_offset;
+    const int len_a = str.size() - offset;
+    const int len_b = other.size() - other_offset;
+    const int len   = qMin(len_a, len_b);
+
+    for(int i = 0; i < len; i++) {
+      if(a[i] != b[i])
+        return a[i].unicode() < b[i].unicode() ? -1 : 1;
+    }
+
+    return len_a - len_b;
+}
+
+static bool startsWithAt(const QString& str, int offset, const QString& prefix)
+{
+    if(str.size() - offset < prefix.size())
+      return false;
+
+    const QChar* a = str.constData() + offset;
+    const QChar* b = prefix.constData();
+    for(int i = 0; i < prefix.size(); i++)
+      if(a[i] != b[i]) return false;
+
+    return true;
+}
+
+/*
+********************************************************************************
+*                                                                              *
+*    Class SuggestionIndex                                                     *
+*                                                                              *
+********************************************************************************
+*/
+class SuggestionIndex::KeyLessThan
+{
+  public:
+    KeyLessThan(const QVector<Entry>& entries) : m_entries(entries) {}
+
+    bool operator()(const Key& k1, const Key& k2) const
+    {
+        return compareSuffix(m_entries.at(k1.entry).folded, k1.offset,
+                             m_entries.at(k2.entry).folded, k2.offset) < 0;
+    }
+
+  private:
+    const QVector<Entry>& m_entries;
+};
+
+class SuggestionIndex::PlaycountGreaterThan
+{
+  public:
+    PlaycountGreaterThan(const QVector<Entry>& entries) : m_entries(entries) {}
+
+    bool operator()(int e1, int e2) const
+    {
+        return m_entries.at(e1).playcount > m_entries.at(e2).playcount;
+    }
+
+  private:
+    const QVector<Entry>& m_entries;
+};
+
+
+SuggestionIndex::SuggestionIndex()
+{
+}
+
+/*******************************************************************************
+    addTrack
+*******************************************************************************/
+void SuggestionIndex::addTrack(const MEDIA::TrackPtr track)
+{
+    addName(ARTIST, track->artist, track->playcount);
+    addName(ALBUM,  track->album,  track->playcount);
+    addName(TITLE,  track->title,  track->playcount);
+}
+
+void SuggestionIndex::addName(E_CATEGORY category, const QString& text, int playcount)
+{
+    if(text.isEmpty())
+      return;
+
+    QHash<QString, int>::const_iterator it = m_lookup[category].constFind(text);
+    if(it != m_lookup[category].constEnd()) {
+      m_entries[category][it.value()].playcount += playcount;
+      return;
+    }
+
+    Entry entry;
+    entry.text      = text;
+    entry.folded    = text.toCaseFolded();
+    entry.playcount = playcount;
+
+    m_lookup[category].insert(text, m_entries[category].size());
+    m_entries[category].append(entry);
+}
+
+/*******************************************************************************
+    build
+*******************************************************************************/
+void SuggestionIndex::build()
+{
+    for(int c = 0; c < CATEGORY_COUNT; c++)
+    {
+      m_lookup[c].clear();
+
+      const QVector<Entry>& entries = m_entries[c];
+      m_prefix_keys[c].reserve(entries.size());
+
+      for(int i = 0; i < entries.size(); i++)
+      {
+        const QString& folded = entries.at(i).folded;
+
+        Key key;
+        key.entry  = i;
+        key.offset = 0;
+        m_prefix_keys[c].append(key);
+        m_word_keys[c].append(key);
+
+        for(int pos = 1; pos < folded.size(); pos++) {
+          if(!folded.at(pos - 1).isLetterOrNumber() && folded.at(pos).isLetterOrNumber()) {
+            key.offset = pos;
+            m_word_keys[c].append(key);
+          }
+        }
+      }
+
+      qSort(m_prefix_keys[c].begin(), m_prefix_keys[c].end(), KeyLessThan(entries));
+      qSort(m_word_keys[c].begin(), m_word_keys[c].end(), KeyLessThan(entries));
+    }
+
+    Debug::debug() << "SuggestionIndex::build artists:" << m_entries[ARTIST].size()
+                   << "albums:" << m_entries[ALBUM].size()
+                   << "titles:" << m_entries[TITLE].size();
+}
+
+/*******************************************************************************
+    lowerBound
+*******************************************************************************/
+int SuggestionIndex::lowerBound(const QVector<Key>& keys, const QVector<Entry>& entries, const QString& query) const
+{
+    int first = 0;
+    int count = keys.size();
+
+    while (count > 0) {
+      const int step = count / 2;
+      const Key& key = keys.at(first + step);
+
+      if(compareSuffix(entries.at(key.entry).folded, key.offset, query) < 0) {
+        first += step + 1;
+        count -= step + 1;
+      }
+      else {
+        count = step;
+      }
+    }
+
+    return first;
+}
+
+/*******************************************************************************
+    find
+*******************************************************************************/
+QStringList SuggestionIndex::find(E_CATEGORY category, const QString& query, int max) const
+{
+    QStringList result;
+
+    const QString folded_query   = query.toCaseFolded();
+    const QVector<Entry>& entries = m_entries[category];
+    const QVector<Key>& keys      = (query.length() < 3) ? m_prefix_keys[category] : m_word_keys[category];
+
+    if(folded_query.isEmpty() || keys.isEmpty())
+      return result;
+
+    if(max <= 0)
+      return result;
+
+    /* rank distinct matching entries while scanning, only the best <max>
+       are kept. Inserting after equal playcounts keeps alphabetical order */
+    const PlaycountGreaterThan greater(entries);
+    QList<int>    matches;
+    QSet<int>     seen;
+
+    for(int i = lowerBound(keys, entries, folded_query); i < keys.size(); i++)
+    {
+      const Key& key = keys.at(i);
+      if(!startsWithAt(entries.at(key.entry).folded, key.offset, folded_query))
+        break;
+
+      if(seen.contains(key.entry))
+        continue;
+      seen.insert(key.entry);
+
+      if(matches.size() == max && !greater(key.entry, matches.last()))
+        continue;
+
+      QList<int>::iterator it = qUpperBound(matches.begin(), matches.end(), key.entry, greater);
+      matches.insert(it, key.entry);
+
+      if(matches.size() > max)
+        matches.removeLast();
+    }
+
+    for(int i = 0; i < matches.size(); i++)
+      result << entries.at(matches.at(i)).text;
+
+    return result;
+}
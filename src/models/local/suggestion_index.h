@@ -0,0 +1,76 @@
+/****************************************************************************************
+*  YAROCK                                                                               *
+*  Copyright (c) 2010-2014 Sebastien amardeilh <sebastien.amardeilh+yarock@gmail.com>   *
+*                                                                                       *
+*  This program is free software; you can redistribute it and/or modify it under        *
+*  the terms of the GNU General Public License as published by the Free Software        *
+*  Foundation; either version 2 of the License, or (at your option) any later           *
+*  version.                                                                             *
+*                                                                                       *
+*  This program is distributed in the hope that it will be useful, but WITHOUT ANY      *
+*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A      *
+*  PARTICULAR PURPOSE. See the GNU General Public License for more details.             *
+*                                                                                       *
+*  You should have received a copy of the GNU General Public License along with         *
+*  this program.  If not, see <http://www.gnu.org/licenses/>.                           *
+*****************************************************************************************/
+#ifndef _SUGGESTION_INDEX_H_
+#define _SUGGESTION_INDEX_H_
+
+#include "core/mediaitem/mediaitem.h"
+
+#include <QString>
+#include <QStringList>
+#include <QVector>
+#include <QHash>
+
+/*
+********************************************************************************
+*                                                                              *
+*    Class SuggestionIndex                                                     *
+*      sorted index of distinct artist, album and title names used by the      *
+*      search popup completer. Built by LocalTrackPopulator, read only after   *
+*      build() so it can be queried from any thread.                           *
+*                                                                              *
+********************************************************************************
+*/
+class SuggestionIndex
+{
+  public:
+    enum E_CATEGORY { ARTIST = 0, ALBUM = 1, TITLE = 2, CATEGORY_COUNT = 3 };
+
+    SuggestionIndex();
+
+    void addTrack(const MEDIA::TrackPtr track);
+    void build();
+
+    /* return at most max names starting with query (query < 3 chars) or
+       containing a word starting with query, ranked by playcount */
+    QStringList find(E_CATEGORY category, const QString& query, int max) const;
+
+  private:
+    struct Entry {
+      QString  text;
+      QString  folded;
+      int      playcount;
+    };
+
+    /* position of a searchable suffix : entry index + offset in folded text */
+    struct Key {
+      int      entry;
+      int      offset;
+    };
+
+    class KeyLessThan;
+    class PlaycountGreaterThan;
+
+    void addName(E_CATEGORY category, const QString& text, int playcount);
+    int lowerBound(const QVector<Key>& keys, const QVector<Entry>& entries, const QString& query) const;
+
+    QVector<Entry>       m_entries[CATEGORY_COUNT];
+    QVector<Key>         m_prefix_keys[CATEGORY_COUNT];  // whole name only
+    QVector<Key>         m_word_keys[CATEGORY_COUNT];    // every word start
+    QHash<QString, int>  m_lookup[CATEGORY_COUNT];       // used while building
+};
+
+#endif // _SUGGESTION_INDEX_H_
@@ -18,10 +18,191 @@
 
 #include "networkaccess.h"
 #include "constants.h"
+#include "utilities.h"
 #include "debug.h"
 
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDir>
+#include <QFile>
+
 static QMap< QThread*, QNetworkAccessManager* > s_threadNamHash;
 
+/* http cache size on disk */
+static const qint64 HTTP_CACHE_SIZE = 50 * 1024 * 1024;
+
+/*
+  capture file (record/replay mode), one per request
+    magic, version, url, http status, error code, error string,
+    redirection target, raw headers count, raw headers, body
+*/
+static const quint32 CAPTURE_MAGIC   = 0x594e4554; /* YNET */
+static const quint32 CAPTURE_VERSION = 1;
+
+static const char*   CAPTURE_KEY_PROPERTY = "captureKey";
+
+/*
+********************************************************************************
+*                                                                              *
+*    Class HttpCache                                                           *
+*      -> one per access manager, all share the same disk cache                *
+*      -> access manager revalidates stale entries with ETag and               *
+*         Last-Modified, a 304 answer is served from disk                      *
+*                                                                              *
+********************************************************************************
+*/
+class HttpCache : public QAbstractNetworkCache
+{
+  public:
+    HttpCache(QNetworkDiskCache* cache, QMutex* mutex) : m_cache(cache), m_mutex(mutex) {}
+
+    QNetworkCacheMetaData metaData(const QUrl& url)
+    {
+      QMutexLocker locker(m_mutex);
+      return m_cache->metaData(url);
+    }
+
+    void updateMetaData(const QNetworkCacheMetaData& metaData)
+    {
+      QMutexLocker locker(m_mutex);
+      m_cache->updateMetaData(metaData);
+    }
+
+    QIODevice* data(const QUrl& url)
+    {
+      QMutexLocker locker(m_mutex);
+      return m_cache->data(url);
+    }
+
+    bool remove(const QUrl& url)
+    {
+      QMutexLocker locker(m_mutex);
+      return m_cache->remove(url);
+    }
+
+    qint64 cacheSize() const
+    {
+      QMutexLocker locker(m_mutex);
+      return m_cache->cacheSize();
+    }
+
+    /* device is filled by the reply thread, then given back with insert() */
+    QIODevice* prepare(const QNetworkCacheMetaData& metaData)
+    {
+      QMutexLocker locker(m_mutex);
+      return m_cache->prepare(metaData);
+    }
+
+    void insert(QIODevice* device)
+    {
+      QMutexLocker locker(m_mutex);
+      m_cache->insert(device);
+    }
+
+    void clear()
+    {
+      QMutexLocker locker(m_mutex);
+      m_cache->clear();
+    }
+
+  private:
+    QNetworkDiskCache  *m_cache;
+    QMutex             *m_mutex;
+};
+
+/*
+********************************************************************************
+*                                                                              *
+*    Class ReplayReply                                                         *
+*      -> reply read from a capture file, signals are sent from event loop     *
+*         as for a network reply                                               *
+*                                                                              *
+********************************************************************************
+*/
+class ReplayReply : public QNetworkReply
+{
+  public:
+    ReplayReply(const QNetworkRequest& request, int operation, const QString& path, QObject* parent)
+      : QNetworkReply(parent), m_offset(0)
+    {
+      setRequest(request);
+      setUrl(request.url());
+      setOperation(QNetworkAccessManager::Operation(operation));
+
+      if(!load(path))
+        setError(QNetworkReply::ContentNotFoundError, "no capture for " + request.url().toString());
+
+      open(QIODevice::ReadOnly);
+
+      if(error() != QNetworkReply::NoError)
+        QMetaObject::invokeMethod(this, "error", Qt::QueuedConnection, Q_ARG(QNetworkReply::NetworkError, error()));
+
+      QMetaObject::invokeMethod(this, "readyRead", Qt::QueuedConnection);
+      QMetaObject::invokeMethod(this, "finished", Qt::QueuedConnection);
+    }
+
+    void abort() {}
+
+    bool isSequential() const { return true; }
+
+    qint64 bytesAvailable() const
+    {
+      return m_body.size() - m_offset + QIODevice::bytesAvailable();
+    }
+
+  protected:
+    qint64 readData(char* data, qint64 maxSize)
+    {
+      const qint64 size = qMin(maxSize, qint64(m_body.size() - m_offset));
+      memcpy(data, m_body.constData() + m_offset, size);
+      m_offset += size;
+      return size;
+    }
+
+  private:
+    bool load(const QString& path)
+    {
+      QFile file(path);
+      if(!file.open(QIODevice::ReadOnly))
+        return false;
+
+      QDataStream in(&file);
+      in.setVersion(QDataStream::Qt_4_6);
+
+      quint32 magic = 0, version = 0;
+      QString url, error_string;
+      qint32  status = 0, code = 0, count = 0;
+      QUrl    redirection;
+
+      in >> magic >> version;
+      if(magic != CAPTURE_MAGIC || version != CAPTURE_VERSION)
+        return false;
+
+      in >> url >> status >> code >> error_string >> redirection >> count;
+      for(int i = 0; i < count && in.status() == QDataStream::Ok; ++i) {
+        QByteArray name, value;
+        in >> name >> value;
+        setRawHeader(name, value);
+      }
+      in >> m_body;
+
+      if(in.status() != QDataStream::Ok)
+        return false;
+
+      if(status != 0)
+        setAttribute(QNetworkRequest::HttpStatusCodeAttribute, status);
+      if(redirection.isValid())
+        setAttribute(QNetworkRequest::RedirectionTargetAttribute, redirection);
+      if(code != QNetworkReply::NoError)
+        setError(QNetworkReply::NetworkError(code), error_string);
+
+      return true;
+    }
+
+    QByteArray  m_body;
+    qint64      m_offset;
+};
+
 /*
 ********************************************************************************
 *                                                                              *
@@ -39,6 +220,44 @@ NetworkReply::NetworkReply(QNetworkReply *networkReply) : QObject(networkReply)
 
 }
 
+NetworkReply::NetworkReply(const QNetworkRequest& request, int operation, const QByteArray& data, int delay)
+  : QObject(0), m_request(request), m_operation(operation), m_data(data)
+{
+    m_reply = 0;
+
+    redirectCount = 0;
+
+    QTimer::singleShot(delay, this, SLOT(startRequest()));
+}
+
+void NetworkReply::startRequest()
+{
+    m_reply = HTTP()->send(m_request, m_operation, m_data);
+    if(!m_reply) {
+      deleteLater();
+      return;
+    }
+
+    /* same ownership as an immediate reply */
+    setParent(m_reply);
+    connectReplySignals();
+}
+
+void NetworkReply::abort()
+{
+    /* delayed request not sent yet */
+    if(!m_reply) {
+      deleteLater();
+      return;
+    }
+
+    disconnect(m_reply, 0, this, 0);
+    m_reply->abort();
+
+    /* deletes this reply too */
+    m_reply->deleteLater();
+}
+
 void NetworkReply::connectReplySignals()
 {
     connect( m_reply, SIGNAL( finished() ), SLOT( networkLoadFinished() ) );
@@ -73,6 +292,9 @@ void NetworkReply::networkLoadFinished()
 {
     //Debug::debug() << Q_FUNC_INFO;
 
+    if(HTTP()->mode() == NetworkAccess::MODE_RECORD)
+      HTTP()->record(m_reply);
+
     QUrl redirection = m_reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl();
     
     if (redirection.isValid() && redirectCount < MAX_REDIRECTS) 
@@ -117,7 +339,34 @@ void NetworkReply::networkLoadFinished()
 */
 NetworkAccess* NetworkAccess::INSTANCE = 0;
 
-NetworkAccess::NetworkAccess(QObject* parent) : QObject( parent ) {}
+NetworkAccess::NetworkAccess(QObject* parent) : QObject( parent )
+{
+    m_mode = MODE_NETWORK;
+
+    const QByteArray record_dir = qgetenv("YAROCK_NETWORK_RECORD");
+    const QByteArray replay_dir = qgetenv("YAROCK_NETWORK_REPLAY");
+
+    if(!replay_dir.isEmpty()) {
+      m_mode        = MODE_REPLAY;
+      m_capture_dir = QString::fromLocal8Bit(replay_dir);
+    }
+    else if(!record_dir.isEmpty()) {
+      m_mode        = MODE_RECORD;
+      m_capture_dir = QString::fromLocal8Bit(record_dir);
+      QDir().mkpath(m_capture_dir);
+    }
+
+    if(m_mode != MODE_NETWORK)
+      Debug::warning() << "NETWORK:" << (m_mode == MODE_RECORD ? "record" : "replay") << "mode, captures in" << m_capture_dir;
+
+    /* captures must reflect network answers, no cache when recording */
+    m_disk_cache = 0;
+    if(m_mode == MODE_NETWORK) {
+      m_disk_cache = new QNetworkDiskCache(this);
+      m_disk_cache->setCacheDirectory(UTIL::CONFIGDIR + "/httpcache");
+      m_disk_cache->setMaximumCacheSize(HTTP_CACHE_SIZE);
+    }
+}
 
 
 NetworkAccess*
@@ -146,10 +395,32 @@ QNetworkRequest NetworkAccess::buildRequest(QUrl url)
 }
 
 QNetworkReply* NetworkAccess::request(QUrl url, int operation, QByteArray data) 
+{
+    QNetworkRequest request = buildRequest(url);
+
+    if(operation == QNetworkAccessManager::PostOperation)
+      request.setRawHeader("Content-Type", "application/x-www-form-urlencoded");
+
+    return send(request, operation, data);
+}
+
+QNetworkReply* NetworkAccess::send(const QNetworkRequest& request, int operation, const QByteArray& data)
 {
     QNetworkAccessManager *manager = accessManager();
+    const QUrl url = request.url();
 
-    QNetworkRequest request = buildRequest(url);
+    QString capture_key;
+    if(m_mode != MODE_NETWORK)
+    {
+      QCryptographicHash hash(QCryptographicHash::Sha1);
+      hash.addData(QByteArray::number(operation));
+      hash.addData(url.toEncoded());
+      hash.addData(data);
+      capture_key = hash.result().toHex();
+
+      if(m_mode == MODE_REPLAY)
+        return replay(request, operation, capture_key);
+    }
 
     QNetworkReply *networkReply;
     switch (operation) {
@@ -164,7 +435,6 @@ QNetworkReply* NetworkAccess::request(QUrl url, int operation, QByteArray data)
         break;
 
     case QNetworkAccessManager::PostOperation:
-        request.setRawHeader("Content-Type", "application/x-www-form-urlencoded");
         networkReply = manager->post(request, data);
         break;
 
@@ -173,45 +443,138 @@ QNetworkReply* NetworkAccess::request(QUrl url, int operation, QByteArray data)
         return 0;
     }
 
+    if(!capture_key.isEmpty())
+      networkReply->setProperty(CAPTURE_KEY_PROPERTY, capture_key);
+
     return networkReply;
 }
 
 
+/*******************************************************************************
+    record / replay
+*******************************************************************************/
+QString NetworkAccess::capturePath(const QString& key) const
+{
+    return m_capture_dir + "/" + key;
+}
+
+QNetworkReply* NetworkAccess::replay(const QNetworkRequest& request, int operation, const QString& key)
+{
+    Debug::debug() << "NETWORK replay " << request.url().toString();
+
+    return new ReplayReply(request, operation, capturePath(key), accessManager());
+}
+
+/* body is peeked, reply content is left for its reader */
+void NetworkAccess::record(QNetworkReply* reply)
+{
+    const QString key = reply->property(CAPTURE_KEY_PROPERTY).toString();
+    if(m_mode != MODE_RECORD || key.isEmpty())
+      return;
+
+    QFile file(capturePath(key));
+    if(!file.open(QIODevice::WriteOnly)) {
+      Debug::warning() << "NETWORK: cannot write capture" << file.fileName();
+      return;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_4_6);
+
+    const QList<QByteArray> headers = reply->rawHeaderList();
+
+    out << CAPTURE_MAGIC << CAPTURE_VERSION
+        << reply->url().toString()
+        << qint32(reply->attribute(QNetworkRequest::HttpStatusCodeAttribute).toInt())
+        << qint32(reply->error())
+        << reply->errorString()
+        << reply->attribute(QNetworkRequest::RedirectionTargetAttribute).toUrl()
+        << qint32(headers.size());
+
+    foreach(const QByteArray& name, headers)
+      out << name << reply->rawHeader(name);
+
+    out << reply->peek(reply->bytesAvailable());
+}
+
+
 
 
 NetworkReply* NetworkAccess::get(const QUrl url)
 {
-    QNetworkReply *networkReply = request(url);
-    return new NetworkReply(networkReply);
+    return limitedReply(buildRequest(url), QNetworkAccessManager::GetOperation);
 }
 
 /* GET directly with QNetworkRequest in input    */
 /*   user shall provide request with filled header */
 NetworkReply* NetworkAccess::get(QNetworkRequest request)
 {
-    QNetworkReply *networkReply = accessManager()->get(request);
-    return new NetworkReply(networkReply);
+    return limitedReply(request, QNetworkAccessManager::GetOperation);
 }
 
 
 NetworkReply* NetworkAccess::head(const QUrl url)
 {
-    QNetworkReply *networkReply = request(url, QNetworkAccessManager::HeadOperation);
-    return new NetworkReply(networkReply);
+    return limitedReply(buildRequest(url), QNetworkAccessManager::HeadOperation);
 }
 
 
 NetworkReply* NetworkAccess::post(const QUrl url, QByteArray data)
 {
-    QNetworkReply *networkReply = request(url, QNetworkAccessManager::PostOperation,data);
-    return new NetworkReply(networkReply);
+    QNetworkRequest request = buildRequest(url);
+    request.setRawHeader("Content-Type", "application/x-www-form-urlencoded");
+
+    return limitedReply(request, QNetworkAccessManager::PostOperation, data);
 }
 
 /* POST directly with QNetworkRequest in input    */
 /*   user shall provide request with filled header */
 NetworkReply* NetworkAccess::post(QNetworkRequest request, QByteArray data)
 {
-    QNetworkReply *networkReply = accessManager()->post(request, data);
+    return limitedReply(request, QNetworkAccessManager::PostOperation, data);
+}
+
+
+/*******************************************************************************
+    host rate limit
+*******************************************************************************/
+void NetworkAccess::setHostRateLimit(const QString& host, int interval)
+{
+    QMutexLocker locker(&m_mutex);
+    m_host_intervals.insert(host, interval);
+}
+
+/* return delay before a request to url may be sent, and book that slot */
+int NetworkAccess::reserveHostSlot(const QUrl& url)
+{
+    QMutexLocker locker(&m_mutex);
+
+    const QString host = url.host();
+
+    QHash<QString, int>::const_iterator it = m_host_intervals.constBegin();
+    for( ; it != m_host_intervals.constEnd(); ++it)
+    {
+      if(host != it.key() && !host.endsWith("." + it.key()))
+        continue;
+
+      const qint64 now  = QDateTime::currentMSecsSinceEpoch();
+      const qint64 slot = qMax(now, m_host_next.value(it.key(), 0));
+
+      m_host_next.insert(it.key(), slot + it.value());
+      return int(slot - now);
+    }
+
+    return 0;
+}
+
+NetworkReply* NetworkAccess::limitedReply(const QNetworkRequest& request, int operation, const QByteArray& data)
+{
+    const int delay = reserveHostSlot(request.url());
+
+    if(delay > 0)
+      return new NetworkReply(request, operation, data, delay);
+
+    QNetworkReply *networkReply = send(request, operation, data);
     return new NetworkReply(networkReply);
 }
 
@@ -225,8 +588,12 @@ QNetworkAccessManager* NetworkAccess::accessManager()
     else 
     {
         //Debug::debug() << Q_FUNC_INFO << "create new access manager";
-        s_threadNamHash.insert( QThread::currentThread() ,new QNetworkAccessManager());
-        return s_threadNamHash[ QThread::currentThread() ];
+        QNetworkAccessManager* manager = new QNetworkAccessManager();
+        if(m_disk_cache)
+          manager->setCache(new HttpCache(m_disk_cache, &m_cache_mutex));
+
+        s_threadNamHash.insert( QThread::currentThread(), manager );
+        return manager;
     }  
 }
 
@@ -19,6 +19,7 @@
 
 #include <QtNetwork>
 #include <QHash>
+#include <QMutex>
 #include <QThread>
 
 #include "constants.h"
@@ -36,7 +37,12 @@ Q_OBJECT
 
 public:
     NetworkReply(QNetworkReply* networkReply);
+    /* request sent after delay (host rate limit) */
+    NetworkReply(const QNetworkRequest& request, int operation, const QByteArray& data, int delay);
     static const int MAX_REDIRECTS = 10;
+
+    /* stop request, no signal is emitted afterwards */
+    void abort();
     
 signals:
     void data(QByteArray);
@@ -47,6 +53,7 @@ private slots:
     void networkError(QNetworkReply::NetworkError);
     void networkLoadFinished();
     void deletedByParent();
+    void startRequest();
   
 private:
     void connectReplySignals();
@@ -54,6 +61,11 @@ private:
 private:
     QNetworkReply    *m_reply;
     int               redirectCount;
+
+    /* delayed request */
+    QNetworkRequest   m_request;
+    int               m_operation;
+    QByteArray        m_data;
 };
 
 /*
@@ -73,6 +85,17 @@ Q_OBJECT
 public:
     NetworkAccess(QObject* parent = 0);
     static NetworkAccess* http();
+
+    /* replies are captured in a directory for offline replay, mode is set with
+       YAROCK_NETWORK_RECORD or YAROCK_NETWORK_REPLAY (capture directory) */
+    enum Mode {
+      MODE_NETWORK = 0,
+      MODE_RECORD,
+      MODE_REPLAY
+    };
+
+    Mode mode() const { return m_mode; }
+    void record(QNetworkReply* reply);
   
     QNetworkReply* request(QUrl url,int operation = QNetworkAccessManager::GetOperation, QByteArray data = QByteArray());
 
@@ -83,12 +106,33 @@ public:
     NetworkReply* post(QUrl url, QByteArray data = QByteArray());
     NetworkReply* post(QNetworkRequest request, QByteArray data = QByteArray());
 
+    /* minimum delay between two requests sent to host (and its subdomains) */
+    void setHostRateLimit(const QString& host, int interval);
+
+    QNetworkReply* send(const QNetworkRequest& request, int operation, const QByteArray& data = QByteArray());
+
 private:
     QNetworkRequest buildRequest(QUrl url);
+    NetworkReply* limitedReply(const QNetworkRequest& request, int operation, const QByteArray& data = QByteArray());
+    int reserveHostSlot(const QUrl& url);
+
+    QNetworkReply* replay(const QNetworkRequest& request, int operation, const QString& key);
+    QString capturePath(const QString& key) const;
   
     QNetworkAccessManager* accessManager();
     
     static NetworkAccess* INSTANCE;    
+
+    QMutex                 m_mutex;
+    QHash<QString, int>    m_host_intervals;
+    QHash<QString, qint64> m_host_next;
+
+    /* http cache shared by access managers of all threads */
+    QNetworkDiskCache     *m_disk_cache;
+    QMutex                 m_cache_mutex;
+
+    Mode                   m_mode;
+    QString                m_capture_dir;
 };
 
 
@@ -51,10 +51,21 @@ PlaylistDbWriter::PlaylistDbWriter()
 
 
 //! ----------------------- PlaylistDbWriter::saveToDatabase -------------------
+// called from gui thread : playqueue content is copied here so the writer
+// never reads the model while it is being modified
 void PlaylistDbWriter::saveToDatabase(const QString& playlist_name, int bd_id)
 {
     _playlist_name = playlist_name;
     _database_id   = bd_id;
+
+    _items.clear();
+    foreach(const MEDIA::TrackPtr& track, m_model->tracks())
+    {
+      Item item;
+      item.url  = track->url;
+      item.name = MEDIA::isLocal(track->url) ? track->title : track->name;
+      _items << item;
+    }
 }
 
 
@@ -68,77 +79,138 @@ void PlaylistDbWriter::run()
     uint mtime       = date.toTime_t();
     QString pname    = "playlist-" + date.toString("dd-MM-yyyy-hh:mm:ss");
     QString fname    = QString(QCryptographicHash::hash(pname.toUtf8().constData(), QCryptographicHash::Sha1).toHex());
-    int favorite     = 0;
 
     //! set real playlist name from user
     if(!_playlist_name.isEmpty()) {
       pname = _playlist_name;
     }
 
-
-    QSqlField data("col",QVariant::String);
-
     Database db;
-    if (!db.connect())
+    if (!db.connect()) {
+      _isRunning = false;
       return;
-
-    if(_database_id != -1)
-    {
-      QSqlQuery cleanQuery1("DELETE FROM `playlists` WHERE `id`="+QString::number(_database_id)+";", *db.sqlDb());
-      QSqlQuery cleanQuery2("DELETE FROM `playlist_items` WHERE `playlist_id` NOT IN (SELECT `id` FROM `playlists`);", *db.sqlDb());
     }
 
+    Debug::debug() << "    [PlaylistDbWriter] save playlist: " << pname;
+
+    //On SQLite --> it's MUCH faster to have everything in one transaction
+    QSqlQuery("BEGIN TRANSACTION;",*db.sqlDb());
+
+    /* existing playlist is updated in place, items by diff */
+    int playlist_id = _database_id;
+    if(playlist_id == -1 || !updatePlaylist(db.sqlDb(), playlist_id, pname, mtime))
+      playlist_id = insertPlaylist(db.sqlDb(), fname, pname, mtime);
+
+    if(playlist_id != -1)
+      updateItems(db.sqlDb(), playlist_id);
+
+    QSqlQuery("COMMIT TRANSACTION;",*db.sqlDb());
+
+    _isRunning     = false;
+    _playlist_name = QString();
+    _items.clear();
+
+    emit playlistSaved();
+}
+
+
+//! ----------------------- PlaylistDbWriter::insertPlaylist -------------------
+int PlaylistDbWriter::insertPlaylist(QSqlDatabase* sqldb, const QString& fname, const QString& pname, uint mtime)
+{
+    QSqlQuery query(*sqldb);
+    query.prepare("INSERT INTO `playlists`(`filename`,`name`,`type`,`favorite`,`mtime`)" \
+                  "VALUES(?," \
+                  "       ?," \
+                  "       ?," \
+                  "       ?," \
+                  "       ?);");
+    query.addBindValue(fname);
+    query.addBindValue(pname);
+    query.addBindValue((int) T_DATABASE);
+    query.addBindValue(0);
+    query.addBindValue(mtime);
+
+    if(!query.exec())
+      return -1;
+
+    return query.lastInsertId().toInt();
+}
+
+
+//! ----------------------- PlaylistDbWriter::updatePlaylist -------------------
+bool PlaylistDbWriter::updatePlaylist(QSqlDatabase* sqldb, int playlist_id, const QString& pname, uint mtime)
+{
+    QSqlQuery query(*sqldb);
+    query.prepare("UPDATE `playlists` SET `name`=?, `mtime`=? WHERE `id`=?;");
+    query.addBindValue(pname);
+    query.addBindValue(mtime);
+    query.addBindValue(playlist_id);
+
+    return query.exec() && query.numRowsAffected() > 0;
+}
 
-    Debug::debug() << "    [PlaylistDbWriter] insert playlist: " << pname;
 
-    /*-----------------------------------------------------------*/
-    /* PLAYLIST part in database                                 */
-    /* ----------------------------------------------------------*/    
+//! ----------------------- PlaylistDbWriter::updateItems ----------------------
+// items are read back ordered by id, so the diff is positional : changed
+// rows are updated in place, extra rows deleted and new rows appended
+void PlaylistDbWriter::updateItems(QSqlDatabase* sqldb, int playlist_id)
+{
+    QList<int>  old_ids;
+    QList<Item> old_items;
     {
-      QSqlQuery query(*db.sqlDb());
-      query.prepare("INSERT INTO `playlists`(`filename`,`name`,`type`,`favorite`,`mtime`)" \
-                    "VALUES(?," \
-                    "       ?," \
-                    "       ?," \
-                    "       ?," \
-                    "       ?);");
-      query.addBindValue(fname);
-      query.addBindValue(pname);
-      query.addBindValue((int) T_DATABASE);
-      query.addBindValue(favorite);
-      query.addBindValue(mtime);
+      QSqlQuery query(*sqldb);
+      query.prepare("SELECT `id`,`url`,`name` FROM `playlist_items` WHERE `playlist_id`=? ORDER BY `id` ASC;");
+      query.addBindValue(playlist_id);
       query.exec();
+
+      while(query.next()) {
+        Item item;
+        item.url  = query.value(1).toString();
+        item.name = query.value(2).toString();
+        old_ids   << query.value(0).toInt();
+        old_items << item;
+      }
     }
 
-    
-    /*-----------------------------------------------------------*/
-    /* PLAYLIST ITEMS part in database                           */
-    /* ----------------------------------------------------------*/
-    data.setValue(fname);
-    QString fnameDB = db.sqlDb()->driver()->formatValue(data,false);
+    const int common = qMin(old_items.size(), _items.size());
+    int updated = 0;
 
-    for (int i = 0; i < m_model->rowCount(QModelIndex()); i++) 
+    QSqlQuery updateQuery(*sqldb);
+    updateQuery.prepare("UPDATE `playlist_items` SET `url`=?, `name`=? WHERE `id`=?;");
+
+    for(int i = 0; i < common; i++)
     {
+      if(old_items.at(i).url == _items.at(i).url && old_items.at(i).name == _items.at(i).name)
+        continue;
+
+      updateQuery.addBindValue(_items.at(i).url);
+      updateQuery.addBindValue(_items.at(i).name);
+      updateQuery.addBindValue(old_ids.at(i));
+      updateQuery.exec();
+      updated++;
+    }
 
-        const QString item_url   = m_model->trackAt(i)->url;
-        const QString item_name  = MEDIA::isLocal(m_model->trackAt(i)->url) ? m_model->trackAt(i)->title : m_model->trackAt(i)->name;
-       
-        QSqlQuery itemQuery(*db.sqlDb());
-//         Debug::debug() << "    [PlaylistDbWriter] insert playlist item url: " << item_url;
-//         Debug::debug() << "    [PlaylistDbWriter] insert playlist item name: " << m_model->trackAt(i)->name;
-//         Debug::debug() << "    [PlaylistDbWriter] insert playlist item title: " << m_model->trackAt(i)->title;
-
-        itemQuery.prepare("INSERT INTO `playlist_items`(`url`,`name`,`playlist_id`)" \
-                          "VALUES(?," \
-                          "       ?," \
-                          "       (SELECT `id` FROM `playlists` WHERE `filename`="+fnameDB+"));");
-        itemQuery.addBindValue(item_url);
-        itemQuery.addBindValue(item_name);
-        itemQuery.exec();
+    if(old_items.size() > common)
+    {
+      QSqlQuery deleteQuery(*sqldb);
+      deleteQuery.prepare("DELETE FROM `playlist_items` WHERE `playlist_id`=? AND `id`>=?;");
+      deleteQuery.addBindValue(playlist_id);
+      deleteQuery.addBindValue(old_ids.at(common));
+      deleteQuery.exec();
     }
 
-    _isRunning     = false;
-    _playlist_name = QString();
+    QSqlQuery insertQuery(*sqldb);
+    insertQuery.prepare("INSERT INTO `playlist_items`(`url`,`name`,`playlist_id`) VALUES(?,?,?);");
 
-    emit playlistSaved();
+    for(int i = common; i < _items.size(); i++)
+    {
+      insertQuery.addBindValue(_items.at(i).url);
+      insertQuery.addBindValue(_items.at(i).name);
+      insertQuery.addBindValue(playlist_id);
+      insertQuery.exec();
+    }
+
+    Debug::debug() << "    [PlaylistDbWriter] items updated:" << updated
+                   << "removed:" << (old_items.size() - common)
+                   << "added:" << (_items.size() - common);
 }
@@ -20,8 +20,10 @@
 #include <QRunnable>
 #include <QObject>
 #include <QString>
+#include <QList>
 
 class PlayqueueModel;
+class QSqlDatabase;
 /*
 ********************************************************************************
 *                                                                              *
@@ -43,12 +45,25 @@ Q_OBJECT
 
     void saveToDatabase(const QString& playlist_name, int bd_id = -1);
 
+  private:
+    struct Item {
+      QString url;
+      QString name;
+    };
+
+    int insertPlaylist(QSqlDatabase* sqldb, const QString& fname, const QString& pname, uint mtime);
+    bool updatePlaylist(QSqlDatabase* sqldb, int playlist_id, const QString& pname, uint mtime);
+    void updateItems(QSqlDatabase* sqldb, int playlist_id);
+
   private:
     PlayqueueModel    *m_model; 
     bool              _isRunning;
     QString           _playlist_name;
     int               _database_id;
 
+    /* playqueue snapshot taken when save is requested */
+    QList<Item>       _items;
+
   signals:
     void playlistSaved();
 };
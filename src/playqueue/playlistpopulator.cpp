@@ -33,6 +33,14 @@
 #include <QDirIterator>
 #include <QMutexLocker>
 #include <QFileInfo>
+#include <QtConcurrentMap>
+
+/* tracks handed to the model at once, and max delay before handing them */
+static const int BATCH_MAX_SIZE     = 500;
+static const int BATCH_MAX_INTERVAL = 150; /* ms */
+
+/* local files resolved at once against the database */
+static const int RESOLVE_CHUNK_SIZE = 256;
 
 
 /*
@@ -61,6 +69,7 @@ void PlaylistPopulator::run()
   //QTime startTime = QTime::currentTime();
 
   m_isRunning = true;
+  m_batch_time.start();
     
     
   while (!m_files.isEmpty() || !m_tracks.isEmpty())
@@ -111,23 +120,19 @@ void PlaylistPopulator::run()
               //Debug::debug() << "#1 PlaylistPopulator PlaylistFromFile local " << m_files.first();
               QList<MEDIA::TrackPtr> list = MEDIA::PlaylistFromFile(m_files.takeFirst());
 
+              QStringList urls;
+              foreach (MEDIA::TrackPtr track, list)
+                if(track->type() == TYPE_TRACK)
+                  urls << track->url;
+
+              QList<MEDIA::TrackPtr> resolved = resolveLocalFiles(urls);
+
               foreach (MEDIA::TrackPtr track, list) 
               {
-                if(track->type() == TYPE_TRACK) {
-                    QString url = track->url;
-                    track.reset();
-                    track = MEDIA::FromDataBase(url);
-                    if(!track)
-                      track = MEDIA::FromLocalFile(url);
-
-                    m_model->request_insert_track(track, m_playlist_row);
-
-                    track.reset();
-                }
-                else {
-                    m_model->request_insert_track(track, m_playlist_row);
-                    track.reset();
-                }
+                if(track->type() == TYPE_TRACK)
+                    queueTrack(resolved.takeFirst());
+                else
+                    queueTrack(track);
              } // foreach MediaItem
           }
       }
@@ -140,14 +145,20 @@ void PlaylistPopulator::run()
                MEDIA::isAudioFile(m_files.first()) &&
               !MEDIA::isPlaylistFile(m_files.first()))
           {
-              QString fileName = QFileInfo(m_files.takeFirst()).canonicalFilePath();
-
-              MEDIA::TrackPtr track = MEDIA::FromDataBase(fileName);
-              if(!track)
-                track = MEDIA::FromLocalFile(fileName);
+              /* resolve following local files as one chunk */
+              QStringList fileNames;
+              while( fileNames.size() < RESOLVE_CHUNK_SIZE &&
+                     !m_files.isEmpty() &&
+                     MEDIA::isLocal(m_files.first()) &&
+                     MEDIA::isAudioFile(m_files.first()) &&
+                    !MEDIA::isPlaylistFile(m_files.first()) &&
+                    !QFileInfo(m_files.first()).isDir())
+              {
+                fileNames << QFileInfo(m_files.takeFirst()).canonicalFilePath();
+              }
 
-              m_model->request_insert_track(track, m_playlist_row);
-              track.reset();
+              foreach (MEDIA::TrackPtr track, resolveLocalFiles(fileNames))
+                queueTrack(track);
           }
           else if(!MEDIA::isLocal(m_files.first())) {
               //! remote file
@@ -168,7 +179,7 @@ void PlaylistPopulator::run()
               stream->isPlayed    = false;
               stream->isStopAfter = false;
 
-              m_model->request_insert_track(stream, m_playlist_row);
+              queueTrack(stream);
 
               stream.reset();
           }
@@ -193,14 +204,16 @@ void PlaylistPopulator::run()
         }
         else 
         {
-            m_model->request_insert_track(track, m_playlist_row);
+            queueTrack(track);
         }
       }
 
   } //! END !m_files.isEmpty() && !m_tracks.isEmpty()
 
+  flushTracks();
+
   if(SETTINGS()->_playqueueDuplicate == false)
-    m_model->removeDuplicate();
+    m_model->request_remove_duplicate();
 
   m_isRunning = false;
   emit playlistPopulated();
@@ -211,6 +224,70 @@ void PlaylistPopulator::run()
   Debug::debug() << " --- PlaylistPopulator--> End "  << QTime::currentTime().second() << ":" << QTime::currentTime().msec();
 }
 
+/*******************************************************************************
+  PlaylistPopulator::resolveLocalFiles
+    -> known files are read from database with one query per chunk
+    -> tags of the other files are read in parallel
+*******************************************************************************/
+static MEDIA::TrackPtr trackFromLocalFile(const QString& url)
+{
+    return MEDIA::FromLocalFile(url);
+}
+
+QList<MEDIA::TrackPtr> PlaylistPopulator::resolveLocalFiles(const QStringList& urls)
+{
+    QList<MEDIA::TrackPtr> tracks = MEDIA::FromDataBase(urls);
+
+    QStringList misses;
+    for(int i = 0; i < tracks.size(); i++)
+      if(tracks.at(i).isNull())
+        misses << urls.at(i);
+
+    if(misses.isEmpty())
+      return tracks;
+
+    QList<MEDIA::TrackPtr> read = 
+        QtConcurrent::blockingMapped< QList<MEDIA::TrackPtr> >(misses, trackFromLocalFile);
+
+    for(int i = 0; i < tracks.size(); i++)
+      if(tracks.at(i).isNull())
+        tracks[i] = read.takeFirst();
+
+    return tracks;
+}
+
+/*******************************************************************************
+  PlaylistPopulator::queueTrack
+    tracks are handed to the model in batches, bounded in size and in time so
+    the first tracks still show up quickly, each batch being inserted with a
+    single model notification
+*******************************************************************************/
+void PlaylistPopulator::queueTrack(MEDIA::TrackPtr track)
+{
+    m_batch.append(track);
+    flushTracks(false);
+}
+
+void PlaylistPopulator::flushTracks(bool force)
+{
+    if(m_batch.isEmpty())
+      return;
+
+    if(!force &&
+        m_batch.size() < BATCH_MAX_SIZE &&
+        m_batch_time.elapsed() < BATCH_MAX_INTERVAL)
+      return;
+
+    m_model->request_insert_tracks(m_batch, m_playlist_row);
+
+    /* next batch goes after this one */
+    if(m_playlist_row != -1)
+      m_playlist_row += m_batch.size();
+
+    m_batch.clear();
+    m_batch_time.restart();
+}
+
 /*******************************************************************************
   User methode
 *******************************************************************************/
@@ -288,6 +365,7 @@ void AsynchronousLoadTask::slot_download_done(QByteArray bytes)
     else
     {
       QList<MEDIA::TrackPtr> list = MEDIA::PlaylistFromBytes(bytes);
+      QList<MEDIA::TrackPtr> tracks;
 
       foreach (MEDIA::TrackPtr track, list)
       {
@@ -300,7 +378,7 @@ void AsynchronousLoadTask::slot_download_done(QByteArray bytes)
             if(!track)
              track = MEDIA::FromLocalFile(track->url);
 
-            m_model->request_insert_track(track, m_row);
+            tracks << track;
 
             track.reset();
         }
@@ -323,11 +401,13 @@ void AsynchronousLoadTask::slot_download_done(QByteArray bytes)
            else 
            {
              Debug::debug() << "AsynchronousLoadTask track found :" << track->url;
-             m_model->request_insert_track(track, m_row);
+             tracks << track;
            }
         }
         track.reset();
       } // foreach track
+
+      m_model->request_insert_tracks(tracks, m_row);
     }
 
     delete this;
@@ -27,6 +27,7 @@
 #include <QList>
 #include <QUrl>
 #include <QMap>
+#include <QTime>
 
 
 class PlayqueueModel;
@@ -79,6 +80,11 @@ Q_OBJECT
     void addUrls(QList<QUrl> listUrl, int playlist_row);
     void addMediaItems(QList<MEDIA::TrackPtr> list, int playlist_row);
 
+  private:
+    QList<MEDIA::TrackPtr> resolveLocalFiles(const QStringList& urls);
+    void queueTrack(MEDIA::TrackPtr track);
+    void flushTracks(bool force = true);
+
   private:
     PlayqueueModel          *m_model;      
     QStringList              m_files;
@@ -87,6 +93,10 @@ Q_OBJECT
     int                      m_playlist_row;
     QMap<QObject*, int>      m_requests;
 
+    /* tracks waiting to be inserted into the model */
+    QList<MEDIA::TrackPtr>   m_batch;
+    QTime                    m_batch_time;
+
   signals:
     void playlistPopulated();
     void async_load(QString,int);
@@ -426,6 +426,47 @@ PlaylistDelegate::PlaylistDelegate(QObject *parent, PlayqueueModel* model)
     font_bold.setBold(true);
 
     _mode = PLAYQUEUE::MODE_EXTENDED;
+
+    /* 8 MB of rendered rows, about 800 rows of 300x40 pixels */
+    m_cache.setMaxCost(8 * 1024 * 1024);
+
+    connect(m_model, SIGNAL(dataChanged(QModelIndex,QModelIndex)), this, SLOT(slot_invalidate_rows(QModelIndex,QModelIndex)));
+    connect(m_model, SIGNAL(rowsAboutToBeRemoved(QModelIndex,int,int)), this, SLOT(slot_invalidate_all()));
+    connect(m_model, SIGNAL(modelReset()), this, SLOT(slot_invalidate_all()));
+    connect(m_model, SIGNAL(layoutChanged()), this, SLOT(slot_invalidate_all()));
+}
+
+/*******************************************************************************
+  render cache
+    row content is rendered once into a pixmap, reused while the row size,
+    the view mode and the track state are unchanged
+*******************************************************************************/
+void PlaylistDelegate::slot_invalidate_rows(const QModelIndex& topLeft, const QModelIndex& bottomRight)
+{
+    if(!topLeft.isValid() || !bottomRight.isValid()) {
+      m_cache.clear();
+      return;
+    }
+
+    for(int row = topLeft.row(); row <= bottomRight.row(); row++) {
+      MEDIA::TrackPtr track = m_model->trackAt(row);
+      if(track)
+        m_cache.remove(track.data());
+    }
+}
+
+void PlaylistDelegate::slot_invalidate_all()
+{
+    m_cache.clear();
+}
+
+int PlaylistDelegate::rowState(const MEDIA::TrackPtr track, bool isSelected) const
+{
+    return (isSelected          ? 0x01 : 0) |
+           (track->isPlaying    ? 0x02 : 0) |
+           (track->isBroken     ? 0x04 : 0) |
+           (track->isStopAfter  ? 0x08 : 0) |
+           (track->id != -1     ? 0x10 : 0);
 }
 
 void PlaylistDelegate::paint ( QPainter * painter, const QStyleOptionViewItem & option, const QModelIndex & index ) const
@@ -433,19 +474,11 @@ void PlaylistDelegate::paint ( QPainter * painter, const QStyleOptionViewItem &
     //! get the data object
     QModelIndex mappedIndex = m_model->proxy()->mapToSource(index);
     MEDIA::TrackPtr track   = m_model->trackAt(mappedIndex.row());
+    if(!track)
+      return;
 
-    bool isTrack     = (track->type() == TYPE_TRACK) ? true : false;
-    bool isBroken    = track->isBroken;
     bool isSelected  = option.state & QStyle::State_Selected;
 
-    const int left   = option.rect.left();
-    const int top    = option.rect.top();
-    const int width  = option.rect.width();
-    const int height = option.rect.height();
-
-    // Turn on antialiasing
-    painter->setRenderHint(QPainter::Antialiasing, true);
-  
     //! draw background
     QStyleOptionViewItemV4 opt(option);
     opt.state |= QStyle::State_Active;
@@ -454,6 +487,50 @@ void PlaylistDelegate::paint ( QPainter * painter, const QStyleOptionViewItem &
     QStyle *style = opt.widget ? opt.widget->style() : QApplication::style();
     style->drawPrimitive(QStyle::PE_PanelItemViewItem, &opt, painter, opt.widget);
 
+    //! draw row content from cache
+    const int state = rowState(track, isSelected);
+
+    RowCache* cached = m_cache.object(track.data());
+    if(!cached || cached->state != state || cached->mode != (int) _mode || cached->pixmap.size() != option.rect.size())
+    {
+      QPixmap pixmap(option.rect.size());
+      pixmap.fill(Qt::transparent);
+      {
+        QPainter p(&pixmap);
+        QStyleOptionViewItemV4 row_opt(opt);
+        row_opt.rect = QRect(QPoint(0, 0), option.rect.size());
+        paintRow(&p, row_opt, track);
+      }
+
+      cached = new RowCache();
+      cached->pixmap = pixmap;
+      cached->state  = state;
+      cached->mode   = (int) _mode;
+
+      const int cost = pixmap.width() * pixmap.height() * 4;
+      if(!m_cache.insert(track.data(), cached, cost)) {
+        painter->drawPixmap(option.rect.topLeft(), pixmap);
+        return;
+      }
+    }
+
+    painter->drawPixmap(option.rect.topLeft(), cached->pixmap);
+}
+
+void PlaylistDelegate::paintRow( QPainter * painter, const QStyleOptionViewItem & opt, const MEDIA::TrackPtr track ) const
+{
+    bool isTrack     = (track->type() == TYPE_TRACK) ? true : false;
+    bool isBroken    = track->isBroken;
+    bool isSelected  = opt.state & QStyle::State_Selected;
+
+    const int left   = opt.rect.left();
+    const int top    = opt.rect.top();
+    const int width  = opt.rect.width();
+    const int height = opt.rect.height();
+
+    // Turn on antialiasing
+    painter->setRenderHint(QPainter::Antialiasing, true);
+
     //! set painter font & color
     painter->setFont(font_normal);
     painter->setPen( opt.palette.color ( (track->id!=-1 || isSelected) ? QPalette::Normal : QPalette::Disabled, isSelected ? QPalette::HighlightedText : QPalette::WindowText) );
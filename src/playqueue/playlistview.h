@@ -24,6 +24,7 @@
 
 #include <QtGui>
 #include <QString>
+#include <QCache>
 
 /*******************************************************************************
   Playqueue mode (manage by PlaylistWidget)
@@ -63,13 +64,19 @@ Q_OBJECT
 
     //! get & set mode
     int mode() {return (int) _mode;}
-    void setMode(int m) {_mode = (PLAYQUEUE::Q_MODE)m;}
+    void setMode(int m) {_mode = (PLAYQUEUE::Q_MODE)m; m_cache.clear();}
 
   private :
     QString   getTrackInfo(const MEDIA::TrackPtr track) const;
     QIcon     getIcon(const MEDIA::TrackPtr track) const;
+    int       rowState(const MEDIA::TrackPtr track, bool isSelected) const;
+    void      paintRow(QPainter * painter, const QStyleOptionViewItem & option, const MEDIA::TrackPtr track) const;
     void      drawStop(QPainter * painter, QRect rect) const;
 
+  private slots:
+    void slot_invalidate_rows(const QModelIndex& topLeft, const QModelIndex& bottomRight);
+    void slot_invalidate_all();
+
 private:
     PlayqueueModel      *m_model;
 
@@ -82,6 +89,14 @@ private:
     QFont     font_bold;
 
     PLAYQUEUE::Q_MODE  _mode;
+
+    /* rendered row content (without background), keyed on track */
+    struct RowCache {
+      QPixmap  pixmap;
+      int      state;
+      int      mode;
+    };
+    mutable QCache<const MEDIA::Track*, RowCache>  m_cache;
 };
 
 
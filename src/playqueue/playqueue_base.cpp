@@ -40,12 +40,20 @@ PlayqueueBase::PlayqueueBase()
     m_requested_track = MEDIA::TrackPtr(0);
     
     m_proxy_model     =  0;
+    m_row_index_valid =  0;
+    m_row_hint        = -1;
+    m_shuffle_bag_valid = false;
 }
 
     
 void PlayqueueBase::clear(bool initall)
 {
     m_tracks.clear();
+    m_row_index.clear();
+    m_row_index_valid = 0;
+    m_row_hint        = -1;
+    m_shuffle_bag.clear();
+    m_shuffle_bag_valid = false;
 
     if(initall) {
       m_playing_track   = MEDIA::TrackPtr(0);
@@ -58,12 +66,22 @@ void PlayqueueBase::clear(bool initall)
 void PlayqueueBase::addTrack(const MEDIA::TrackPtr track)
 {
      m_tracks << MEDIA::TrackPtr(track);
+     addToShuffleBag(m_tracks.size() - 1);
 }
 
 
-void PlayqueueBase::addTracks(QList<MEDIA::TrackPtr> tracks)
+void PlayqueueBase::addTracks(const QList<MEDIA::TrackPtr>& tracks)
 {
-     m_tracks << tracks;
+     const int start = m_tracks.size();
+
+     /* share the list instead of copying its items */
+     if(m_tracks.isEmpty())
+       m_tracks = tracks;
+     else
+       m_tracks << tracks;
+
+     for(int row = start; row < m_tracks.size(); row++)
+       addToShuffleBag(row);
 }
 
 
@@ -71,17 +89,84 @@ void PlayqueueBase::insertTrack(const MEDIA::TrackPtr track, int pos)
 {
     const int start = (pos == -1) ? m_tracks.size() : pos;
     m_tracks.insert(start, track);
+
+    invalidateRowIndex(start);
+    addToShuffleBag(start);
+}
+
+
+void PlayqueueBase::insertTracks(const QList<MEDIA::TrackPtr>& tracks, int pos)
+{
+    const int start = (pos == -1) ? m_tracks.size() : pos;
+
+    if(start == m_tracks.size())
+      m_tracks << tracks;
+    else
+      m_tracks = m_tracks.mid(0, start) + tracks + m_tracks.mid(start);
+
+    invalidateRowIndex(start);
+
+    for(int row = start; row < start + tracks.size(); row++)
+      addToShuffleBag(row);
 }
     
 MEDIA::TrackPtr PlayqueueBase::removeTrackAt(int i)
 {
-    if(rowExists(i))
-      return m_tracks.takeAt(i);
+    if(rowExists(i)) {
+      MEDIA::TrackPtr track = m_tracks.takeAt(i);
+
+      if(m_row_index.value(track.data(), -1) == i)
+        m_row_index.remove(track.data());
+      invalidateRowIndex(i);
+
+      return track;
+    }
       
     return MEDIA::TrackPtr(0);
 }
 
 
+void PlayqueueBase::removeTracksAt(int pos, int count)
+{
+    if(count <= 0 || !rowExists(pos) || !rowExists(pos + count - 1))
+      return;
+
+    for(int row = pos; row < pos + count; row++) {
+      MEDIA::Track* track = m_tracks.at(row).data();
+      if(m_row_index.value(track, -1) == row)
+        m_row_index.remove(track);
+    }
+
+    m_tracks.erase(m_tracks.begin() + pos, m_tracks.begin() + pos + count);
+    invalidateRowIndex(pos);
+}
+
+
+/* rows : one bit per track, set bits are removed in a single pass */
+void PlayqueueBase::removeTracks(const QBitArray& rows)
+{
+    QList<MEDIA::TrackPtr> kept;
+    kept.reserve(m_tracks.size());
+
+    int first_removed = m_tracks.size();
+    for(int row = 0; row < m_tracks.size(); row++)
+    {
+      if(row < rows.size() && rows.testBit(row)) {
+        first_removed = qMin(first_removed, row);
+        continue;
+      }
+      kept.append(m_tracks.at(row));
+    }
+
+    if(first_removed == m_tracks.size())
+      return;
+
+    m_tracks = kept;
+    m_row_index.clear();
+    m_row_index_valid = 0;
+}
+
+
 void PlayqueueBase::setPlayingTrack(MEDIA::TrackPtr tk)
 {
     m_playing_track  = tk;
@@ -94,9 +179,65 @@ MEDIA::TrackPtr PlayqueueBase::playingTrack()
 }
 
 
+/*******************************************************************************
+    row index
+      rows before m_row_index_valid are indexed, the rest is indexed on
+      demand so appending tracks costs O(1) and a change at row r only
+      re-indexes the rows after r
+*******************************************************************************/
 int PlayqueueBase::rowForTrack(const MEDIA::TrackPtr track)
 {
-    return m_tracks.indexOf(track);
+    if(!track)
+      return -1;
+
+    return rowForTrack(track.data(), m_row_hint);
+}
+
+
+/* hint : expected row, checked first so that walking the queue from the
+   requested/playing track never needs the index */
+int PlayqueueBase::rowForTrack(const MEDIA::Track* track, int hint)
+{
+    if(rowExists(hint) && m_tracks.at(hint).data() == track) {
+      m_row_hint = hint;
+      return hint;
+    }
+
+    updateRowIndex();
+
+    const int row = m_row_index.value(const_cast<MEDIA::Track*>(track), -1);
+    if(row != -1 && row < m_tracks.size() && m_tracks.at(row).data() == track) {
+      m_row_hint = row;
+      return row;
+    }
+
+    return -1;
+}
+
+
+void PlayqueueBase::invalidateRowIndex(int from_row)
+{
+    m_row_index_valid = qMin(m_row_index_valid, from_row);
+}
+
+
+void PlayqueueBase::updateRowIndex()
+{
+    const int first = m_row_index_valid;
+
+    for(int row = first; row < m_tracks.size(); row++)
+    {
+      MEDIA::Track* track = m_tracks.at(row).data();
+
+      /* keep index of first occurrence only */
+      const int indexed = m_row_index.value(track, -1);
+      if(indexed != -1 && indexed < row && m_tracks.at(indexed).data() == track)
+        continue;
+
+      m_row_index.insert(track, row);
+    }
+
+    m_row_index_valid = m_tracks.size();
 }
 
 
@@ -113,6 +254,25 @@ Q_UNUSED(source_row)
 }
 
 
+/* next/previous row accepted by filter, -1 if none */
+int PlayqueueBase::nextFilteredRow(int source_row)
+{
+    if(m_proxy_model)
+      return m_proxy_model->nextAcceptedRow(source_row);
+
+    return (source_row + 1 < m_tracks.size()) ? qMax(source_row + 1, 0) : -1;
+}
+
+
+int PlayqueueBase::prevFilteredRow(int source_row)
+{
+    if(m_proxy_model)
+      return m_proxy_model->prevAcceptedRow(source_row);
+
+    return qMax(qMin(source_row, m_tracks.size()) - 1, -1);
+}
+
+
 MEDIA::TrackPtr PlayqueueBase::nextTrack()
 {
     RepeatMode  repeat_m  = (RepeatMode)SETTINGS()->_repeatMode;
@@ -135,14 +295,9 @@ MEDIA::TrackPtr PlayqueueBase::nextTrack()
     else if(repeat_m == RepeatAll && shuffle_m == ShuffleOff) {
         i = skipForward(true);
     }
-    //! shuffle ==> random prev until all is played
+    //! shuffle ==> random next until all is played
     else if(shuffle_m == ShuffleOn) {
-      QList<MEDIA::TrackPtr> list = unplayedTracks();
-      if(!list.isEmpty()) {
-        int index = UTIL::randomInt(0, list.size() -1);
-        MEDIA::TrackPtr track = list.at(index);
-        i = rowForTrack(track);
-      }
+      i = takeFromShuffleBag();
     }
     
     setRequestedTrackAt(i);
@@ -174,12 +329,7 @@ MEDIA::TrackPtr PlayqueueBase::prevTrack()
     }    
     //! shuffle ==> random prev until all is played
     else if(shuffle_m == ShuffleOn) {
-      QList<MEDIA::TrackPtr> list = unplayedTracks();
-      if(!list.isEmpty()) {
-        int index = UTIL::randomInt(0, list.size() -1);
-        MEDIA::TrackPtr track = list.at(index);
-        i = rowForTrack(track);
-      }
+      i = takeFromShuffleBag();
     }
 
     setRequestedTrackAt(i);
@@ -191,17 +341,11 @@ int PlayqueueBase::skipBackward(bool repeat /*=false*/)
 {
    /* tant que l'on ne trouve pas de ligne située avant presente dans le proxy */
    int i = rowForTrack(m_requested_track); /* source row requested */ 
-   --i;
-   while(i >= 0 && !filterContainsRow(i))
-     --i;
+   i = prevFilteredRow(i);
    
-   if(repeat && i == -1) {
-     int j = m_tracks.size() -1;
-     while(j > i && !filterContainsRow(j))
-       --j;
-       
-     i = j;
-   }
+   if(repeat && i == -1)
+     i = prevFilteredRow(m_tracks.size());
+
    return i; 
 }
 
@@ -211,18 +355,11 @@ int PlayqueueBase::skipForward(bool repeat /*=false*/)
    /* tant que l'on ne trouve pas de ligne située aprés presente dans le proxy */
    int i = rowForTrack(m_requested_track); /* source row requested */ 
    int source_row  = i;
-   ++i;
-   while(i < m_tracks.size() && !filterContainsRow(i))
-     ++i;
+   i = nextFilteredRow(i);
 
-   if(i >= m_tracks.size()) i = -1;
-   
    if(repeat && i == -1) {
-     int j = 0;
-     while(j < source_row && !filterContainsRow(j))
-       ++j;
-
-     i = j;
+     int j = nextFilteredRow(-1);
+     i = (j != -1 && j < source_row) ? j : qMax(source_row, 0);
    }
    return i;    
 }
@@ -233,6 +370,7 @@ void PlayqueueBase::setRequestedTrackAt(int idx)
     if(idx >= 0 && idx < m_tracks.size())
     {
       m_requested_track = m_tracks.at(idx);
+      m_row_hint        = idx;
     }
     else
     {
@@ -251,12 +389,74 @@ QList<MEDIA::TrackPtr>  PlayqueueBase::unplayedTracks()
 {
     QList<MEDIA::TrackPtr> list;
 
-    foreach (MEDIA::TrackPtr track, m_tracks)
+    for (int row = nextFilteredRow(-1); row != -1; row = nextFilteredRow(row))
     {
-        if(!track->isPlayed && filterContainsRow(rowForTrack(track)) )
+        const MEDIA::TrackPtr track = m_tracks.at(row);
+        if(!track->isPlayed)
           list << track;
     }
 
     return list;
 }
 
+
+
+/*******************************************************************************
+    shuffle bag
+      random permutation of queued rows, built on first draw only; rows added
+      later are inserted at a random position (inside-out Fisher-Yates),
+      rows are drawn from the end. Entries keep the track address to detect
+      rows that moved; removed, played or filtered out tracks are skipped.
+*******************************************************************************/
+void PlayqueueBase::addToShuffleBag(int row)
+{
+    if(!m_shuffle_bag_valid)
+      return;
+
+    ShuffleEntry entry;
+    entry.row   = row;
+    entry.track = m_tracks.at(row).data();
+    m_shuffle_bag.append(entry);
+
+    const int last  = m_shuffle_bag.size() - 1;
+    const int index = UTIL::randomInt(0, last);
+    if(index != last)
+      qSwap(m_shuffle_bag[index], m_shuffle_bag[last]);
+}
+
+
+void PlayqueueBase::fillShuffleBag()
+{
+    m_shuffle_bag.clear();
+    m_shuffle_bag_valid = true;
+
+    for (int row = nextFilteredRow(-1); row != -1; row = nextFilteredRow(row))
+      if(!m_tracks.at(row)->isPlayed)
+        addToShuffleBag(row);
+}
+
+
+int PlayqueueBase::takeFromShuffleBag()
+{
+    if(!m_shuffle_bag_valid)
+      fillShuffleBag();
+
+    for(int pass = 0; pass < 2; pass++)
+    {
+      while(!m_shuffle_bag.isEmpty())
+      {
+        const ShuffleEntry entry = m_shuffle_bag.last();
+        m_shuffle_bag.pop_back();
+
+        const int row = rowForTrack(entry.track, entry.row);
+        if(row != -1 && !m_tracks.at(row)->isPlayed && filterContainsRow(row))
+          return row;
+      }
+
+      /* every track has been drawn : start a new permutation */
+      if(pass == 0)
+        fillShuffleBag();
+    }
+
+    return -1;
+}
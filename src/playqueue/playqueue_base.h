@@ -21,6 +21,9 @@
 #include "core/mediaitem/mediaitem.h"
 
 #include <QList>
+#include <QHash>
+#include <QBitArray>
+#include <QVector>
 /*
 ******************************************************************************************
 *                                                                                        *
@@ -39,9 +42,12 @@ class PlayqueueBase
 
     /* insertion method */
     void addTrack(const MEDIA::TrackPtr track);
-    void addTracks(QList<MEDIA::TrackPtr> tracks);
+    void addTracks(const QList<MEDIA::TrackPtr>& tracks);
     void insertTrack(const MEDIA::TrackPtr track, int pos=-1);
+    void insertTracks(const QList<MEDIA::TrackPtr>& tracks, int pos=-1);
     MEDIA::TrackPtr removeTrackAt(int i);
+    void removeTracksAt(int pos, int count);
+    void removeTracks(const QBitArray& rows);
 
     /* getters */
     QList<MEDIA::TrackPtr> tracks() const {return m_tracks;}    
@@ -60,15 +66,42 @@ class PlayqueueBase
     
     /* proxy & filter */
     bool filterContainsRow(int source_row);
+    int nextFilteredRow(int source_row);
+    int prevFilteredRow(int source_row);
     void setProxy(PlayqueueProxyModel* proxy) {m_proxy_model = proxy;}
     PlayqueueProxyModel* proxy() {return m_proxy_model;}
 
-  private :
+  protected :
     int skipForward(bool repeat  = false);
     int skipBackward(bool repeat = false);
-    
+
+  private :
+    void invalidateRowIndex(int from_row);
+    void updateRowIndex();
+
+    int rowForTrack(const MEDIA::Track* track, int hint);
+
+    void addToShuffleBag(int row);
+    void fillShuffleBag();
+    int takeFromShuffleBag();
+
   private :
     QList<MEDIA::TrackPtr>    m_tracks;
+
+    /* track -> first row, valid for rows below m_row_index_valid */
+    QHash<MEDIA::Track*, int> m_row_index;
+    int                       m_row_index_valid;
+
+    /* last row found, checked before the index */
+    int                       m_row_hint;
+
+    /* shuffled rows not yet played in shuffle mode */
+    struct ShuffleEntry {
+      int            row;
+      MEDIA::Track*  track;
+    };
+    QVector<ShuffleEntry>     m_shuffle_bag;
+    bool                      m_shuffle_bag_valid;
     MEDIA::TrackPtr           m_requested_track;
     MEDIA::TrackPtr           m_playing_track;
     
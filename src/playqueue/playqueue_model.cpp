@@ -24,6 +24,8 @@
 #include "debug.h"
 
 #include <QBuffer>
+#include <QBitArray>
+#include <QSet>
 /*******************************************************************************
  SortByRowAsc function object
    -> avoid to use boost to bind member function in qSort
@@ -61,6 +63,8 @@ PlayqueueModel::PlayqueueModel(QObject* parent) :
     m_task_manager = new TaskManager(this);
     
     connect( this, SIGNAL( insertTrack(const MEDIA::TrackPtr, int) ), this, SLOT( slot_insert_mediaitem(const MEDIA::TrackPtr, int)) );
+    connect( this, SIGNAL( insertTracks(const QList<MEDIA::TrackPtr>, int) ), this, SLOT( slot_insert_mediaitems(const QList<MEDIA::TrackPtr>, int)) );
+    connect( this, SIGNAL( removeDuplicateRequested() ), this, SLOT( removeDuplicate() ), Qt::QueuedConnection );
 }
 
 
@@ -107,10 +111,7 @@ bool PlayqueueModel::removeRows(int position, int count, const QModelIndex & /*p
     if( position + count - 1 >= PlayqueueBase::size()) return false;
 
     beginRemoveRows(QModelIndex(), position, position + count - 1);
-    for (int itemcount = (count-1); itemcount >= 0; itemcount--) {
-      MEDIA::TrackPtr track = PlayqueueBase::removeTrackAt(position + itemcount);
-      track.reset();
-    }
+    PlayqueueBase::removeTracksAt(position, count);
     endRemoveRows();
 
     return true;
@@ -145,20 +146,7 @@ void PlayqueueModel::updatePlayingItem(MEDIA::TrackPtr tk)
 *******************************************************************************/
 int PlayqueueModel::skipBackward(bool repeat /*=false*/)
 {
-   /* tant que l'on ne trouve pas de ligne située avant presente dans le proxy */
-   int i = PlayqueueBase::rowForTrack(PlayqueueBase::requestedTrack()); /* source row requested */ 
-   --i;
-   while(i >= 0 && !PlayqueueBase::filterContainsRow(i))
-     --i;
-   
-   if(repeat && i == -1) {
-     int j = rowCount() -1;
-     while(j > i && !PlayqueueBase::filterContainsRow(j))
-       --j;
-       
-     i = j;
-   }
-   return i; 
+    return PlayqueueBase::skipBackward(repeat);
 }
 
 /*******************************************************************************
@@ -166,23 +154,7 @@ int PlayqueueModel::skipBackward(bool repeat /*=false*/)
 *******************************************************************************/
 int PlayqueueModel::skipForward(bool repeat /*=false*/)
 {
-   /* tant que l'on ne trouve pas de ligne située aprés presente dans le proxy */
-   int i = PlayqueueBase::rowForTrack(PlayqueueBase::requestedTrack()); /* source row requested */ 
-   int source_row  = i;
-   ++i;
-   while(i < rowCount() && !PlayqueueBase::filterContainsRow(i))
-     ++i;
-
-   if(i >= rowCount()) i = -1;
-   
-   if(repeat && i == -1) {
-     int j = 0;
-     while(j < source_row && !PlayqueueBase::filterContainsRow(j))
-       ++j;
-
-     i = j;
-   }
-   return i;    
+    return PlayqueueBase::skipForward(repeat);
 }
 
 /*******************************************************************************
@@ -245,7 +217,10 @@ void PlayqueueModel::addMediaItem(const MEDIA::TrackPtr media)
 void PlayqueueModel::addMediaItems(QList<MEDIA::TrackPtr> list)
 {
     //Debug::debug() << " --- PlayqueueModel->addMediaItems";
-    beginInsertRows(QModelIndex(), PlayqueueBase::size(), PlayqueueBase::size());
+    if(list.isEmpty())
+      return;
+
+    beginInsertRows(QModelIndex(), PlayqueueBase::size(), PlayqueueBase::size() + list.size() - 1);
     PlayqueueBase::addTracks(list);
     endInsertRows();
 }
@@ -266,24 +241,97 @@ void PlayqueueModel::slot_insert_mediaitem(const MEDIA::TrackPtr media, int pos)
     endInsertRows();
 }
 
+void PlayqueueModel::request_insert_tracks(const QList<MEDIA::TrackPtr> tracks, int pos)
+{
+   if(!tracks.isEmpty())
+     emit insertTracks(tracks, pos);
+}
+
+void PlayqueueModel::slot_insert_mediaitems(const QList<MEDIA::TrackPtr> list, int pos)
+{
+    if(list.isEmpty())
+      return;
+
+    const int start = (pos == -1 || pos > rowCount()) ? rowCount() : pos;
+
+    beginInsertRows(QModelIndex(), start, start + list.size() - 1);
+
+    PlayqueueBase::insertTracks(list, start);
+
+    endInsertRows();
+}
+
+
+void PlayqueueModel::request_remove_duplicate()
+{
+    /* queued after the pending insertTrack signals, so it runs on the gui
+       thread once every track of the population has been inserted */
+    emit removeDuplicateRequested();
+}
+
+/* above this number of separate runs of duplicates, a single model reset is
+   cheaper than notifying the views for each run */
+static const int MAX_REMOVED_RUNS = 32;
 
 void PlayqueueModel::removeDuplicate()
 {
-    Debug::warning() << "--- PlayqueueModel-->removeDuplicate";
-    QSet<QUrl> filenames;
+    Debug::debug() << "--- PlayqueueModel-->removeDuplicate";
+    const QList<MEDIA::TrackPtr> tracks = PlayqueueBase::tracks();
 
-    foreach(MEDIA::TrackPtr media, PlayqueueBase::tracks()) {
-        QString path = media->url;
-        if(filenames.contains( path ))
-        {
-          int row = PlayqueueBase::rowForTrack(media);
-          removeRows(row,1,QModelIndex());
+    /* single pass : keep first occurrence of each url */
+    QSet<QString> urls;
+    urls.reserve(tracks.size());
+
+    QBitArray duplicates(tracks.size());
+    int removed = 0;
+    int runs    = 0;
+
+    for(int row = 0; row < tracks.size(); row++)
+    {
+        const QString& url = tracks.at(row)->url;
+        if(urls.contains(url)) {
+          duplicates.setBit(row);
+          if(row == 0 || !duplicates.testBit(row - 1))
+            runs++;
+          removed++;
         }
-        else
+        else {
+          urls.insert(url);
+        }
+    }
+
+    if(removed == 0)
+      return;
+
+    Debug::debug() << "--- PlayqueueModel-->removeDuplicate removed" << removed << "in" << runs << "runs";
+
+    if(runs > MAX_REMOVED_RUNS)
+    {
+        beginResetModel();
+        PlayqueueBase::removeTracks(duplicates);
+        endResetModel();
+    }
+    else
+    {
+        /* remove contiguous runs from the end so rows ahead stay valid */
+        int row = tracks.size() - 1;
+        while(row >= 0)
         {
-          filenames.insert( path );
+          if(!duplicates.testBit(row)) {
+            row--;
+            continue;
+          }
+
+          const int last = row;
+          while(row > 0 && duplicates.testBit(row - 1))
+            row--;
+
+          removeRows(row, last - row + 1, QModelIndex());
+          row--;
         }
     }
+
+    emit updated();
 }
 
 void PlayqueueModel::signalUpdate()
@@ -69,7 +69,8 @@ Q_OBJECT
     void addMediaItems(QList<MEDIA::TrackPtr>);
     //void insertMediaItem(const MEDIA::TrackPtr mediaitem, int pos=-1);
     void request_insert_track(const MEDIA::TrackPtr mediaitem, int pos=-1);
-    void removeDuplicate();
+    void request_insert_tracks(const QList<MEDIA::TrackPtr> tracks, int pos=-1);
+    void request_remove_duplicate();
 
     //! Stop After media Action
     MEDIA::TrackPtr stopAfterTrack() const;
@@ -84,10 +85,12 @@ Q_OBJECT
 
   private slots:
     void slot_insert_mediaitem(const MEDIA::TrackPtr media, int pos=-1);
+    void slot_insert_mediaitems(const QList<MEDIA::TrackPtr> list, int pos=-1);
     
  
   public slots:    
     void clear();
+    void removeDuplicate();
     void signalUpdate();
     void slot_sort(QVariant query);    
 
@@ -96,6 +99,8 @@ Q_OBJECT
     void updated();
     void modelCleared();
     void insertTrack(const MEDIA::TrackPtr, int);
+    void insertTracks(const QList<MEDIA::TrackPtr>, int);
+    void removeDuplicateRequested();
 
   private:
     PlayqueueProxyModel     *m_proxy_model;
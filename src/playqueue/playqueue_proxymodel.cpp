@@ -19,55 +19,271 @@
 #include "playqueue_model.h"
 #include "mediaitem.h"
 
+#include <QtAlgorithms>
+
+/*******************************************************************************
+ searchKey
+   case folded fields of a track joined by a separator, pattern never
+   contains a newline so a match can't overlap two fields
+*******************************************************************************/
+static const QChar KEY_SEPARATOR = QChar('\n');
+
+static QString searchKey(const MEDIA::TrackPtr track)
+{
+    QString key;
+    if(track->type() == TYPE_TRACK)
+      key = track->url + KEY_SEPARATOR + track->title + KEY_SEPARATOR + track->artist + KEY_SEPARATOR + track->album;
+    else
+      key = track->url + KEY_SEPARATOR + track->name + KEY_SEPARATOR + track->categorie;
+
+    return key.toCaseFolded();
+}
+
 
 PlayqueueProxyModel::PlayqueueProxyModel(QObject *parent) : QSortFilterProxyModel(parent)
 {
     setFilterRole(Qt::EditRole);
     setFilterCaseSensitivity(Qt::CaseInsensitive);
     setDynamicSortFilter(false);
+
+    m_is_prefix   = true;
+    m_cache_valid = false;
+    m_rows_valid  = false;
 }
 
+void PlayqueueProxyModel::setSourceModel(QAbstractItemModel *model)
+{
+    /* base class connects first : its handlers run before our slots */
+    QSortFilterProxyModel::setSourceModel(model);
+
+    connect(model, SIGNAL(rowsInserted(const QModelIndex&, int, int)), this, SLOT(slot_source_rows_inserted(const QModelIndex&, int, int)));
+    connect(model, SIGNAL(rowsRemoved(const QModelIndex&, int, int)), this, SLOT(slot_source_rows_removed(const QModelIndex&, int, int)));
+    connect(model, SIGNAL(dataChanged(const QModelIndex&, const QModelIndex&)), this, SLOT(slot_source_data_changed(const QModelIndex&, const QModelIndex&)));
+    connect(model, SIGNAL(layoutAboutToBeChanged()), this, SLOT(slot_source_layout_changed()));
+    connect(model, SIGNAL(modelAboutToBeReset()), this, SLOT(slot_source_layout_changed()));
+
+    m_cache_valid = false;
+}
+
+
 bool PlayqueueProxyModel::filterAcceptsRow(int sourceRow,const QModelIndex &sourceParent) const
 {
-Q_UNUSED(sourceParent)  
-    // get track
+Q_UNUSED(sourceParent)
+    if(filterRegExp().pattern().isEmpty())
+      return true;
+
+    updateCache();
+
+    if(isCacheSynced())
+      return m_accepted.testBit(sourceRow);
+
+    /* source is being modified, cache is updated after the change */
     PlayqueueModel* source_model = static_cast<PlayqueueModel*>(sourceModel());
     MEDIA::TrackPtr track = source_model->trackAt(sourceRow);
-    
-    const QString pattern = filterRegExp().pattern();
-    if(pattern.isEmpty())
-      return true;
-    
-    if(track->type() == TYPE_TRACK) {
-      if(pattern.length() < 3) 
-      {
-        return  (track->url.startsWith ( pattern, Qt::CaseInsensitive )   ||
-                 track->title.startsWith ( pattern, Qt::CaseInsensitive ) ||
-                 track->artist.startsWith ( pattern, Qt::CaseInsensitive ) ||
-                 track->album.startsWith ( pattern, Qt::CaseInsensitive ) );
-      }
-      else
-      {
-        return  (track->url.contains ( pattern, Qt::CaseInsensitive )   ||
-                 track->title.contains ( pattern, Qt::CaseInsensitive ) ||
-                 track->artist.contains ( pattern, Qt::CaseInsensitive ) ||
-                 track->album.contains ( pattern, Qt::CaseInsensitive ) );
-      }
+    if(!track)
+      return false;
+
+    return keyAccepted( searchKey(track) );
+}
+
+
+/*******************************************************************************
+ keyAccepted
+*******************************************************************************/
+bool PlayqueueProxyModel::keyAccepted(const QString& key) const
+{
+    if(m_is_prefix)
+      return key.startsWith(m_pattern) || key.contains(m_pattern_word);
+
+    return key.contains(m_pattern);
+}
+
+/*******************************************************************************
+ filter cache
+*******************************************************************************/
+bool PlayqueueProxyModel::isCacheSynced() const
+{
+    return m_cache_valid && m_keys.size() == sourceModel()->rowCount();
+}
+
+void PlayqueueProxyModel::updateCache() const
+{
+    const QString raw_pattern = filterRegExp().pattern();
+    const QString pattern     = raw_pattern.toCaseFolded();
+    const bool pattern_changed = (pattern != m_pattern);
+
+    if(pattern_changed) {
+      m_pattern      = pattern;
+      m_pattern_word = KEY_SEPARATOR + pattern;
+      m_is_prefix    = raw_pattern.length() < 3;
     }
-    else { // STREAM TYPE
-      if(pattern.length() < 3) 
-      {
-        return  (track->url.startsWith ( pattern, Qt::CaseInsensitive )   ||
-                 track->name.startsWith ( pattern, Qt::CaseInsensitive )  ||
-                 track->categorie.startsWith ( pattern, Qt::CaseInsensitive ));
-      }
-      else
-      {
-        return  (track->url.contains ( pattern, Qt::CaseInsensitive )   ||
-                 track->name.contains ( pattern, Qt::CaseInsensitive )  ||
-                 track->categorie.contains ( pattern, Qt::CaseInsensitive ));
+
+    PlayqueueModel* source_model = static_cast<PlayqueueModel*>(sourceModel());
+
+    /* full build of search keys */
+    if(!m_cache_valid)
+    {
+      const int count = source_model->rowCount();
+      m_keys.resize(count);
+      for(int i = 0; i < count; i++)
+        m_keys[i] = searchKey(source_model->trackAt(i));
+
+      m_cache_valid = true;
+    }
+    else if(!pattern_changed || !isCacheSynced())
+      return;
+
+    /* accepted rows from cached keys */
+    m_accepted.resize(m_keys.size());
+    for(int i = 0; i < m_keys.size(); i++)
+      m_accepted.setBit(i, keyAccepted(m_keys.at(i)));
+
+    m_rows_valid = false;
+}
+
+void PlayqueueProxyModel::updateAcceptedRows() const
+{
+    if(m_rows_valid)
+      return;
+
+    m_accepted_rows.clear();
+    for(int i = 0; i < m_accepted.size(); i++)
+      if(m_accepted.testBit(i))
+        m_accepted_rows.append(i);
+
+    m_rows_valid = true;
+}
+
+
+void PlayqueueProxyModel::slot_source_rows_inserted(const QModelIndex &, int start, int end)
+{
+    if(!m_cache_valid || isCacheSynced())
+      return;
+
+    PlayqueueModel* source_model = static_cast<PlayqueueModel*>(sourceModel());
+    const int count     = end - start + 1;
+    const int old_size  = m_keys.size();
+
+    if(old_size + count != source_model->rowCount()) {
+      m_cache_valid = false;
+      return;
+    }
+
+    m_keys.insert(start, count, QString());
+    m_accepted.resize(old_size + count);
+
+    /* shift bitmap */
+    for(int i = old_size - 1; i >= start; i--)
+      m_accepted.setBit(i + count, m_accepted.testBit(i));
+
+    for(int i = start; i <= end; i++) {
+      m_keys[i] = searchKey(source_model->trackAt(i));
+      m_accepted.setBit(i, keyAccepted(m_keys.at(i)));
+    }
+
+    m_rows_valid = false;
+}
+
+void PlayqueueProxyModel::slot_source_rows_removed(const QModelIndex &, int start, int end)
+{
+    if(!m_cache_valid || isCacheSynced())
+      return;
+
+    const int count     = end - start + 1;
+    const int old_size  = m_keys.size();
+
+    if(old_size - count != sourceModel()->rowCount()) {
+      m_cache_valid = false;
+      return;
+    }
+
+    m_keys.remove(start, count);
+
+    /* shift bitmap */
+    for(int i = end + 1; i < old_size; i++)
+      m_accepted.setBit(i - count, m_accepted.testBit(i));
+    m_accepted.resize(old_size - count);
+
+    m_rows_valid = false;
+}
+
+void PlayqueueProxyModel::slot_source_data_changed(const QModelIndex &topLeft, const QModelIndex &bottomRight)
+{
+    if(!m_cache_valid)
+      return;
+
+    /* edited tags or stream title : re-key and re-test changed rows */
+    if(!topLeft.isValid() || !bottomRight.isValid() || !isCacheSynced()) {
+      m_cache_valid = false;
+      m_rows_valid  = false;
+      return;
+    }
+
+    PlayqueueModel* source_model = static_cast<PlayqueueModel*>(sourceModel());
+    const int last = qMin(bottomRight.row(), m_keys.size() - 1);
+
+    for(int i = qMax(topLeft.row(), 0); i <= last; i++) {
+      MEDIA::TrackPtr track = source_model->trackAt(i);
+      if(!track) {
+        m_cache_valid = false;
+        m_rows_valid  = false;
+        return;
       }
+
+      m_keys[i] = searchKey(track);
+      if(m_accepted.size() == m_keys.size())
+        m_accepted.setBit(i, keyAccepted(m_keys.at(i)));
+    }
+
+    m_rows_valid = false;
+}
+
+void PlayqueueProxyModel::slot_source_layout_changed()
+{
+    m_cache_valid = false;
+    m_rows_valid  = false;
+}
+
+
+/*******************************************************************************
+ nextAcceptedRow / prevAcceptedRow
+*******************************************************************************/
+int PlayqueueProxyModel::nextAcceptedRow(int sourceRow) const
+{
+    const int count = sourceModel()->rowCount();
+
+    if(filterRegExp().pattern().isEmpty())
+      return (sourceRow + 1 < count) ? qMax(sourceRow + 1, 0) : -1;
+
+    updateCache();
+    if(!isCacheSynced()) {
+      for(int i = qMax(sourceRow + 1, 0); i < count; i++)
+        if(filterAcceptsRow(i)) return i;
+      return -1;
+    }
+
+    updateAcceptedRows();
+    QVector<int>::const_iterator it = qUpperBound(m_accepted_rows.constBegin(), m_accepted_rows.constEnd(), sourceRow);
+
+    return (it != m_accepted_rows.constEnd()) ? *it : -1;
+}
+
+int PlayqueueProxyModel::prevAcceptedRow(int sourceRow) const
+{
+    const int count = sourceModel()->rowCount();
+
+    if(filterRegExp().pattern().isEmpty())
+      return qMax(qMin(sourceRow, count) - 1, -1);
+
+    updateCache();
+    if(!isCacheSynced()) {
+      for(int i = qMin(sourceRow, count) - 1; i >= 0; i--)
+        if(filterAcceptsRow(i)) return i;
+      return -1;
     }
 
-    return true;
+    updateAcceptedRows();
+    QVector<int>::const_iterator it = qLowerBound(m_accepted_rows.constBegin(), m_accepted_rows.constEnd(), sourceRow);
+
+    return (it != m_accepted_rows.constBegin()) ? *(it - 1) : -1;
 }
@@ -22,6 +22,8 @@
 #include <QString>
 #include <QModelIndex>
 #include <QSortFilterProxyModel>
+#include <QBitArray>
+#include <QVector>
 
 //! PlayqueueProxyModel is a filter model for playlist
 class PlayqueueProxyModel : public QSortFilterProxyModel
@@ -30,12 +32,39 @@ Q_OBJECT
 
 public:
     PlayqueueProxyModel(QObject *parent = 0);
-  
+
+    void setSourceModel(QAbstractItemModel *sourceModel);
+
     //! Decides wheter the source row will be displayed of hidden
     bool filterAcceptsRow(int sourceRow, const QModelIndex &sourceParent = QModelIndex()) const;
 
+    //! next/previous accepted source row (-1 if none)
+    int nextAcceptedRow(int sourceRow) const;
+    int prevAcceptedRow(int sourceRow) const;
+
+private slots:
+    void slot_source_rows_inserted(const QModelIndex &parent, int start, int end);
+    void slot_source_rows_removed(const QModelIndex &parent, int start, int end);
+    void slot_source_data_changed(const QModelIndex &topLeft, const QModelIndex &bottomRight);
+    void slot_source_layout_changed();
+
+private:
+    bool isCacheSynced() const;
+    void updateCache() const;
+    void updateAcceptedRows() const;
+    bool keyAccepted(const QString& key) const;
+
 private:
-    QString    m_pattern;
+    /* case folded search keys per source row + accepted row bitmap,
+       recomputed when filter pattern, playqueue rows or track data change */
+    mutable QString            m_pattern;
+    mutable QString            m_pattern_word;
+    mutable bool               m_is_prefix;
+    mutable QVector<QString>   m_keys;
+    mutable QBitArray          m_accepted;
+    mutable QVector<int>       m_accepted_rows;
+    mutable bool               m_cache_valid;
+    mutable bool               m_rows_valid;
 };
 
 #endif // _PLAYQUEUE_PROXYMODEL_H_
@@ -0,0 +1,364 @@
+/****************************************************************************************
+*  YAROCK                                                                               *
+*  Copyright (c) 2010-2014 Sebastien amardeilh <sebastien.amardeilh+yarock@gmail.com>   *
+*                                                                                       *
+*  This program is free software; you can redistribute it and/or modify it under        *
+*  the terms of the GNU General Public License as published by the Free Software        *
+*  Foundation; either version 2 of the License, or (at your option) any later           *
+*  version.                                                                             *
+*                                                                                       *
+*  This program is distributed in the hope that it will be useful, but WITHOUT ANY      *
+*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A      *
+*  PARTICULAR PURPOSE. See the GNU General Public License for more details.             *
+*                                                                                       *
+*  You should have received a copy of the GNU General Public License along with         *
+*  this program.  If not, see <http://www.gnu.org/licenses/>.                           *
+*****************************************************************************************/
+
+#include "playqueue_session.h"
+#include "playqueue_model.h"
+
+#include "models/local/local_track_model.h"
+#include "core/database/databasemanager.h"
+#include "utilities.h"
+#include "debug.h"
+
+#include <QFile>
+#include <QDataStream>
+#include <QHash>
+
+/*
+    session file layout (QDataStream)
+      header : magic, version, playing row, track count, database name
+      record : id, flags, type, url, name, title, artist, album, genre,
+               duration, num, year
+
+    the flags byte sits at a fixed offset of each record, so played state
+    changes are written in place and appended tracks only add records
+*/
+static const quint32 SESSION_MAGIC   = 0x59525153;
+static const quint32 SESSION_VERSION = 1;
+static const int     SAVE_DELAY      = 2000; /* ms */
+
+/* collection never populated : restore without binding tracks to it */
+static const int     RESTORE_TIMEOUT = 60000; /* ms */
+
+/* record layout : qint32 id precedes flags */
+static const qint64  FLAGS_OFFSET    = 4;
+
+enum E_SESSION_FLAG { FLAG_PLAYED = 0x1 };
+
+/*
+********************************************************************************
+*                                                                              *
+*    Class PlayqueueSession                                                    *
+*                                                                              *
+********************************************************************************
+*/
+PlayqueueSession::PlayqueueSession(PlayqueueModel* model, QObject* parent) : QObject(parent)
+{
+    m_model           = model;
+
+    /* keep previous session untouched until it has been restored or discarded */
+    m_restore_pending = QFile::exists(sessionFile());
+    m_header_size     = 0;
+    m_end             = 0;
+
+    m_timer = new QTimer(this);
+    m_timer->setSingleShot(true);
+    m_timer->setInterval(SAVE_DELAY);
+    connect(m_timer, SIGNAL(timeout()), this, SLOT(save()));
+
+    m_restore_timer = new QTimer(this);
+    m_restore_timer->setSingleShot(true);
+    m_restore_timer->setInterval(RESTORE_TIMEOUT);
+    connect(m_restore_timer, SIGNAL(timeout()), this, SLOT(slot_on_restore_timeout()));
+
+    connect(m_model, SIGNAL(rowsInserted(QModelIndex,int,int)), this, SLOT(slot_schedule_save()));
+    connect(m_model, SIGNAL(rowsRemoved(QModelIndex,int,int)), this, SLOT(slot_schedule_save()));
+    connect(m_model, SIGNAL(dataChanged(QModelIndex,QModelIndex)), this, SLOT(slot_schedule_save()));
+    connect(m_model, SIGNAL(layoutChanged()), this, SLOT(slot_schedule_save()));
+    connect(m_model, SIGNAL(modelReset()), this, SLOT(slot_schedule_save()));
+}
+
+
+QString PlayqueueSession::sessionFile()
+{
+    return QString(UTIL::CONFIGDIR).append("/playqueue.session");
+}
+
+
+quint8 PlayqueueSession::flagsOf(const MEDIA::TrackPtr track)
+{
+    return track->isPlayed ? FLAG_PLAYED : 0;
+}
+
+
+void PlayqueueSession::slot_schedule_save()
+{
+    /* bounded delay : do not restart a pending save */
+    if(!m_restore_pending && !m_timer->isActive())
+      m_timer->start();
+}
+
+/*******************************************************************************
+  PlayqueueSession::restoreOnPopulated
+    -> return false if there is no session to restore
+*******************************************************************************/
+bool PlayqueueSession::restoreOnPopulated()
+{
+    if(!m_restore_pending)
+      return false;
+
+    connect(ThreadManager::instance(), SIGNAL(modelPopulationFinished(E_MODEL_TYPE)),
+            this, SLOT(slot_on_model_populated(E_MODEL_TYPE)));
+
+    m_restore_timer->start();
+    return true;
+}
+
+
+void PlayqueueSession::discard()
+{
+    m_restore_timer->stop();
+    m_restore_pending = false;
+    slot_schedule_save();
+}
+
+
+void PlayqueueSession::slot_on_model_populated(E_MODEL_TYPE type)
+{
+    if(type == MODEL_PLAYLIST)
+      return;
+
+    finishRestore();
+}
+
+
+void PlayqueueSession::slot_on_restore_timeout()
+{
+    Debug::warning() << "PlayqueueSession -> collection not populated, restore session anyway";
+
+    finishRestore();
+}
+
+
+void PlayqueueSession::finishRestore()
+{
+    if(!m_restore_pending)
+      return;
+
+    m_restore_timer->stop();
+    disconnect(ThreadManager::instance(), SIGNAL(modelPopulationFinished(E_MODEL_TYPE)),
+               this, SLOT(slot_on_model_populated(E_MODEL_TYPE)));
+
+    restore();
+
+    /* tracks queued meanwhile are kept, next save rewrites the file */
+    m_restore_pending = false;
+    slot_schedule_save();
+}
+
+/*******************************************************************************
+  PlayqueueSession::restore
+    -> collection tracks are bound to LocalTrackModel items by id, other
+       tracks are rebuilt from the stored metadata
+*******************************************************************************/
+void PlayqueueSession::restore()
+{
+    QFile file(sessionFile());
+    if(!file.open(QIODevice::ReadOnly))
+      return;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+
+    quint32 magic, version;
+    qint32  playing_row, count;
+    QString db_name;
+    stream >> magic >> version;
+
+    if(magic != SESSION_MAGIC || version != SESSION_VERSION) {
+      Debug::warning() << "PlayqueueSession -> invalid session file";
+      return;
+    }
+
+    stream >> playing_row >> count >> db_name;
+    const qint64 header_size = file.pos();
+
+    /* track ids are only meaningful for the database they come from */
+    const bool bind_ids = (db_name == DatabaseManager::instance()->DB_NAME);
+    const QHash<int, MEDIA::TrackPtr> collection = LocalTrackModel::instance()->trackItemHash;
+
+    QList<MEDIA::TrackPtr>  tracks;
+    QVector<qint64>         offsets;
+    QVector<quint8>         flags;
+
+    for(int i = 0; i < count; i++)
+    {
+      const qint64 offset = file.pos();
+
+      qint32  id, duration, num, year;
+      quint8  track_flags, type;
+      QString url, name, title, artist, album, genre;
+
+      stream >> id >> track_flags >> type;
+      stream >> url >> name >> title >> artist >> album >> genre;
+      stream >> duration >> num >> year;
+
+      /* truncated file : keep what has been read */
+      if(stream.status() != QDataStream::Ok)
+        break;
+
+      MEDIA::TrackPtr track;
+      if(bind_ids && id != -1 && collection.contains(id))
+      {
+        track = collection.value(id);
+      }
+      else
+      {
+        track = MEDIA::TrackPtr(new MEDIA::Track());
+        track->setType((T_TYPE) type);
+        track->id          = -1;
+        track->url         = url;
+        track->name        = name;
+        track->title       = title;
+        track->artist      = artist;
+        track->album       = album;
+        track->genre       = genre;
+        track->duration    = duration;
+        track->num         = num;
+        track->year        = year;
+        track->isPlaying   = false;
+        track->isBroken    = false;
+        track->isStopAfter = false;
+      }
+
+      track->isPlayed = (track_flags & FLAG_PLAYED);
+
+      tracks  << track;
+      offsets << offset;
+      flags   << flagsOf(track);
+    }
+
+    Debug::debug() << "PlayqueueSession -> restored tracks" << tracks.size();
+
+    if(tracks.isEmpty())
+      return;
+
+    const int first_row = m_model->rowCount();
+    m_model->addMediaItems(tracks);
+
+    if(playing_row >= 0 && playing_row < tracks.size())
+      m_model->updatePlayingItem(tracks.at(playing_row));
+
+    /* queue already had tracks : next save rewrites the file */
+    if(first_row != 0 || tracks.size() != count)
+      return;
+
+    m_written     = tracks;
+    m_offsets     = offsets;
+    m_flags       = flags;
+    m_header_size = header_size;
+    m_end         = file.pos();
+}
+
+/*******************************************************************************
+  PlayqueueSession::save
+    -> records of unchanged leading tracks are kept, the file is truncated
+       after them and the remaining tracks are appended
+*******************************************************************************/
+void PlayqueueSession::save()
+{
+    m_timer->stop();
+
+    if(m_restore_pending)
+      return;
+
+    const QList<MEDIA::TrackPtr> tracks = m_model->tracks();
+
+    if(tracks.isEmpty())
+    {
+      QFile::remove(sessionFile());
+      m_written.clear();
+      m_offsets.clear();
+      m_flags.clear();
+      m_end = 0;
+      return;
+    }
+
+    QFile file(sessionFile());
+    if(!file.open(QIODevice::ReadWrite)) {
+      Debug::warning() << "PlayqueueSession -> cannot write" << sessionFile();
+      return;
+    }
+
+    QByteArray header;
+    {
+      QDataStream header_stream(&header, QIODevice::WriteOnly);
+      header_stream.setVersion(QDataStream::Qt_4_6);
+
+      const int playing_row = m_model->rowForTrack(m_model->playingTrack());
+      header_stream << SESSION_MAGIC << SESSION_VERSION << (qint32) playing_row << (qint32) tracks.size();
+      header_stream << DatabaseManager::instance()->DB_NAME;
+    }
+
+    /* file content does not match what we think has been written */
+    if(file.size() != m_end || header.size() != m_header_size) {
+      m_written.clear();
+      m_offsets.clear();
+      m_flags.clear();
+      m_header_size = header.size();
+      m_end         = m_header_size;
+    }
+
+    /* first track that differs from the written ones */
+    int first = 0;
+    while(first < m_written.size() && first < tracks.size() &&
+          m_written.at(first) == tracks.at(first))
+      first++;
+
+    QDataStream stream(&file);
+    stream.setVersion(QDataStream::Qt_4_6);
+
+    /* update played flags of kept records in place */
+    for(int row = 0; row < first; row++)
+    {
+      const quint8 track_flags = flagsOf(tracks.at(row));
+      if(track_flags != m_flags.at(row)) {
+        file.seek(m_offsets.at(row) + FLAGS_OFFSET);
+        stream << track_flags;
+        m_flags[row] = track_flags;
+      }
+    }
+
+    /* drop records after the first change */
+    if(first < m_written.size()) {
+      m_end = m_offsets.at(first);
+      m_written = m_written.mid(0, first);
+      m_offsets.resize(first);
+      m_flags.resize(first);
+    }
+
+    file.seek(0);
+    file.write(header);
+
+    file.resize(m_end);
+    file.seek(m_end);
+
+    for(int row = first; row < tracks.size(); row++)
+    {
+      const MEDIA::TrackPtr track = tracks.at(row);
+      const quint8 track_flags    = flagsOf(track);
+
+      m_written << track;
+      m_offsets << file.pos();
+      m_flags   << track_flags;
+
+      stream << (qint32) track->id << track_flags << (quint8) track->type();
+      stream << track->url << track->name << track->title << track->artist << track->album << track->genre;
+      stream << (qint32) track->duration << (qint32) track->num << (qint32) track->year;
+    }
+
+    m_end = file.pos();
+}
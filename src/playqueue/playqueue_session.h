@@ -0,0 +1,83 @@
+/****************************************************************************************
+*  YAROCK                                                                               *
+*  Copyright (c) 2010-2014 Sebastien amardeilh <sebastien.amardeilh+yarock@gmail.com>   *
+*                                                                                       *
+*  This program is free software; you can redistribute it and/or modify it under        *
+*  the terms of the GNU General Public License as published by the Free Software        *
+*  Foundation; either version 2 of the License, or (at your option) any later           *
+*  version.                                                                             *
+*                                                                                       *
+*  This program is distributed in the hope that it will be useful, but WITHOUT ANY      *
+*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A      *
+*  PARTICULAR PURPOSE. See the GNU General Public License for more details.             *
+*                                                                                       *
+*  You should have received a copy of the GNU General Public License along with         *
+*  this program.  If not, see <http://www.gnu.org/licenses/>.                           *
+*****************************************************************************************/
+
+#ifndef _PLAYQUEUE_SESSION_H_
+#define _PLAYQUEUE_SESSION_H_
+
+#include "core/mediaitem/mediaitem.h"
+#include "threadmanager.h"
+
+#include <QObject>
+#include <QString>
+#include <QList>
+#include <QVector>
+#include <QTimer>
+
+class PlayqueueModel;
+/*
+********************************************************************************
+*                                                                              *
+*    Class PlayqueueSession                                                    *
+*      binary snapshot of the playqueue content, written incrementally while   *
+*      the queue changes and restored at startup without sql or tag reading    *
+*                                                                              *
+********************************************************************************
+*/
+class PlayqueueSession : public QObject
+{
+Q_OBJECT
+  public:
+    PlayqueueSession(PlayqueueModel* model, QObject* parent = 0);
+
+    static QString sessionFile();
+
+    /* restore once collection model has been populated */
+    bool restoreOnPopulated();
+
+    /* previous session is not wanted */
+    void discard();
+
+  public slots:
+    /* write pending changes now */
+    void save();
+
+  private slots:
+    void slot_schedule_save();
+    void slot_on_model_populated(E_MODEL_TYPE type);
+    void slot_on_restore_timeout();
+
+  private:
+    void finishRestore();
+    void restore();
+    static quint8 flagsOf(const MEDIA::TrackPtr track);
+
+  private:
+    PlayqueueModel           *m_model;
+    QTimer                   *m_timer;
+    QTimer                   *m_restore_timer;
+    bool                      m_restore_pending;
+
+    /* tracks already written, with their record offset and written flags,
+       references are kept so a record never matches a newly allocated track */
+    QList<MEDIA::TrackPtr>    m_written;
+    QVector<qint64>           m_offsets;
+    QVector<quint8>           m_flags;
+    qint64                    m_header_size;
+    qint64                    m_end;
+};
+
+#endif // _PLAYQUEUE_SESSION_H_
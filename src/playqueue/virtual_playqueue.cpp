@@ -36,7 +36,7 @@ VirtualPlayqueue::VirtualPlayqueue(QObject *parent) : QObject(parent)
 /*****************************************************************************************
     VirtualPlayqueue::addTracksAndPlayAt
 *****************************************************************************************/
-void VirtualPlayqueue::addTracksAndPlayAt(QList<MEDIA::TrackPtr> tracks, int startIdx)
+void VirtualPlayqueue::addTracksAndPlayAt(const QList<MEDIA::TrackPtr>& tracks, int startIdx)
 {
     //Debug::debug() << "[VirtualPlayqueue] addTracksAndPlayAt";
     if (tracks.isEmpty()) 
@@ -39,7 +39,7 @@ Q_OBJECT
     VirtualPlayqueue(QObject *parent=0);
     static VirtualPlayqueue* instance() { return INSTANCE; }
   
-    void addTracksAndPlayAt(QList<MEDIA::TrackPtr> tracks, int startIdx=0);
+    void addTracksAndPlayAt(const QList<MEDIA::TrackPtr>& tracks, int startIdx=0);
     void addTrackAndPlay(const MEDIA::TrackPtr track);
     
     void updatePlayingItem(MEDIA::TrackPtr);
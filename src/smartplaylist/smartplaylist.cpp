@@ -36,6 +36,11 @@
 
 #include <QString>
 #include <QDataStream>
+#include <QMutexLocker>
+#include <QtGlobal>        // qrand
+
+QHash<QByteArray, SmartPlaylist::CacheEntry>  SmartPlaylist::m_cache;
+QMutex                                        SmartPlaylist::m_cache_mutex;
 
 
 /*
@@ -136,15 +141,121 @@ QList<MediaSearch> list_search = QList<MediaSearch>()
 QList<MEDIA::TrackPtr> SmartPlaylist::mediaItem(QVariant search_variant)
 {
     //Debug::debug() << "SmartPlaylist--> get mediaitem start : " << QTime::currentTime().toString();
+    const QByteArray key = search_variant.toByteArray();
+
+    {
+      QMutexLocker locker(&m_cache_mutex);
+      if(m_cache.contains(key)) {
+        const CacheEntry entry = m_cache.value(key);
+        locker.unlock();
+
+        if(entry.random)
+          return randomSample(entry.tracks, entry.limit);
+        return entry.tracks;
+      }
+    }
 
     MediaSearch media_search = MediaSearch::fromQVariant(search_variant);
 
-    SearchEngine* search_engine = new SearchEngine();
-    search_engine->init_search_engine(media_search);
-    search_engine->doSearch();
+    CacheEntry entry;
+    entry.dependencies = dependenciesOf(media_search);
+    entry.random       = false;
+    entry.limit        = -1;
+
+    /* random result : cache every matching track and draw the sample on demand */
+    if(media_search.sort_type_ == MediaSearch::Sort_Random) {
+      entry.random             = true;
+      entry.limit              = media_search.limit_;
+      media_search.sort_type_  = MediaSearch::Sort_No;
+      media_search.limit_      = -1;
+    }
+
+    SearchEngine search_engine;
+    search_engine.init_search_engine(media_search);
+    search_engine.doSearch();
+    entry.tracks = search_engine.result();
+
+    {
+      QMutexLocker locker(&m_cache_mutex);
+      m_cache.insert(key, entry);
+    }
 
     //Debug::debug() << "SmartPlaylist--> get mediaitem end : " << QTime::currentTime().toString();
-    return  search_engine->result();
+    if(entry.random)
+      return randomSample(entry.tracks, entry.limit);
+    return entry.tracks;
+}
+
+/*******************************************************************************
+ SmartPlaylist::invalidateCache
+   drop cached results depending on changed data
+*******************************************************************************/
+void SmartPlaylist::invalidateCache(int dependencies)
+{
+    QMutexLocker locker(&m_cache_mutex);
+
+    if(dependencies == DEP_ALL) {
+      m_cache.clear();
+      return;
+    }
+
+    QHash<QByteArray, CacheEntry>::iterator it = m_cache.begin();
+    while (it != m_cache.end()) {
+      if(it.value().dependencies & dependencies)
+        it = m_cache.erase(it);
+      else
+        ++it;
+    }
+}
+
+/*******************************************************************************
+ SmartPlaylist::dependenciesOf
+*******************************************************************************/
+int SmartPlaylist::dependenciesOf(const MediaSearch& search)
+{
+    QList<SearchQuery::Search_Field> fields;
+
+    if(search.search_type_ != MediaSearch::Type_All)
+      foreach(const SearchQuery& query, search.query_list_)
+        fields << query.field_;
+
+    if(search.sort_type_ == MediaSearch::Sort_FieldAsc || search.sort_type_ == MediaSearch::Sort_FieldDesc)
+      fields << search.sort_field_;
+
+    int dependencies = DEP_NONE;
+    foreach(SearchQuery::Search_Field field, fields)
+    {
+      switch(field)
+      {
+        case SearchQuery::field_track_playcount  :
+        case SearchQuery::field_artist_playcount :
+        case SearchQuery::field_album_playcount  :
+        case SearchQuery::field_track_lastPlayed : dependencies |= DEP_PLAYCOUNT; break;
+
+        case SearchQuery::field_track_rating     :
+        case SearchQuery::field_album_rating     :
+        case SearchQuery::field_artist_rating    : dependencies |= DEP_RATING;    break;
+
+        default                                  : dependencies |= DEP_TAGS;      break;
+      }
+    }
+
+    return dependencies;
+}
+
+/*******************************************************************************
+ SmartPlaylist::randomSample
+   partial Fisher-Yates shuffle, only the first limit entries are drawn
+*******************************************************************************/
+QList<MEDIA::TrackPtr> SmartPlaylist::randomSample(QList<MEDIA::TrackPtr> tracks, int limit)
+{
+    const int size  = tracks.size();
+    const int count = (limit == -1 || limit > size) ? size : limit;
+
+    for(int i = 0; i < count; i++)
+      tracks.swap(i, i + qrand() % (size - i));
+
+    return tracks.mid(0, count);
 }
 
 
@@ -178,6 +289,12 @@ bool SmartPlaylist::edit_dialog(MEDIA::PlaylistPtr smart_playlist)
       //! set new media search rules values
       smart_playlist->rules = new_v_search;
 
+      //! drop result cached for old rules
+      {
+        QMutexLocker locker(&m_cache_mutex);
+        m_cache.remove(search_variant.toByteArray());
+      }
+
       //! edit in database
       Database db;
       if (!db.connect()) return false;
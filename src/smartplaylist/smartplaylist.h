@@ -18,8 +18,11 @@
 #define _SMART_PLAYLIST_H_
 
 #include "core/mediaitem/mediaitem.h"
+#include "core/mediasearch/media_search.h"
 
 #include <QtSql/QSqlDatabase>
+#include <QHash>
+#include <QMutex>
 
 /*
 ********************************************************************************
@@ -35,6 +38,15 @@ Q_OBJECT
 public:
     SmartPlaylist(QObject* parent =0);
 
+    /* data a smart playlist result may depend on */
+    enum E_DEPENDENCY {
+      DEP_NONE       = 0x00,
+      DEP_TAGS       = 0x01,  // title, artist, album, genre, year, ...
+      DEP_PLAYCOUNT  = 0x02,  // playcount and last played date
+      DEP_RATING     = 0x04,
+      DEP_ALL        = 0xFF   // collection update
+    };
+
 
     static void createDatabase(QSqlDatabase *sqlDB);
 
@@ -43,6 +55,22 @@ public:
     static bool edit_dialog(MEDIA::PlaylistPtr smart_playlist);
 
     static bool create_dialog();
+
+    static void invalidateCache(int dependencies = DEP_ALL);
+
+private:
+    struct CacheEntry {
+      QList<MEDIA::TrackPtr>  tracks;
+      int                     dependencies;
+      bool                    random;
+      int                     limit;       // random sample size, -1 for all tracks
+    };
+
+    static int dependenciesOf(const MediaSearch& search);
+    static QList<MEDIA::TrackPtr> randomSample(QList<MEDIA::TrackPtr> tracks, int limit);
+
+    static QHash<QByteArray, CacheEntry>  m_cache;
+    static QMutex                         m_cache_mutex;
 };
 
 #endif // _SMART_PLAYLIST_H_
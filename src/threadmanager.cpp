@@ -20,6 +20,8 @@
 #include "models/local/local_playlist_populator.h"
 #include "core/database/databasebuilder.h"
 #include "covers/covertask.h"
+#include "covers/covercache.h"
+#include "smartplaylist/smartplaylist.h"
 
 #include "widgets/statuswidget.h"
 
@@ -135,6 +137,9 @@ void ThreadManager::populateLocalTrackModel()
      cancelThread(POPULATOR_C_THREAD);
    }
 
+   /* collection is reloaded => smart playlist results are obsolete */
+   SmartPlaylist::invalidateCache(SmartPlaylist::DEP_ALL);
+
    m_localTrackPopulator->start();
 
    uint i = StatusWidget::instance()->startProgressMessage(tr("Loading music collection"));
@@ -152,6 +157,10 @@ void ThreadManager::slot_on_localtrackmodel_populated()
     if (messageIds.contains("LoadMusic"))
       StatusWidget::instance()->stopProgressMessage( messageIds.take("LoadMusic") );
 
+    /* drop any result computed while the collection was partially loaded */
+    SmartPlaylist::invalidateCache(SmartPlaylist::DEP_ALL);
+    CoverCache::instance()->reloadMissing();
+
     emit modelPopulationFinished(MODEL_COLLECTION);
 
     // for each collection update do LocalPlaylistModel update
@@ -235,6 +244,8 @@ void ThreadManager::coverSearchFinished()
 {
     Debug::debug() << "ThreadManager -> coverSearchFinished";
 
+    CoverCache::instance()->reloadMissing();
+
     if (messageIds.contains("CoverUpdate"))
       StatusWidget::instance()->stopProgressMessage( messageIds.take("CoverUpdate") );
 }
@@ -243,6 +254,9 @@ void ThreadManager::coverSearchProgress(int progress)
 {
     QString message = QString(tr("Fetching Album Cover") + " (%1%)").arg(QString::number(progress));
     StatusWidget::instance()->updateProgressMessage( messageIds.value("CoverUpdate"), message );
+
+    /* show covers fetched so far */
+    CoverCache::instance()->reloadMissing();
 }
 
 /*******************************************************************************
@@ -75,6 +75,7 @@ BrowserView::BrowserView(QWidget *parent) : QGraphicsView(parent)
     this->setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
     
     is_started = false;
+    m_pending_switch = false;
     
     /* scroll bar */
     m_scrollbar = this->verticalScrollBar();
@@ -151,6 +152,8 @@ void BrowserView::setLocalScene(LocalScene *scene)
     m_scenes.insert(VIEW::ViewPlaylist,       scene );
     m_scenes.insert(VIEW::ViewSmartPlaylist,  scene );
     m_scenes.insert(VIEW::ViewFavorite,       scene );
+
+    connect(scene, SIGNAL(layoutApplied()), this, SLOT(slot_on_local_layout_applied()));
 }
 
 void BrowserView::setStreamScene(StreamScene *scene)
@@ -377,6 +380,14 @@ void BrowserView::switch_view(BrowserParam& param)
       case VIEW::ABOUT      : setScene(static_cast<AboutScene*>(m_scenes[param.mode]));    break;
     }
 
+    /* local collection layout not yet applied, see slot_on_local_layout_applied */
+    m_pending_switch = VIEW::typeForView(param.mode) == VIEW::LOCAL &&
+                       static_cast<LocalScene*>(scene)->isLayoutPending();
+    m_pending_jump   = MEDIA::MediaPtr();
+
+    if(m_pending_switch)
+      return;
+
     /* restore scroll position */
     m_scrollbar->setSliderPosition(param.scroll);
 
@@ -384,6 +395,35 @@ void BrowserView::switch_view(BrowserParam& param)
     do_statuswidget_update();    
 }
 
+/*******************************************************************************
+    slot_on_local_layout_applied
+*******************************************************************************/
+void BrowserView::slot_on_local_layout_applied()
+{
+    if(!m_pending_switch) return;
+    m_pending_switch = false;
+
+    LocalScene* scene = static_cast<LocalScene*>(m_scenes[VIEW::ViewArtist]);
+
+    if(m_pending_jump)
+    {
+      /* localise item */
+      QPoint p = scene->get_item_position(m_pending_jump);
+      m_pending_jump = MEDIA::MediaPtr();
+
+      if(!p.isNull())
+        m_scrollbar->setSliderPosition( p.y() - 40 );
+    }
+    else if(m_browser_params_idx >= 0)
+    {
+      /* restore scroll position */
+      m_scrollbar->setSliderPosition(m_browser_params.at(m_browser_params_idx).scroll);
+    }
+
+    /* status widget update */
+    do_statuswidget_update();
+}
+
     
 /*******************************************************************************
     slot_jump_to_media
@@ -444,6 +484,12 @@ void BrowserView::jump_to_media(MEDIA::MediaPtr media)
       
     active_view(mode,"", QVariant());
 
+    /* item position is known once the layout is applied */
+    if(m_pending_switch) {
+      m_pending_jump = media;
+      return;
+    }
+
     /* localise item */
     QPoint p = static_cast<LocalScene*>(m_scenes[mode])->get_item_position(media);
 
@@ -72,6 +72,7 @@ private slots:
     void slot_on_model_populated(E_MODEL_TYPE);
     void slot_jump_to_media();
     void slot_check_slider(int);
+    void slot_on_local_layout_applied();
 
     void slot_on_menu_index_changed(QModelIndex idx);
     void slot_on_load_new_data(const QString&);    
@@ -115,6 +116,10 @@ private :
     /* scroll position */
     QScrollBar           *m_scrollbar;
     QMap<VIEW::Id, int>  scrolls;
+
+    /* local scene layout is applied asynchronously */
+    bool                 m_pending_switch;
+    MEDIA::MediaPtr      m_pending_jump;
    
     bool is_started;
     
@@ -18,6 +18,7 @@
 #include "context_scene.h"
 
 #include "core/player/engine.h"
+#include "covers/covercache.h"
 
 /*   info providers   */
 #include "info_system.h"
@@ -83,6 +84,7 @@ void ContextScene::initScene()
     //! now playing widget
     m_nowplaying_info_widget = new NowPlayingInfoWidget(parentView());
     connect(m_engine_player, SIGNAL(mediaMetaDataChanged()), m_nowplaying_info_widget, SLOT(update()));
+    connect(CoverCache::instance(), SIGNAL(coversLoaded()), m_nowplaying_info_widget, SLOT(update()));
     m_nowplaying_info_widget->setSizePolicy( QSizePolicy::Preferred, QSizePolicy::Preferred );
 
     //! layout 
@@ -634,7 +634,7 @@ void AlbumInfoWidget::set_track(MEDIA::TrackPtr track)
             html_text += "<p>" + QString::number(track->num) + " " + track->title + "</p>";
         } 
       
-        m_image->setPixmap( CoverCache::instance()->cover(album) );
+        m_image->setPixmap( CoverCache::instance()->cover(album, CoverStore::SIZE_LARGE) );
       
         m_songs->setHtml(html_text);
         m_songs->updateItem();
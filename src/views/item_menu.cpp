@@ -25,6 +25,7 @@
 #include "playqueue/virtual_playqueue.h"
 
 #include "mediaitem.h"
+#include "covers/covercache.h"
 #include "global_actions.h"
 #include "settings.h"
 
@@ -185,6 +186,7 @@ void GraphicsItemMenu::updateMenu(bool isSelection)
     else if( m_items.first()->type() == GraphicsItem::AlbumType )
     {
       scene = new QGraphicsScene(main_widget);
+      connect(CoverCache::instance(), SIGNAL(coversLoaded()), scene, SLOT(update()));
       view = new QGraphicsView(main_widget);
     
       /* QGraphicsView setup */  
@@ -291,6 +293,7 @@ void GraphicsItemMenu::updateMenu(bool isSelection)
     else if( m_items.first()->type() == GraphicsItem::AlbumGenreType )
     {
       scene = new QGraphicsScene(main_widget);
+      connect(CoverCache::instance(), SIGNAL(coversLoaded()), scene, SLOT(update()));
       view = new QGraphicsView(main_widget);
     
       /* QGraphicsView setup */  
@@ -391,6 +394,7 @@ void GraphicsItemMenu::updateMenu(bool isSelection)
     {
       //Debug::debug() << "GraphicsItemMenu::ArtistType";
       scene = new QGraphicsScene(main_widget);
+      connect(CoverCache::instance(), SIGNAL(coversLoaded()), scene, SLOT(update()));
       view = new QGraphicsView(main_widget);
     
       /* QGraphicsView setup */  
@@ -42,6 +42,86 @@
 #include <QtGui>
 
 
+/*******************************************************************************
+    shadowed covers, composites are cached in CoverCache by style, size and
+    covers pixmap cacheKey (a decoded cover replaces its placeholder key)
+*******************************************************************************/
+static QPixmap shadowedAlbumCover(const MEDIA::AlbumPtr album, const QSize& size, const QPoint& pos)
+{
+    const QPixmap cover = CoverCache::instance()->coverAsync(album);
+
+    const QString key = QString("album:%1x%2:%3,%4:%5").arg(size.width()).arg(size.height())
+                                                      .arg(pos.x()).arg(pos.y()).arg(cover.cacheKey());
+    QPixmap shadowed;
+    if(CoverCache::instance()->findShadowed(key, &shadowed))
+      return shadowed;
+
+    QPixmap pixTemp(size);
+    {
+      pixTemp.fill(Qt::transparent);
+      QPainter p;
+      p.begin(&pixTemp);
+
+      //! paint cover art
+      p.drawPixmap(pos, cover);
+      p.end();
+    }
+
+    //! manual graphics shadow (Qgraphics Effect cause refresh pb)
+    shadowed = shadowedPixmap(pixTemp);
+    CoverCache::instance()->insertShadowed(key, shadowed);
+
+    return shadowed;
+}
+
+static QPixmap shadowedArtistCovers(const QList<MEDIA::AlbumPtr>& albums, const QSize& size, int offset)
+{
+    QList<QPixmap> covers;
+    QString key = QString("artist:%1x%2:%3").arg(size.width()).arg(size.height()).arg(offset);
+
+    foreach(MEDIA::AlbumPtr album, albums) {
+      covers << CoverCache::instance()->coverAsync(album);
+      key += ":" + QString::number(covers.last().cacheKey());
+    }
+
+    QPixmap shadowed;
+    if(CoverCache::instance()->findShadowed(key, &shadowed))
+      return shadowed;
+
+    const QRect rect(QPoint(0, 0), size);
+
+    QPixmap basePixmap = QPixmap( size );
+    {
+      basePixmap.fill( Qt::transparent );
+      QPainter pt( &basePixmap );
+
+      //! affichage des covers
+      int i = 0;
+      foreach(QPixmap pix, covers)
+      {
+        pix = pix.scaled(QSize(85,85), Qt::KeepAspectRatio, Qt::SmoothTransformation);
+        qreal angle =  15*i++;
+
+        QTransform transform = QTransform().rotate(angle, Qt::ZAxis).translate(pix.width()/2,0);
+        pix = pix.transformed(transform, Qt::SmoothTransformation);
+
+        pt.drawPixmap(rect.adjusted((size.width() -pix.width())/2,
+                                    (size.height() -pix.height())/2 -offset,
+                                   -(size.width() -pix.width())/2,
+                                   -(size.height()-pix.height())/2 -offset)
+                                    , pix);
+      } // end foreach
+      pt.end();
+    }
+
+    //! manual graphics shadow (Qgraphics Effect cause refresh pb)
+    shadowed = shadowedPixmap(basePixmap);
+    CoverCache::instance()->insertShadowed(key, shadowed);
+
+    return shadowed;
+}
+
+
 
 /*
 ********************************************************************************
@@ -107,21 +187,8 @@ Q_UNUSED(option)
     opt.rect = boundingRect().toRect();
     UTIL::getStyle()->drawControl(QStyle::CE_ItemViewItem, &opt, painter, widget);
 
-    QPixmap pixTemp(QSize(150,150));
-    {
-      pixTemp.fill(Qt::transparent);
-      QPainter p;
-      p.begin(&pixTemp);
-
-      //! paint cover art
-      QPixmap pix = CoverCache::instance()->cover(media);
-      p.drawPixmap(20,2, pix);
-      p.end();
-    }
-    painter->drawPixmap(0, 0, pixTemp);
-
-    //! manual graphics shadow (Qgraphics Effect cause refresh pb)
-   drawShadow(painter,QPointF(0,0),pixTemp,boundingRect());
+    //! paint cover art with its shadow
+    painter->drawPixmap(0, 0, shadowedAlbumCover(media, QSize(150,150), QPoint(20,2)));
 
    //! paint album title
    painter->setPen(opt.palette.color ( QPalette::Normal, isSelected() ? QPalette::HighlightedText : QPalette::WindowText) );
@@ -243,22 +310,8 @@ Q_UNUSED(option)
     opt.rect = boundingRect().toRect().adjusted(0,0,0,0);
     UTIL::getStyle()->drawControl(QStyle::CE_ItemViewItem, &opt, painter, widget);
 
-    QPixmap pixTemp(QSize(150,150));
-    {
-      pixTemp.fill(Qt::transparent);
-      QPainter p;
-      p.begin(&pixTemp);
-
-      //! paint cover art
-      QPixmap pix = CoverCache::instance()->cover(media);
-      p.drawPixmap(20,2, pix);
-      p.end();
-    }
-
-    painter->drawPixmap(0, 0, pixTemp);
-
-    //! manual graphics shadow (Qgraphics Effect cause refresh pb)
-    drawShadow(painter,QPointF(0,0),pixTemp,boundingRect());
+    //! paint cover art with its shadow
+    painter->drawPixmap(0, 0, shadowedAlbumCover(media, QSize(150,150), QPoint(20,2)));
 
     //! paint album title
     painter->setPen(opt.palette.color ( QPalette::Normal, isSelected() ? QPalette::HighlightedText : QPalette::WindowText));
@@ -374,23 +427,8 @@ Q_UNUSED(option)
     opt.rect = boundingRect().toRect().adjusted(0,0,0,0);
     UTIL::getStyle()->drawControl(QStyle::CE_ItemViewItem, &opt, painter, widget);
 
-    QPixmap pixTemp(QSize(150,175));
-    {
-      pixTemp.fill(Qt::transparent);
-      QPainter p;
-      p.begin(&pixTemp);
-
-      //! paint cover art
-      QPixmap pix = CoverCache::instance()->cover(media);
-
-      p.drawPixmap(20,27, pix);
-      p.end();
-    }
-
-    painter->drawPixmap(0, 0, pixTemp);
-
-    //! manual graphics shadow (Qgraphics Effect cause refresh pb)
-    drawShadow(painter,QPointF(0,0),pixTemp,boundingRect());
+    //! paint cover art with its shadow
+    painter->drawPixmap(0, 0, shadowedAlbumCover(media, QSize(150,175), QPoint(20,27)));
 
     //! paint playcount
     QColor m_brush_color = QColor(0x4a82dd);
@@ -473,22 +511,8 @@ Q_UNUSED(option)
     opt.rect = boundingRect().toRect().adjusted(0,0,0,0);
     UTIL::getStyle()->drawControl(QStyle::CE_ItemViewItem, &opt, painter, widget);
 
-    QPixmap pixTemp(QSize(150,175));
-    {
-      pixTemp.fill(Qt::transparent);
-      QPainter p;
-      p.begin(&pixTemp);
-
-      //! paint cover art
-      QPixmap pix = CoverCache::instance()->cover(media);
-      p.drawPixmap(20,27,pix);
-      p.end();
-    }
-
-    painter->drawPixmap(0, 0, pixTemp);
-
-    //! manual graphics shadow (Qgraphics Effect cause refresh pb)
-    drawShadow(painter,QPointF(0,0),pixTemp,boundingRect());
+    //! paint cover art with its shadow
+    painter->drawPixmap(0, 0, shadowedAlbumCover(media, QSize(150,175), QPoint(20,27)));
 
     //! paint album rating
     const float rating_ = media->rating;
@@ -644,35 +668,8 @@ Q_UNUSED(option)
     opt.rect = boundingRect().toRect().adjusted(0,0,0,0);
     UTIL::getStyle()->drawControl(QStyle::CE_ItemViewItem, &opt, painter, widget);
 
-    QPixmap basePixmap = QPixmap( 140, 150 );
-    {
-      basePixmap.fill( Qt::transparent );
-      QPainter pt( &basePixmap );
-
-      //! affichage des covers
-      int i = 0;
-      foreach(MEDIA::AlbumPtr album, media->album_covers)
-      {
-        QPixmap pix = CoverCache::instance()->cover(album);
-
-        pix = pix.scaled(QSize(85,85), Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        qreal angle =  15*i++;
-
-        QTransform transform = QTransform().rotate(angle, Qt::ZAxis).translate(pix.width()/2,0);
-        pix = pix.transformed(transform, Qt::SmoothTransformation);
-
-        pt.drawPixmap(boundingRect().toRect().adjusted((140 -pix.width())/2,
-                                                       (150 -pix.height())/2 -15,
-                                                      -(140 -pix.width())/2,
-                                                      -(150-pix.height())/2 -15)
-                                                       , pix);
-      } // end foreach
-      pt.end();
-    }
-    painter->drawPixmap(boundingRect().toRect(), basePixmap);
-
-    //! manual graphics shadow (Qgraphics Effect cause refresh pb)
-    drawShadow(painter,QPointF(0,0),basePixmap,boundingRect());
+    //! paint album covers with their shadow
+    painter->drawPixmap(0, 0, shadowedArtistCovers(media->album_covers, QSize(140,150), 15));
 
     //! affichage nom de l'artist
     painter->setPen(opt.palette.color ( QPalette::Normal, isSelected() ? QPalette::HighlightedText : QPalette::WindowText));
@@ -809,35 +806,8 @@ Q_UNUSED(option)
     opt.rect = boundingRect().toRect().adjusted(0,0,0,0);
     UTIL::getStyle()->drawControl(QStyle::CE_ItemViewItem, &opt, painter, widget);
 
-    QPixmap basePixmap = QPixmap( 150, 175 );
-    {
-      basePixmap.fill( Qt::transparent );
-      QPainter pt( &basePixmap );
-
-      //! affichage des covers
-      int i =0;
-      foreach(MEDIA::AlbumPtr album, media->album_covers)
-      {
-        QPixmap pix = CoverCache::instance()->cover(album);
-
-        pix = pix.scaled(QSize(85,85), Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        qreal angle =  15*i++;
-
-        QTransform transform = QTransform().rotate(angle, Qt::ZAxis).translate(pix.width()/2,0);
-        pix = pix.transformed(transform, Qt::SmoothTransformation);
-
-        pt.drawPixmap(boundingRect().toRect().adjusted((150 -pix.width())/2,
-                                                       (175 -pix.height())/2 -4,
-                                                      -(150 -pix.width())/2,
-                                                      -(175-pix.height())/2 -4)
-                                                       , pix);
-      } // end foreach
-      pt.end();
-    }
-    painter->drawPixmap(boundingRect().toRect(), basePixmap);
-
-    //! manual graphics shadow (Qgraphics Effect cause refresh pb)
-    drawShadow(painter,QPointF(0,0),basePixmap,boundingRect());
+    //! paint album covers with their shadow
+    painter->drawPixmap(0, 0, shadowedArtistCovers(media->album_covers, QSize(150,175), 4));
 
     //! paint playcount
     QColor m_brush_color = QColor(0x4a82dd);
@@ -913,35 +883,8 @@ Q_UNUSED(option)
     opt.rect = boundingRect().toRect().adjusted(0,0,0,0);
     UTIL::getStyle()->drawControl(QStyle::CE_ItemViewItem, &opt, painter, widget);
 
-    QPixmap basePixmap = QPixmap( 150, 175 );
-    {
-      basePixmap.fill( Qt::transparent );
-      QPainter pt( &basePixmap );
-
-      //! affichage des covers
-      int i=0;
-      foreach(MEDIA::AlbumPtr album, media->album_covers)
-      {
-        QPixmap pix = CoverCache::instance()->cover(album);
-
-        pix = pix.scaled(QSize(85,85), Qt::KeepAspectRatio, Qt::SmoothTransformation);
-        qreal angle =  15*i++;
-
-        QTransform transform = QTransform().rotate(angle, Qt::ZAxis).translate(pix.width()/2,0);
-        pix = pix.transformed(transform, Qt::SmoothTransformation);
-
-        pt.drawPixmap(boundingRect().toRect().adjusted((150 -pix.width())/2,
-                                                       (175 -pix.height())/2 -4,
-                                                      -(150 -pix.width())/2,
-                                                      -(175-pix.height())/2 -4)
-                                                       , pix);
-      } // end foreach
-      pt.end();
-    }
-    painter->drawPixmap(boundingRect().toRect(), basePixmap);
-
-    //! manual graphics shadow (Qgraphics Effect cause refresh pb)
-    drawShadow(painter,QPointF(0,0),basePixmap,boundingRect());
+    //! paint album covers with their shadow
+    painter->drawPixmap(0, 0, shadowedArtistCovers(media->album_covers, QSize(150,175), 4));
 
     //! paint artist rating
     const float rating_ = media->rating;
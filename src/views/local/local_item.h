@@ -236,6 +236,7 @@ class TrackGraphicItem : public QGraphicsItem
     int                      _width;
     MEDIA::TrackPtr          media;
     int type() const { return GraphicsItem::TrackType; }
+    void setWidth(int w) {prepareGeometryChange(); _width = w;}
 
     void startDrag(QWidget*);
 
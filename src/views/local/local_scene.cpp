@@ -29,6 +29,7 @@
 
 #include "core/mediaitem/mediaitem.h"
 #include "covers/covercache.h"
+#include "covers/coverstore.h"
 
 #include "core/database/database.h"
 #include "core/database/databasemanager.h"
@@ -47,6 +48,13 @@
 
 #include <QSqlQuery>
 #include <QtGui>
+#include <QtConcurrentRun>
+
+/* extra area above and below the viewport where layout items are kept */
+static const int VIEWPORT_MARGIN = 340;
+
+/* area ahead of the scroll direction where album covers are prefetched */
+static const int PREFETCH_DISTANCE = 1020;
 
 /*
 ********************************************************************************
@@ -73,12 +81,24 @@ void LocalScene::initScene()
     m_infosize          = 0;
     m_mouseGrabbedItem  = 0;
     item_count          = 0;
+    m_layout_request    = 0;
+    m_layout_pending    = false;
+    m_last_top          = 0;
     
     //! graphic item context menu
     m_graphic_item_menu = new GraphicsItemMenu(0);
     m_graphic_item_menu->setBrowserView(this->parentView());
+
+    //! layout items follow the viewport
+    QGraphicsView* view = qobject_cast<QGraphicsView*>(parentView());
+    connect(view->verticalScrollBar(), SIGNAL(valueChanged(int)), this, SLOT(slot_update_visible_items()));
     QObject::connect(m_graphic_item_menu, SIGNAL(menu_action_triggered(ENUM_ACTION_ITEM_MENU)), this, SLOT(slot_contextmenu_triggered(ENUM_ACTION_ITEM_MENU)), Qt::DirectConnection);
 
+    connect(&m_layout_watcher, SIGNAL(finished()), this, SLOT(slot_layout_ready()));
+
+    //! covers are decoded in background
+    connect(CoverCache::instance(), SIGNAL(coversLoaded()), this, SLOT(update()));
+
     /*  scene actions */
     m_actions.insert("album_grid", new QAction(QIcon(),QString(tr("view grid")),this));
     m_actions.insert("playlist_tracks", new QAction(QIcon(),QString(tr("view by tracks")),this));
@@ -167,7 +187,30 @@ void LocalScene::setFilter(const QString& filter)
 void LocalScene::resizeScene()
 {
     //Debug::debug() << "   [LocalScene] resizeScene";   
-    int new_item_count = (parentView()->width()/160 > 2) ? parentView()->width()/160 : 2;
+    int new_item_count = LocalSceneLayout::columnCount(parentView()->width());
+
+    /* collection views : keep items and move them (pending layout is
+       adjusted when applied) */
+    if(m_layout_pending || !m_layout.isEmpty())
+    {
+      if(item_count != new_item_count) {
+        item_count = new_item_count;
+
+        if(!m_layout_pending)
+          relayoutScene();
+      }
+
+      //! track items follow the view width
+      QHash<int, QGraphicsItem*>::const_iterator it = m_layout_items.constBegin();
+      for( ; it != m_layout_items.constEnd(); ++it)
+        if(m_layout.at(it.key()).type == LocalSceneLayout::ENTRY_TRACK)
+          static_cast<TrackGraphicItem*>(it.value())->setWidth(parentView()->width()-155-20);
+
+      updateSceneRect();
+      slot_update_visible_items();
+      update();
+      return;
+    }
 
     if(item_count != new_item_count)  
     {
@@ -197,11 +240,24 @@ void LocalScene::populateScene()
 {
     Debug::debug() << "   [LocalScene] PopulateScene";
 
+    const bool isDbBuilding = m_localTrackModel->isEmpty() && ThreadManager::instance()->isDbRunning();
+
+    /* collection views layout is computed in a worker thread */
+    if(!isDbBuilding && LocalSceneLayout::isLayoutView(mode()))
+    {
+      populateLayoutScene();
+      return;
+    }
+
+    /* drop pending layout computation */
+    m_layout_request++;
+    m_layout_pending = false;
+
     //! clear scene and delete all items
-    clear();
+    clearScene();
     
     /* si model est vide et database est en cours de construction */
-    if(m_localTrackModel->isEmpty() && ThreadManager::instance()->isDbRunning())
+    if(isDbBuilding)
     {
       populateLocalSceneBuilding();
     }    
@@ -209,11 +265,6 @@ void LocalScene::populateScene()
     {
       switch(mode())
       {
-        case VIEW::ViewAlbum          : populateAlbumScene();    break;
-        case VIEW::ViewArtist         : populateArtistScene();   break;
-        case VIEW::ViewTrack          : populateTrackScene();    break;
-        case VIEW::ViewGenre          : populateGenreScene();    break;
-        case VIEW::ViewYear           : populateYearScene();     break;
         case VIEW::ViewFavorite       : populateFavoriteScene(); break;
         case VIEW::ViewPlaylist       : populatePlaylistScene(); break;
         case VIEW::ViewSmartPlaylist  : populatePlaylistSmartScene(); break;
@@ -223,8 +274,43 @@ void LocalScene::populateScene()
       }
     }
 
+    updateSceneRect();
+}
+
+/*******************************************************************************
+    clearScene
+*******************************************************************************/
+void LocalScene::clearScene()
+{
+    //! delete all items
+    clear();
+
+    m_layout = LocalSceneLayout();
+    m_layout_items.clear();
+    m_layout_pool.clear();
+}
+
+/*******************************************************************************
+    updateSceneRect
+*******************************************************************************/
+void LocalScene::updateSceneRect()
+{
     //! we need to ajust SceneRect
-    setSceneRect ( itemsBoundingRect().adjusted(0, -10, 0, 40) );
+    QRectF rect;
+    if(m_layout.isEmpty())
+    {
+      rect = itemsBoundingRect();
+    }
+    else
+    {
+      /* layout items are not all in scene, pooled ones are hidden */
+      foreach(QGraphicsItem* item, m_layout_items)
+        rect |= item->sceneBoundingRect();
+
+      rect |= QRectF(0, 0, 1, m_layout.height());
+    }
+
+    setSceneRect ( rect.adjusted(0, -10, 0, 40) );
 }
 
 
@@ -244,476 +330,292 @@ void LocalScene::populateLocalSceneBuilding()
 
 
 
-void LocalScene::populateAlbumScene()
+/*******************************************************************************
+    populateLayoutScene
+      -> filtering and positions are computed in a worker thread, current
+         items stay in scene until the new layout is applied
+*******************************************************************************/
+void LocalScene::populateLayoutScene()
 {
-    if( VIEW::ViewAlbum_Type(SETTINGS()->_album_view_type) == VIEW::album_grid)
-      populateAlbumGridScene();
-    else
-      populateAlbumExtendedScene();
-}
+    item_count = LocalSceneLayout::columnCount(parentView()->width());
 
-void LocalScene::populatePlaylistScene()
-{
-    if( VIEW::ViewPlaylist_Type(SETTINGS()->_playlist_view_type) == VIEW::playlist_overview)
-      populatePlaylistOverviewScene();
-    else
-      populatePlaylistByTrackScene();
+    LocalSceneLayout::Request request =
+      LocalSceneLayout::snapshot(mode(), SETTINGS()->_album_view_type, item_count);
+    request.id = ++m_layout_request;
+
+    m_layout_pending = true;
+    m_layout_watcher.setFuture( QtConcurrent::run(&LocalSceneLayout::compute, request) );
 }
 
-void LocalScene::populateAlbumExtendedScene()
+/*******************************************************************************
+    slot_layout_ready
+*******************************************************************************/
+void LocalScene::slot_layout_ready()
 {
-    int albumRow  = 0;
-    int artistRow = 0;
-    int Column    = 0;
-    m_infosize    = 0;
-
-    item_count = (parentView()->width()/160 > 2) ? parentView()->width()/160 : 2;
+    const LocalSceneLayout layout = m_layout_watcher.result();
 
-    //! header item
-    HeaderItem* header = new HeaderItem(qobject_cast<QGraphicsView*> (parentView())->viewport());
-    header->setText( tr("Albums") );
-    header->setPos(0, 5);
-    addItem(header);    
-    
-    artistRow++;
+    /* result of an obsolete request */
+    if(layout.requestId() != m_layout_request)
+      return;
 
-    //! artist loop
-    for ( int i = 0; i < m_localTrackModel->rootItem()->childCount(); i++ )
-    {
-      MEDIA::ArtistPtr artist = MEDIA::ArtistPtr::staticCast( m_localTrackModel->rootItem()->child(i) );
+    applyLayout(layout);
 
-      if(!m_localTrackModel->isArtistFiltered(artist) ) continue;
+    m_layout_pending = false;
+    emit layoutApplied();
+}
 
-      CategorieGraphicItem *category = new CategorieGraphicItem(qobject_cast<QGraphicsView*> (parentView())->viewport());
-      category->m_name = artist->name;
-      category->setPos( 0 ,10 + artistRow*50 + albumRow*170);
+/*******************************************************************************
+    applyLayout
+      -> gui thread, positions are computed for all entries, graphic items
+         are only created for entries that intersect the viewport (plus a
+         margin)
+*******************************************************************************/
+void LocalScene::applyLayout(const LocalSceneLayout& layout)
+{
+    clearScene();
 
-      addItem(category);
+    m_layout   = layout;
+    m_infosize = m_layout.infoSize();
 
-      Column = 0;
-      artistRow++;
+    /* view has been resized while computing */
+    m_layout.relayout(item_count);
 
-      //! album loop
-      for (int j = 0; j < artist->childCount(); j++)
-      {
-        MEDIA::AlbumPtr album = MEDIA::AlbumPtr::staticCast( artist->child(j) );
-        if(!m_localTrackModel->isAlbumFiltered(album) ) continue;
+    //! header, categories and info are few, keep them always in scene
+    for(int i=0; i < m_layout.count(); i++)
+    {
+      if(LocalSceneLayout::isVirtual(m_layout.at(i).type)) continue;
 
-        m_infosize++;
+      QGraphicsItem* item = createLayoutItem(m_layout.at(i).type);
+      bindLayoutItem(item, m_layout.at(i));
+      addItem(item);
+      m_layout_items.insert(i, item);
+    }
 
-        AlbumGraphicItem_v2 *album_item = new AlbumGraphicItem_v2();
-        album_item->media = album;
-        album_item->setPos(4+160*Column, artistRow*50 + albumRow*170);
-        addItem(album_item);
+    updateSceneRect();
 
+    slot_update_visible_items();
+}
 
-        if(Column < (item_count-1)) {
-          Column++;
-        }
-        else {
-          Column = 0;
-          albumRow++;
-        }
-      }
-      if(Column>0) albumRow++;
-    }
+/*******************************************************************************
+    relayoutScene
+      -> live items are moved to their new position, no item is deleted
+*******************************************************************************/
+void LocalScene::relayoutScene()
+{
+    m_layout.relayout(item_count);
 
-    if(m_infosize==0) {
-      InfoGraphicItem *info = new InfoGraphicItem(qobject_cast<QGraphicsView*> (parentView())->viewport());
-      info->_text = tr("No entry found");
-      info->setPos( 0 , 10 + artistRow*50 + albumRow*20);
-      addItem(info);
-    }
+    QHash<int, QGraphicsItem*>::const_iterator it = m_layout_items.constBegin();
+    for( ; it != m_layout_items.constEnd(); ++it)
+      it.value()->setPos( m_layout.at(it.key()).pos );
 }
 
-void LocalScene::populateAlbumGridScene()
+/*******************************************************************************
+    slot_update_visible_items
+*******************************************************************************/
+void LocalScene::slot_update_visible_items()
 {
-    int albumRow      = 0;
-    int Column        = 0;
-    m_infosize        = 0;
-    int categorieRow  = 0;
-    item_count = (parentView()->width()/160 > 2) ? parentView()->width()/160 : 2;
+    if(m_layout.isEmpty()) return;
 
-    //! header item
-    HeaderItem* header = new HeaderItem(qobject_cast<QGraphicsView*> (parentView())->viewport());
-    header->setText( tr("Albums") );
-    header->setPos(0, 5);
-    addItem(header);    
-    
-    categorieRow++;
+    QGraphicsView* view = qobject_cast<QGraphicsView*>(parentView());
 
-    CategorieGraphicItem *cat = new CategorieGraphicItem(qobject_cast<QGraphicsView*> (parentView())->viewport());
-    cat->m_name = tr("All Albums");
-    cat->setPos( 0 ,10 + categorieRow*50);
-    categorieRow++;
-    addItem(cat);
+    /* scene is not yet set on view when populated on view switch */
+    QRectF visible = (view->scene() == this) ?
+      view->mapToScene(view->viewport()->rect()).boundingRect() :
+      QRectF(0, 0, view->viewport()->width(), view->viewport()->height());
 
+    const int top    = int(visible.top()) - VIEWPORT_MARGIN;
+    const int bottom = int(visible.bottom()) + VIEWPORT_MARGIN;
 
-    //! artist loop
-    for ( int i = 0; i < m_localTrackModel->rootItem()->childCount(); i++ )
+    //! recycle out of range items (keep selected items for selection actions)
+    QHash<int, QGraphicsItem*>::iterator it = m_layout_items.begin();
+    while(it != m_layout_items.end())
     {
-      MEDIA::ArtistPtr artist = MEDIA::ArtistPtr::staticCast(m_localTrackModel->rootItem()->child(i));
-
-      if(!m_localTrackModel->isArtistFiltered(artist) ) continue;
-
-      //! album loop
-      for (int j = 0; j < artist->childCount(); j++)
-      {
-        MEDIA::AlbumPtr album = MEDIA::AlbumPtr::staticCast( artist->child(j) );
-        if(!m_localTrackModel->isAlbumFiltered(album) ) continue;
-
-        m_infosize++;
-
-        AlbumGraphicItem *album_item = new AlbumGraphicItem();
-        album_item->media = album;
-        album_item->setPos(4+160*Column, 10 + albumRow*170 + categorieRow*50);
-        addItem(album_item);
-
-        if(Column < (item_count-1)) {
-          Column++;
-        }
-        else {
-          Column = 0;
-          albumRow++;
-        }
+      if(!LocalSceneLayout::isVirtual(m_layout.at(it.key()).type) ||
+         isLayoutEntryInRange(it.key(), top, bottom) || it.value()->isSelected()) {
+        ++it;
+        continue;
       }
-    }
 
-    if(m_infosize==0) {
-      InfoGraphicItem *info = new InfoGraphicItem(qobject_cast<QGraphicsView*> (parentView())->viewport());
-      info->_text = tr("No entry found");
-      info->setPos( 0 ,10 + categorieRow*50);
-      addItem(info);
+      it.value()->hide();
+      m_layout_pool[m_layout.at(it.key()).type].append(it.value());
+      it = m_layout_items.erase(it);
     }
-}
-
-
 
-void LocalScene::populateArtistScene()
-{
-    int artistRow    = 0;
-    int categorieRow = 0;
-    int Column       = 0;
-    m_infosize       = 0;
-    int idx          = 0;
-    item_count = (parentView()->width()/160 > 2) ? parentView()->width()/160 : 2;
-
-    //! header item
-    HeaderItem* header = new HeaderItem(qobject_cast<QGraphicsView*> (parentView())->viewport());
-    header->setText( tr("Artists") );
-    header->setPos(0, 5);
-    addItem(header);    
-
-    categorieRow++;
-        
-    //! artist loop
-    QChar start_char;
-    for (int i=0 ; i < m_localTrackModel->rootItem()->childCount(); i++ )
+    //! create or reuse items for entries in range
+    for(int i = m_layout.firstIndexFrom(top); i < m_layout.count(); i++)
     {
-        MEDIA::ArtistPtr artist = MEDIA::ArtistPtr::staticCast(m_localTrackModel->rootItem()->child(i));
-        if(! m_localTrackModel->isArtistFiltered(artist) ) continue;
-
-        QChar current_char = artist->name.at(0).toLower();
-
-        if(start_char !=  current_char) {
-          //! new category
-          start_char = current_char;
-          if(idx>0) artistRow++;
-
-          CategorieGraphicItem *category = new CategorieGraphicItem(qobject_cast<QGraphicsView*> (parentView())->viewport());
-          category->m_name = QString(start_char);
-          category->setPos( 0 , 10 + categorieRow*50 + artistRow*165);
-          addItem(category);
-
-          Column = 0;
-          categorieRow++;
-        }
-
-        //! add new artist item
-        m_infosize++;
-        idx++;
+      if(m_layout.at(i).pos.y() > bottom) break;
 
-        //! New Artist Item
-        ArtistGraphicItem *artist_item = new ArtistGraphicItem();
-        artist_item->media = artist;
-        artist_item->setPos( 4 + 160*Column , categorieRow*50 + artistRow*165);
-        addItem(artist_item);
+      if(!LocalSceneLayout::isVirtual(m_layout.at(i).type)) continue;
+      if(m_layout_items.contains(i)) continue;
+      if(!isLayoutEntryInRange(i, top, bottom)) continue;
 
-        //! ALBUM COVER LOOP
-        artist->album_covers.clear();
-        for(int j = artist->childCount()-1 ; j >= 0; j--) {
-          MEDIA::AlbumPtr album = MEDIA::AlbumPtr::staticCast(artist->child(j));
-          if(!m_localTrackModel->isAlbumFiltered(album) ) continue;
+      m_layout_items.insert(i, takeLayoutItem(i));
+    }
 
-          artist->album_covers.prepend(album);
+    //! prefetch covers in scroll direction
+    const bool isScrollingUp = top < m_last_top;
+    m_last_top = top;
 
-          //!WARNING limite de l'affichage à 6 cover max
-          if(artist->album_covers.size() >=6) break;
-        }
+    const int from = isScrollingUp ? top - PREFETCH_DISTANCE : bottom;
+    const int to   = isScrollingUp ? top : bottom + PREFETCH_DISTANCE;
 
-        if(Column < (item_count-1)) {
-          Column++;
-        }
-        else {
-          Column = 0;
-          artistRow++;
-          idx    = 0;
-        }
-
-    } // end for artist loop
+    for(int i = m_layout.firstIndexFrom(from); i < m_layout.count(); i++)
+    {
+      const LocalSceneLayout::Entry& entry = m_layout.at(i);
+      if(entry.pos.y() > to) break;
 
-    if(m_infosize==0) {
-      InfoGraphicItem *info = new InfoGraphicItem(qobject_cast<QGraphicsView*> (parentView())->viewport());
-      info->_text = tr("No entry found");
-      info->setPos( 0 , 10 + categorieRow*50);
-      addItem(info);
+      switch(entry.type)
+      {
+        case LocalSceneLayout::ENTRY_ALBUM          :
+        case LocalSceneLayout::ENTRY_ALBUM_EXTENDED :
+        case LocalSceneLayout::ENTRY_ALBUM_TRACKS   :
+        case LocalSceneLayout::ENTRY_ALBUM_GENRE    :
+          CoverCache::instance()->prefetch( MEDIA::AlbumPtr::staticCast(entry.media) );
+          break;
+        default: break;
+      }
     }
 }
 
-
-
-void LocalScene::populateTrackScene()
+bool LocalScene::isLayoutEntryInRange(int idx, int top, int bottom) const
 {
-    int artistRow     = 0;
-    int albumRow      = 0;
-    int trackRow      = 0;
-    int trackPerAlbum = 0;
-    int offset        = 0;
-    m_infosize        = 0;
+    const LocalSceneLayout::Entry& entry = m_layout.at(idx);
 
-    //! header item
-    HeaderItem* header = new HeaderItem(qobject_cast<QGraphicsView*> (parentView())->viewport());
-    header->setText( tr("Tracks") );
-    header->setPos(0, 5);
-    addItem(header);
-    
-    artistRow++;
+    return entry.pos.y() <= bottom &&
+           entry.pos.y() + LocalSceneLayout::entryHeight(entry.type) >= top;
+}
 
-    //! artist loop
-    for ( int i = 0; i < m_localTrackModel->rootItem()->childCount(); i++ )
-    {
-      MEDIA::ArtistPtr artist = MEDIA::ArtistPtr::staticCast(m_localTrackModel->rootItem()->child(i));
+/*******************************************************************************
+    layout items
+*******************************************************************************/
+QGraphicsItem* LocalScene::takeLayoutItem(int idx)
+{
+    const LocalSceneLayout::Entry& entry = m_layout.at(idx);
 
-      if(!m_localTrackModel->isArtistFiltered(artist) ) continue;
+    QGraphicsItem* item;
+    QList<QGraphicsItem*>& pool = m_layout_pool[entry.type];
+    if(!pool.isEmpty()) {
+      item = pool.takeLast();
+      item->show();
+    }
+    else {
+      item = createLayoutItem(entry.type);
+      addItem(item);
+    }
 
-      CategorieGraphicItem *category = new CategorieGraphicItem(qobject_cast<QGraphicsView*> (parentView())->viewport());
-      category->m_name = artist->name;
-      category->setPos( 0 ,artistRow*50 + trackRow*20 + albumRow*30 + offset );
-      addItem(category);
+    bindLayoutItem(item, entry);
+    return item;
+}
 
-      artistRow++;
+QGraphicsItem* LocalScene::createLayoutItem(LocalSceneLayout::EntryType type)
+{
+    QWidget* viewport = qobject_cast<QGraphicsView*> (parentView())->viewport();
 
-      //! album loop
-      for (int j = 0; j < artist->childCount(); j++)
+    switch(type)
+    {
+      case LocalSceneLayout::ENTRY_HEADER         : return new HeaderItem(viewport);
+      case LocalSceneLayout::ENTRY_CATEGORY       : return new CategorieGraphicItem(viewport);
+      case LocalSceneLayout::ENTRY_INFO           : return new InfoGraphicItem(viewport);
+      case LocalSceneLayout::ENTRY_ALBUM          : return new AlbumGraphicItem();
+      case LocalSceneLayout::ENTRY_ALBUM_EXTENDED : return new AlbumGraphicItem_v2();
+      case LocalSceneLayout::ENTRY_ALBUM_GENRE    : return new AlbumGenreGraphicItem();
+      case LocalSceneLayout::ENTRY_ARTIST         : return new ArtistGraphicItem();
+      case LocalSceneLayout::ENTRY_TRACK          : return new TrackGraphicItem_v2();
+      case LocalSceneLayout::ENTRY_ALBUM_TRACKS   :
       {
-        MEDIA::AlbumPtr album = MEDIA::AlbumPtr::staticCast(artist->child(j));
-
-        if(!m_localTrackModel->isAlbumFiltered(album)) continue;
-
         AlbumGraphicItem_v2 *album_item = new AlbumGraphicItem_v2();
         album_item->setFlag(QGraphicsItem::ItemIsSelectable, false);
-        album_item->media = album;
-        album_item->setPos(4, artistRow*50 + trackRow*20 + albumRow*30 + offset );
-        addItem(album_item);
-
-        trackPerAlbum = 0;
-
-        //! track loop
-        int disc_number = 0;
-        bool m_isGrouping = DatabaseManager::instance()->DB_PARAM().groupAlbums;
-        for (int k = 0; k < album->childCount(); k++)
-        {
-          MEDIA::TrackPtr track = MEDIA::TrackPtr::staticCast(album->child(k));
-          if(!m_localTrackModel->isTrackFiltered(track)) continue;
-
-          if(m_isGrouping && album->isMultiset() && (disc_number != track->disc_number)) 
-          {
-            disc_number = track->disc_number;
-            
-            QGraphicsTextItem* text_item = new QGraphicsTextItem(QString(tr("disc %1")).arg(disc_number));
-            text_item->setDefaultTextColor(QApplication::palette().color(QPalette::Disabled, QPalette::WindowText));
-            text_item->setFont( QFont("Arial", 10, QFont::Bold) );
-
-            text_item->setPos(160, artistRow*50 + trackRow*20 + albumRow*30 + offset);
-            addItem(text_item);
-
-            trackRow++;
-          }
-
-          TrackGraphicItem_v2 *track_item = new TrackGraphicItem_v2();
-          track_item->media = track;
-          track_item->setPos(155, artistRow*50 + trackRow*20 + albumRow*30 + offset);
-
-          //PATCH (-20 => fix alignement of the scene)
-          track_item->_width = parentView()->width()-155-20;
-
-          addItem(track_item);
-
-          trackRow++;
-          trackPerAlbum++;
-          m_infosize++;
-        }
-        albumRow++;
-
-        if( trackPerAlbum < 8 ) offset = offset + (8 - trackPerAlbum)*20;
+        return album_item;
+      }
+      case LocalSceneLayout::ENTRY_DISC           :
+      {
+        QGraphicsTextItem* text_item = new QGraphicsTextItem();
+        text_item->setDefaultTextColor(QApplication::palette().color(QPalette::Disabled, QPalette::WindowText));
+        text_item->setFont( QFont("Arial", 10, QFont::Bold) );
+        return text_item;
       }
     }
 
-    if(m_infosize==0) {
-      InfoGraphicItem *info = new InfoGraphicItem(qobject_cast<QGraphicsView*> (parentView())->viewport());
-      info->_text = tr("No entry found");
-      info->setPos( 0 , 10 + artistRow*50);
-      addItem(info);
-    }
+    return 0;
 }
 
-
-
-void LocalScene::populateGenreScene()
+void LocalScene::bindLayoutItem(QGraphicsItem* item, const LocalSceneLayout::Entry& entry)
 {
-    int categorieRow = 0;
-    int albumRow     = 0;
-    int Column       = 0;
-    m_infosize       = 0;
-    item_count = (parentView()->width()/160 > 2) ? parentView()->width()/160 : 2;
-
-    //! header item
-    HeaderItem* header = new HeaderItem(qobject_cast<QGraphicsView*> (parentView())->viewport());
-    header->setText( tr("Albums by genre") );
-    header->setPos(0, 5);
-    addItem(header);    
-
-    categorieRow++;
-
-    QString s_genre     = "";
-    MEDIA::MediaPtr     media;
-    
-
-    foreach (MEDIA::TrackPtr track, m_localTrackModel->trackByGenre)
+    switch(entry.type)
     {
-      //! add filtre
-      if(s_genre == track->genre && media == track->parent()) continue;
-      if(!m_localTrackModel->isTrackFiltered(track)) continue;
+      case LocalSceneLayout::ENTRY_HEADER   :
+        static_cast<HeaderItem*>(item)->setText( entry.text );
+        break;
+      case LocalSceneLayout::ENTRY_CATEGORY :
+        static_cast<CategorieGraphicItem*>(item)->m_name = entry.text;
+        break;
+      case LocalSceneLayout::ENTRY_INFO     :
+        static_cast<InfoGraphicItem*>(item)->_text = entry.text;
+        break;
+      case LocalSceneLayout::ENTRY_DISC     :
+        static_cast<QGraphicsTextItem*>(item)->setPlainText( entry.text );
+        break;
 
-      if(media != track->parent())
+      case LocalSceneLayout::ENTRY_ALBUM          :
+      case LocalSceneLayout::ENTRY_ALBUM_EXTENDED :
+      case LocalSceneLayout::ENTRY_ALBUM_TRACKS   :
+      case LocalSceneLayout::ENTRY_ALBUM_GENRE    :
       {
-        /* ------- New Genre ------- */
-        if(s_genre != track->genre)
-        {
-          s_genre = track->genre;
-
-          if(Column>0) albumRow++;
-
-          CategorieGraphicItem *category = new CategorieGraphicItem(qobject_cast<QGraphicsView*> (parentView())->viewport());
-          category->m_name = s_genre;
-          category->setPos( 0 , 10 + categorieRow*50 + albumRow*170);
-          addItem(category);
-
-          m_infosize++; // on compte les categorie = genre
-          categorieRow++;
-          Column     = 0;
-        }
+        AlbumGraphicItem *album_item = static_cast<AlbumGraphicItem*>(item);
+        album_item->media      = MEDIA::AlbumPtr::staticCast(entry.media);
+        album_item->opt.state &= ~QStyle::State_MouseOver;
 
-        /* ------- New Album ------- */
-        media = track->parent();
-
-        AlbumGenreGraphicItem *album_item = new AlbumGenreGraphicItem();
-        album_item->media    = MEDIA::AlbumPtr::staticCast(track->parent());
-        album_item->_genre   = s_genre;
-        album_item->setPos(4+160*Column, categorieRow*50 + albumRow*170);
-        addItem(album_item);
-
-        if(Column < (item_count-1)) {
-          Column++;
-        }
-        else {
-          Column = 0;
-          albumRow++;
-        }
+        if(entry.type == LocalSceneLayout::ENTRY_ALBUM_GENRE)
+          static_cast<AlbumGenreGraphicItem*>(item)->_genre = entry.text;
+        break;
       }
-    } // fin foreach track
-
-    if(m_infosize==0) {
-      InfoGraphicItem *info = new InfoGraphicItem(qobject_cast<QGraphicsView*> (parentView())->viewport());
-      info->_text = tr("No entry found");
-      info->setPos( 0 , 10 + categorieRow*50);
-      addItem(info);
-    }
-}
-
-
-void LocalScene::populateYearScene()
-{
-    int categorieRow = 0;
-    int albumRow     = 0;
-    int Column       = 0;
-    m_infosize       = 0;
-    item_count = (parentView()->width()/160 > 2) ? parentView()->width()/160 : 2;
-
-    //! header item
-    HeaderItem* header = new HeaderItem(qobject_cast<QGraphicsView*> (parentView())->viewport());
-    header->setText( tr("Albums by year") );
-    header->setPos(0, 5);
-    addItem(header);    
-
-    categorieRow++;
-
-    int year         = -1;
-    int idx          = 0;
-
-    QList<MEDIA::AlbumPtr> list_album_by_year = m_localTrackModel->albumItemList;
-
-    //! Sort Media Album Item list By Year
-    qSort(list_album_by_year.begin(), list_album_by_year.end(),MEDIA::compareAlbumItemYear);
-
-    foreach (MEDIA::AlbumPtr album, list_album_by_year)
-    {
-      //! add filtre
-      if(!m_localTrackModel->isAlbumFiltered(album)) continue;
+      case LocalSceneLayout::ENTRY_ARTIST :
+      {
+        MEDIA::ArtistPtr artist = MEDIA::ArtistPtr::staticCast(entry.media);
 
-      if(year != album->year) {
-        //! new year
-        year = album->year;
+        //! ALBUM COVER LOOP
+        artist->album_covers.clear();
+        for(int j = artist->childCount()-1 ; j >= 0; j--) {
+          MEDIA::AlbumPtr album = MEDIA::AlbumPtr::staticCast(artist->child(j));
+          if(!m_localTrackModel->isAlbumFiltered(album) ) continue;
 
-        if(idx>0) albumRow++;
+          artist->album_covers.prepend(album);
 
-        CategorieGraphicItem *category = new CategorieGraphicItem(qobject_cast<QGraphicsView*> (parentView())->viewport());
-        category->m_name = QString::number(year);
-        category->setPos( 0 , 10 + categorieRow*50 + albumRow*170);
-        addItem(category);
+          //!WARNING limite de l'affichage à 6 cover max
+          if(artist->album_covers.size() >=6) break;
+        }
 
-        m_infosize++; // on compte les categorie = genre
-        categorieRow++;
-        Column     = 0;
-        idx        = 0;
+        ArtistGraphicItem *artist_item = static_cast<ArtistGraphicItem*>(item);
+        artist_item->media      = artist;
+        artist_item->opt.state &= ~QStyle::State_MouseOver;
+        break;
       }
+      case LocalSceneLayout::ENTRY_TRACK :
+      {
+        TrackGraphicItem_v2 *track_item = static_cast<TrackGraphicItem_v2*>(item);
+        track_item->media      = MEDIA::TrackPtr::staticCast(entry.media);
+        track_item->opt.state &= ~QStyle::State_MouseOver;
+        track_item->setHoverRating(-1.0);
 
-      AlbumGraphicItem *album_item = new AlbumGraphicItem();
-      album_item->media  = album;
-      album_item->setPos(4+160*Column, categorieRow*50 + albumRow*170);
-      addItem(album_item);
-
-      if(Column < (item_count-1)) {
-        Column++;
-        idx++;
-      }
-      else {
-        Column = 0;
-        albumRow++;
-        idx=0;
+        //PATCH (-20 => fix alignement of the scene)
+        track_item->setWidth(parentView()->width()-155-20);
+        break;
       }
-    } // fin foreach track
-
-
-    if(m_infosize==0) {
-      InfoGraphicItem *info = new InfoGraphicItem(qobject_cast<QGraphicsView*> (parentView())->viewport());
-      info->_text = tr("No entry found");
-      info->setPos( 0 , 10 + categorieRow*50);
-      addItem(info);
     }
+
+    item->setPos(entry.pos);
+    item->update();
 }
 
 
+void LocalScene::populatePlaylistScene()
+{
+    if( VIEW::ViewPlaylist_Type(SETTINGS()->_playlist_view_type) == VIEW::playlist_overview)
+      populatePlaylistOverviewScene();
+    else
+      populatePlaylistByTrackScene();
+}
 
 void LocalScene::populateFavoriteScene()
 {
@@ -1387,46 +1289,26 @@ QPoint LocalScene::get_item_position(MEDIA::MediaPtr media)
 {
     Debug::debug() << "   [LocalScene] get_item_position";
     QPoint point = QPoint(0,0);
+    int idx = -1;
+
     if(media->type() == TYPE_ARTIST && mode() == VIEW::ViewArtist)
     {
-      foreach(QGraphicsItem* gItem, this->items()) {
-        if(gItem->type() != GraphicsItem::ArtistType) continue;
-
-        ArtistGraphicItem* artist_item = static_cast<ArtistGraphicItem*>(gItem);
-
-        if(artist_item->media->id == MEDIA::ArtistPtr::staticCast(media)->id) {
-          point = artist_item->scenePos().toPoint();
-          break;
-        }
-      }
+      idx = m_layout.indexOf(media, LocalSceneLayout::ENTRY_ARTIST);
     }
     else if(media->type() == TYPE_ALBUM && mode() == VIEW::ViewAlbum)
     {
-      foreach(QGraphicsItem* gItem, this->items()) {
-        if(gItem->type() != GraphicsItem::AlbumType) continue;
-
-        AlbumGraphicItem* album_item = static_cast<AlbumGraphicItem*>(gItem);
-
-        if(album_item->media->id == MEDIA::AlbumPtr::staticCast(media)->id) {
-          point = album_item->scenePos().toPoint();
-          break;
-        }
-      }
+      idx = m_layout.indexOf(media, LocalSceneLayout::ENTRY_ALBUM);
+      if(idx == -1)
+        idx = m_layout.indexOf(media, LocalSceneLayout::ENTRY_ALBUM_EXTENDED);
     }
     else if(media->type() == TYPE_TRACK && mode() == VIEW::ViewTrack)
     {
-      foreach(QGraphicsItem* gItem, this->items()) {
-        if(gItem->type() != GraphicsItem::TrackType) continue;
-
-        TrackGraphicItem* track_item = static_cast<TrackGraphicItem*>(gItem);
-
-        if(track_item->media->id == MEDIA::TrackPtr::staticCast(media)->id) {
-          point = track_item->scenePos().toPoint();
-          break;
-        }
-      }
+      idx = m_layout.indexOf(media, LocalSceneLayout::ENTRY_TRACK);
     }
 
+    if(idx != -1)
+      point = m_layout.at(idx).pos;
+
     return point;
 }
 
@@ -1451,20 +1333,11 @@ void LocalScene::loadCoverArtFromFile()
 
       if( filename.isEmpty() ) return;
 
-      const QString cover_path = UTIL::CONFIGDIR + "/albums/" + item->media->coverpath;
-
-      //! get new cover file
+      //! get new cover file, replaces existing cover in store
       QImage image = QImage(filename);
-      image = image.scaled(QSize(110, 110), Qt::KeepAspectRatio, Qt::SmoothTransformation);
+      if( !CoverStore::instance()->store(item->media->coverpath, image) ) return;
 
-      //! remove existing cover file
-      if(QFile::exists(cover_path))
-      {
-        QFile::remove(cover_path);
-        CoverCache::instance()->invalidate(item->media);
-      }
-      //! save new cover file
-      image.save(cover_path, "png", -1);
+      CoverCache::instance()->invalidate(item->media);
 
       //! scene update
       item->update();
@@ -1494,12 +1367,10 @@ void LocalScene::removeCoverArt()
     if(!m_mouseGrabbedItem) return;
     AlbumGraphicItem *item = static_cast<AlbumGraphicItem*>(m_mouseGrabbedItem);
 
-    const QString cover_path =  UTIL::CONFIGDIR + "/albums/" + item->media->coverpath;
-
-    //! remove existing cover file
-    if(QFile::exists(cover_path))
+    //! remove existing cover
+    if(CoverStore::instance()->contains(item->media->coverpath))
     {
-      QFile::remove(cover_path);
+      CoverStore::instance()->remove(item->media->coverpath);
       CoverCache::instance()->invalidate(item->media);
       item->update();
     }
@@ -21,6 +21,7 @@
 //! local
 #include "views/scene_base.h"
 #include "views/local/local_item.h"
+#include "views/local/local_scene_layout.h"
 #include "views/item_menu.h"
 #include "views.h"
 
@@ -29,6 +30,8 @@
 #include <QGraphicsScene>
 #include <QGraphicsItem>
 #include <QMap>
+#include <QHash>
+#include <QFutureWatcher>
 
 
 class LocalTrackModel;
@@ -51,6 +54,7 @@ Q_OBJECT
     int   elementCount() const {return m_infosize;}
 
     QPoint get_item_position(MEDIA::MediaPtr media);
+    bool   isLayoutPending() const {return m_layout_pending;}
 
     void playSelected();
     void rateSelection(QList<QGraphicsItem*>);
@@ -60,6 +64,9 @@ Q_OBJECT
 
     QList<QAction *> actions();
     
+  signals:
+    void layoutApplied();
+
   /* Basic Scene virtual */      
   public slots:
     void populateScene();
@@ -79,6 +86,15 @@ Q_OBJECT
     GraphicsItemMenu         *m_graphic_item_menu;
 
     QMap<QString,QAction*>    m_actions;
+
+    //! viewport virtualization
+    LocalSceneLayout                    m_layout;
+    QFutureWatcher<LocalSceneLayout>    m_layout_watcher;
+    int                                 m_layout_request;
+    bool                                m_layout_pending;
+    int                                 m_last_top;
+    QHash<int, QGraphicsItem*>          m_layout_items;
+    QHash<int, QList<QGraphicsItem*> >  m_layout_pool;
         
   protected:
     void contextMenuEvent(QGraphicsSceneContextMenuEvent *event);
@@ -98,19 +114,20 @@ Q_OBJECT
 
     void slot_clear_history();
 
+    void slot_update_visible_items();
+    void slot_layout_ready();
+
   private :
     //! selection
     QList<QGraphicsItem*> sortedSelectedItem();
 
     //! population scene method
     void populateLocalSceneBuilding();
-    void populateAlbumScene();
-    void populateAlbumGridScene();
-    void populateAlbumExtendedScene();
-    void populateArtistScene();
-    void populateTrackScene();
-    void populateGenreScene();
-    void populateYearScene();
+    void populateLayoutScene();
+    void applyLayout(const LocalSceneLayout& layout);
+    void relayoutScene();
+    void clearScene();
+    void updateSceneRect();
     void populateFavoriteScene();
     void populatePlaylistScene();
     void populatePlaylistOverviewScene();
@@ -122,6 +139,12 @@ Q_OBJECT
     void populateTopRatedAlbum(int YPos);
     void populateMostPlayedArtist(int YPos);
     void populateTopRatedArtist(int YPos);
+
+    //! layout item method
+    QGraphicsItem* createLayoutItem(LocalSceneLayout::EntryType type);
+    QGraphicsItem* takeLayoutItem(int idx);
+    void bindLayoutItem(QGraphicsItem* item, const LocalSceneLayout::Entry& entry);
+    bool isLayoutEntryInRange(int idx, int top, int bottom) const;
     
     //! playing item scene method
     void playAlbum();
@@ -0,0 +1,516 @@
+/****************************************************************************************
+*  YAROCK                                                                               *
+*  Copyright (c) 2010-2014 Sebastien amardeilh <sebastien.amardeilh+yarock@gmail.com>   *
+*                                                                                       *
+*  This program is free software; you can redistribute it and/or modify it under        *
+*  the terms of the GNU General Public License as published by the Free Software        *
+*  Foundation; either version 2 of the License, or (at your option) any later           *
+*  version.                                                                             *
+*                                                                                       *
+*  This program is distributed in the hope that it will be useful, but WITHOUT ANY      *
+*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A      *
+*  PARTICULAR PURPOSE. See the GNU General Public License for more details.             *
+*                                                                                       *
+*  You should have received a copy of the GNU General Public License along with         *
+*  this program.  If not, see <http://www.gnu.org/licenses/>.                           *
+*****************************************************************************************/
+
+#include "local_scene_layout.h"
+
+#include "models/local/local_track_model.h"
+#include "core/database/databasemanager.h"
+
+#include <QtAlgorithms>
+
+/* height of the tallest graphic item, used to look back when culling */
+static const int MAX_ENTRY_HEIGHT = 170;
+
+/*
+********************************************************************************
+*                                                                              *
+*    Class LocalSceneLayout                                                    *
+*                                                                              *
+********************************************************************************
+*/
+LocalSceneLayout::LocalSceneLayout()
+{
+    m_request.id              = -1;
+    m_request.mode            = VIEW::ViewAlbum;
+    m_request.album_view_type = 0;
+    m_request.columns         = 0;
+    m_request.grouping        = false;
+
+    m_height    = 0;
+    m_infosize  = 0;
+}
+
+/*******************************************************************************
+    static helpers
+*******************************************************************************/
+bool LocalSceneLayout::isLayoutView(VIEW::Id mode)
+{
+    switch(mode)
+    {
+      case VIEW::ViewAlbum  :
+      case VIEW::ViewArtist :
+      case VIEW::ViewTrack  :
+      case VIEW::ViewGenre  :
+      case VIEW::ViewYear   : return true;
+      default               : return false;
+    }
+}
+
+int LocalSceneLayout::columnCount(int width)
+{
+    return (width/160 > 2) ? width/160 : 2;
+}
+
+int LocalSceneLayout::entryHeight(EntryType type)
+{
+    switch(type)
+    {
+      case ENTRY_HEADER         : return 40;
+      case ENTRY_CATEGORY       : return 30;
+      case ENTRY_INFO           : return 40;
+      case ENTRY_TRACK          : return 22;
+      case ENTRY_DISC           : return 20;
+      default                   : return 150;
+    }
+}
+
+/*******************************************************************************
+    clear
+*******************************************************************************/
+void LocalSceneLayout::clear()
+{
+    m_entries.clear();
+    m_height    = 0;
+    m_infosize  = 0;
+}
+
+/*******************************************************************************
+    append
+*******************************************************************************/
+void LocalSceneLayout::append(EntryType type, int x, int y, MEDIA::MediaPtr media, const QString& text)
+{
+    Entry entry;
+    entry.type  = type;
+    entry.pos   = QPoint(x, y);
+    entry.media = media;
+    entry.text  = text;
+
+    m_entries.append(entry);
+
+    m_height = qMax(m_height, y + entryHeight(type));
+}
+
+void LocalSceneLayout::append(EntryType type, MEDIA::MediaPtr media, const QString& text)
+{
+    /* position is set by place() */
+    append(type, 0, 0, media, text);
+}
+
+/*******************************************************************************
+    firstIndexFrom
+      -> entries are sorted by y, return the first entry that can intersect
+         a rectangle starting at y
+*******************************************************************************/
+int LocalSceneLayout::firstIndexFrom(int y) const
+{
+    const int top = y - MAX_ENTRY_HEIGHT;
+
+    int low  = 0;
+    int high = m_entries.size();
+    while(low < high)
+    {
+      int mid = (low + high) / 2;
+      if(m_entries.at(mid).pos.y() < top)
+        low = mid + 1;
+      else
+        high = mid;
+    }
+
+    return low;
+}
+
+/*******************************************************************************
+    indexOf
+*******************************************************************************/
+static int mediaId(MEDIA::MediaPtr media)
+{
+    switch(media->type())
+    {
+      case TYPE_ARTIST : return MEDIA::ArtistPtr::staticCast(media)->id;
+      case TYPE_ALBUM  : return MEDIA::AlbumPtr::staticCast(media)->id;
+      case TYPE_TRACK  : return MEDIA::TrackPtr::staticCast(media)->id;
+      default          : return -1;
+    }
+}
+
+int LocalSceneLayout::indexOf(MEDIA::MediaPtr media, EntryType type) const
+{
+    const int id = mediaId(media);
+
+    for(int i=0; i < m_entries.size(); i++)
+    {
+      const Entry& entry = m_entries.at(i);
+      if(entry.type != type || !entry.media) continue;
+
+      if(entry.media == media || (id != -1 && mediaId(entry.media) == id))
+        return i;
+    }
+    return -1;
+}
+
+/*******************************************************************************
+    snapshot
+      -> gui thread, lists are implicitly shared so this is cheap
+*******************************************************************************/
+LocalSceneLayout::Request LocalSceneLayout::snapshot(VIEW::Id mode, int album_view_type, int columns)
+{
+    LocalTrackModel* model = LocalTrackModel::instance();
+
+    Request request;
+    request.id              = -1;
+    request.mode            = mode;
+    request.album_view_type = album_view_type;
+    request.columns         = columns;
+    request.grouping        = DatabaseManager::instance()->DB_PARAM().groupAlbums;
+    request.filter          = model->filter();
+    request.artists         = model->rootItem()->children();
+    request.tracks_by_genre = model->trackByGenre;
+    request.albums          = model->albumItemList;
+
+    return request;
+}
+
+/*******************************************************************************
+    compute
+      -> worker thread, only reads the snapshot
+*******************************************************************************/
+LocalSceneLayout LocalSceneLayout::compute(const Request& request)
+{
+    LocalSceneLayout layout;
+    layout.m_request = request;
+    layout.build();
+
+    return layout;
+}
+
+/*******************************************************************************
+    build
+*******************************************************************************/
+void LocalSceneLayout::build()
+{
+    clear();
+
+    switch(m_request.mode)
+    {
+      case VIEW::ViewAlbum  :
+        if( VIEW::ViewAlbum_Type(m_request.album_view_type) == VIEW::album_grid)
+          buildAlbumGrid();
+        else
+          buildAlbumExtended();
+        break;
+      case VIEW::ViewArtist : buildArtist(); break;
+      case VIEW::ViewTrack  : buildTrack();  break;
+      case VIEW::ViewGenre  : buildGenre();  break;
+      case VIEW::ViewYear   : buildYear();   break;
+      default: break;
+    }
+
+    place();
+}
+
+/*******************************************************************************
+    relayout
+      -> new column count, entries are kept and only positions change
+*******************************************************************************/
+void LocalSceneLayout::relayout(int columns)
+{
+    if(m_request.columns == columns) return;
+
+    m_request.columns = columns;
+    place();
+}
+
+/*******************************************************************************
+    place
+      -> single pass over the entries for the column based views
+           header and categories take a 50px row, items go into a grid
+           of 160px columns, a category closes the current grid row
+      -> track view positions do not depend on columns and are set by
+         buildTrack
+*******************************************************************************/
+void LocalSceneLayout::place()
+{
+    if(m_request.mode == VIEW::ViewTrack) return;
+
+    const bool isGrid    = m_request.mode == VIEW::ViewAlbum &&
+                           VIEW::ViewAlbum_Type(m_request.album_view_type) == VIEW::album_grid;
+    const int rowHeight  = (m_request.mode == VIEW::ViewArtist) ? 165 : 170;
+    const int itemOffset = isGrid ? 10 : 0;
+
+    int categorieRow = 0;
+    int itemRow      = 0;
+    int Column       = 0;
+
+    m_height = 0;
+
+    for(int i=0; i < m_entries.size(); i++)
+    {
+      Entry& entry = m_entries[i];
+
+      switch(entry.type)
+      {
+        case ENTRY_HEADER :
+          entry.pos = QPoint(0, 5);
+          categorieRow++;
+          break;
+
+        case ENTRY_CATEGORY :
+          if(Column>0) {
+            itemRow++;
+            Column = 0;
+          }
+          entry.pos = QPoint(0, 10 + categorieRow*50 + itemRow*rowHeight);
+          categorieRow++;
+          break;
+
+        case ENTRY_INFO :
+          entry.pos = QPoint(0, 10 + categorieRow*50);
+          break;
+
+        default :
+          entry.pos = QPoint(4+160*Column, itemOffset + categorieRow*50 + itemRow*rowHeight);
+
+          if(Column < (m_request.columns-1)) {
+            Column++;
+          }
+          else {
+            Column = 0;
+            itemRow++;
+          }
+          break;
+      }
+
+      m_height = qMax(m_height, entry.pos.y() + entryHeight(entry.type));
+    }
+}
+
+
+void LocalSceneLayout::buildAlbumExtended()
+{
+    append(ENTRY_HEADER, MEDIA::MediaPtr(), tr("Albums"));
+
+    //! artist loop
+    for ( int i = 0; i < m_request.artists.size(); i++ )
+    {
+      MEDIA::ArtistPtr artist = MEDIA::ArtistPtr::staticCast( m_request.artists.at(i) );
+
+      if(!LocalTrackModel::isArtistFiltered(artist, m_request.filter) ) continue;
+
+      append(ENTRY_CATEGORY, MEDIA::MediaPtr(), artist->name);
+
+      //! album loop
+      for (int j = 0; j < artist->childCount(); j++)
+      {
+        MEDIA::AlbumPtr album = MEDIA::AlbumPtr::staticCast( artist->child(j) );
+        if(!LocalTrackModel::isAlbumFiltered(album, m_request.filter) ) continue;
+
+        m_infosize++;
+        append(ENTRY_ALBUM_EXTENDED, album);
+      }
+    }
+
+    if(m_infosize==0)
+      append(ENTRY_INFO, MEDIA::MediaPtr(), tr("No entry found"));
+}
+
+
+void LocalSceneLayout::buildAlbumGrid()
+{
+    append(ENTRY_HEADER, MEDIA::MediaPtr(), tr("Albums"));
+    append(ENTRY_CATEGORY, MEDIA::MediaPtr(), tr("All Albums"));
+
+    //! artist loop
+    for ( int i = 0; i < m_request.artists.size(); i++ )
+    {
+      MEDIA::ArtistPtr artist = MEDIA::ArtistPtr::staticCast(m_request.artists.at(i));
+
+      if(!LocalTrackModel::isArtistFiltered(artist, m_request.filter) ) continue;
+
+      //! album loop
+      for (int j = 0; j < artist->childCount(); j++)
+      {
+        MEDIA::AlbumPtr album = MEDIA::AlbumPtr::staticCast( artist->child(j) );
+        if(!LocalTrackModel::isAlbumFiltered(album, m_request.filter) ) continue;
+
+        m_infosize++;
+        append(ENTRY_ALBUM, album);
+      }
+    }
+
+    if(m_infosize==0)
+      append(ENTRY_INFO, MEDIA::MediaPtr(), tr("No entry found"));
+}
+
+
+void LocalSceneLayout::buildArtist()
+{
+    append(ENTRY_HEADER, MEDIA::MediaPtr(), tr("Artists"));
+
+    //! artist loop
+    QChar start_char;
+    for (int i=0 ; i < m_request.artists.size(); i++ )
+    {
+        MEDIA::ArtistPtr artist = MEDIA::ArtistPtr::staticCast(m_request.artists.at(i));
+        if(! LocalTrackModel::isArtistFiltered(artist, m_request.filter) ) continue;
+
+        QChar current_char = artist->name.at(0).toLower();
+
+        if(start_char !=  current_char) {
+          //! new category
+          start_char = current_char;
+          append(ENTRY_CATEGORY, MEDIA::MediaPtr(), QString(start_char));
+        }
+
+        //! add new artist item
+        m_infosize++;
+        append(ENTRY_ARTIST, artist);
+    } // end for artist loop
+
+    if(m_infosize==0)
+      append(ENTRY_INFO, MEDIA::MediaPtr(), tr("No entry found"));
+}
+
+
+void LocalSceneLayout::buildTrack()
+{
+    int artistRow     = 0;
+    int albumRow      = 0;
+    int trackRow      = 0;
+    int trackPerAlbum = 0;
+    int offset        = 0;
+
+    append(ENTRY_HEADER, 0, 5, MEDIA::MediaPtr(), tr("Tracks"));
+    artistRow++;
+
+    //! artist loop
+    for ( int i = 0; i < m_request.artists.size(); i++ )
+    {
+      MEDIA::ArtistPtr artist = MEDIA::ArtistPtr::staticCast(m_request.artists.at(i));
+
+      if(!LocalTrackModel::isArtistFiltered(artist, m_request.filter) ) continue;
+
+      append(ENTRY_CATEGORY, 0, artistRow*50 + trackRow*20 + albumRow*30 + offset, MEDIA::MediaPtr(), artist->name);
+      artistRow++;
+
+      //! album loop
+      for (int j = 0; j < artist->childCount(); j++)
+      {
+        MEDIA::AlbumPtr album = MEDIA::AlbumPtr::staticCast(artist->child(j));
+
+        if(!LocalTrackModel::isAlbumFiltered(album, m_request.filter)) continue;
+
+        append(ENTRY_ALBUM_TRACKS, 4, artistRow*50 + trackRow*20 + albumRow*30 + offset, album);
+
+        trackPerAlbum = 0;
+
+        //! track loop
+        int disc_number = 0;
+        for (int k = 0; k < album->childCount(); k++)
+        {
+          MEDIA::TrackPtr track = MEDIA::TrackPtr::staticCast(album->child(k));
+          if(!LocalTrackModel::isTrackFiltered(track, m_request.filter)) continue;
+
+          if(m_request.grouping && album->isMultiset() && (disc_number != track->disc_number))
+          {
+            disc_number = track->disc_number;
+
+            append(ENTRY_DISC, 160, artistRow*50 + trackRow*20 + albumRow*30 + offset, MEDIA::MediaPtr(), QString(tr("disc %1")).arg(disc_number));
+            trackRow++;
+          }
+
+          append(ENTRY_TRACK, 155, artistRow*50 + trackRow*20 + albumRow*30 + offset, track);
+
+          trackRow++;
+          trackPerAlbum++;
+          m_infosize++;
+        }
+        albumRow++;
+
+        if( trackPerAlbum < 8 ) offset = offset + (8 - trackPerAlbum)*20;
+      }
+    }
+
+    if(m_infosize==0)
+      append(ENTRY_INFO, 0, 10 + artistRow*50, MEDIA::MediaPtr(), tr("No entry found"));
+}
+
+
+void LocalSceneLayout::buildGenre()
+{
+    append(ENTRY_HEADER, MEDIA::MediaPtr(), tr("Albums by genre"));
+
+    QString s_genre     = "";
+    MEDIA::MediaPtr     media;
+
+    foreach (MEDIA::TrackPtr track, m_request.tracks_by_genre)
+    {
+      //! add filtre
+      if(s_genre == track->genre && media == track->parent()) continue;
+      if(!LocalTrackModel::isTrackFiltered(track, m_request.filter)) continue;
+
+      if(media != track->parent())
+      {
+        /* ------- New Genre ------- */
+        if(s_genre != track->genre)
+        {
+          s_genre = track->genre;
+          append(ENTRY_CATEGORY, MEDIA::MediaPtr(), s_genre);
+
+          m_infosize++; // on compte les categorie = genre
+        }
+
+        /* ------- New Album ------- */
+        media = track->parent();
+        append(ENTRY_ALBUM_GENRE, media, s_genre);
+      }
+    } // fin foreach track
+
+    if(m_infosize==0)
+      append(ENTRY_INFO, MEDIA::MediaPtr(), tr("No entry found"));
+}
+
+
+void LocalSceneLayout::buildYear()
+{
+    append(ENTRY_HEADER, MEDIA::MediaPtr(), tr("Albums by year"));
+
+    int year = -1;
+
+    QList<MEDIA::AlbumPtr> list_album_by_year = m_request.albums;
+
+    //! Sort Media Album Item list By Year
+    qSort(list_album_by_year.begin(), list_album_by_year.end(),MEDIA::compareAlbumItemYear);
+
+    foreach (MEDIA::AlbumPtr album, list_album_by_year)
+    {
+      //! add filtre
+      if(!LocalTrackModel::isAlbumFiltered(album, m_request.filter)) continue;
+
+      if(year != album->year) {
+        //! new year
+        year = album->year;
+        append(ENTRY_CATEGORY, MEDIA::MediaPtr(), QString::number(year));
+
+        m_infosize++; // on compte les categorie = genre
+      }
+
+      append(ENTRY_ALBUM, album);
+    } // fin foreach track
+
+    if(m_infosize==0)
+      append(ENTRY_INFO, MEDIA::MediaPtr(), tr("No entry found"));
+}
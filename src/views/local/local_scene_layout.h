@@ -0,0 +1,124 @@
+/****************************************************************************************
+*  YAROCK                                                                               *
+*  Copyright (c) 2010-2014 Sebastien amardeilh <sebastien.amardeilh+yarock@gmail.com>   *
+*                                                                                       *
+*  This program is free software; you can redistribute it and/or modify it under        *
+*  the terms of the GNU General Public License as published by the Free Software        *
+*  Foundation; either version 2 of the License, or (at your option) any later           *
+*  version.                                                                             *
+*                                                                                       *
+*  This program is distributed in the hope that it will be useful, but WITHOUT ANY      *
+*  WARRANTY; without even the implied warranty of MERCHANTABILITY or FITNESS FOR A      *
+*  PARTICULAR PURPOSE. See the GNU General Public License for more details.             *
+*                                                                                       *
+*  You should have received a copy of the GNU General Public License along with         *
+*  this program.  If not, see <http://www.gnu.org/licenses/>.                           *
+*****************************************************************************************/
+
+#ifndef _LOCAL_SCENE_LAYOUT_H_
+#define _LOCAL_SCENE_LAYOUT_H_
+
+#include "core/mediaitem/mediaitem.h"
+#include "views.h"
+
+#include <QCoreApplication>
+#include <QVector>
+#include <QList>
+#include <QString>
+#include <QPoint>
+
+/*
+********************************************************************************
+*                                                                              *
+*    Class LocalSceneLayout                                                    *
+*      -> flat, position sorted description of a local collection view         *
+*      -> pure data, computed from a model snapshot in a worker thread         *
+*                                                                              *
+********************************************************************************
+*/
+class LocalSceneLayout
+{
+  public:
+    enum EntryType {
+      ENTRY_HEADER = 0,
+      ENTRY_CATEGORY,
+      ENTRY_INFO,
+      ENTRY_ALBUM,          /* AlbumGraphicItem                        */
+      ENTRY_ALBUM_EXTENDED, /* AlbumGraphicItem_v2                     */
+      ENTRY_ALBUM_TRACKS,   /* AlbumGraphicItem_v2 (not selectable)    */
+      ENTRY_ALBUM_GENRE,    /* AlbumGenreGraphicItem                   */
+      ENTRY_ARTIST,         /* ArtistGraphicItem                       */
+      ENTRY_TRACK,          /* TrackGraphicItem_v2                     */
+      ENTRY_DISC            /* disc number text                        */
+    };
+
+    struct Entry {
+      EntryType        type;
+      QPoint           pos;
+      MEDIA::MediaPtr  media;
+      QString          text;
+    };
+
+    /* model snapshot taken in gui thread */
+    struct Request {
+      int                     id;
+      VIEW::Id                mode;
+      int                     album_view_type;
+      int                     columns;
+      bool                    grouping;
+      QString                 filter;
+      QList<MEDIA::MediaPtr>  artists;
+      QList<MEDIA::TrackPtr>  tracks_by_genre;
+      QList<MEDIA::AlbumPtr>  albums;
+    };
+
+    LocalSceneLayout();
+
+    static Request snapshot(VIEW::Id mode, int album_view_type, int columns);
+    static LocalSceneLayout compute(const Request& request);
+
+    static bool isLayoutView(VIEW::Id mode);
+    static int  columnCount(int width);
+    static int  entryHeight(EntryType type);
+    static bool isVirtual(EntryType type) {return type >= ENTRY_ALBUM;}
+
+    void clear();
+    void relayout(int columns);
+
+    bool isEmpty() const {return m_entries.isEmpty();}
+    int  count() const {return m_entries.size();}
+    const Entry& at(int i) const {return m_entries.at(i);}
+
+    int  requestId() const {return m_request.id;}
+    int  columns() const {return m_request.columns;}
+    int  height() const {return m_height;}
+    int  infoSize() const {return m_infosize;}
+
+    int  firstIndexFrom(int y) const;
+    int  indexOf(MEDIA::MediaPtr media, EntryType type) const;
+
+  private:
+    void build();
+    void place();
+
+    /* strings keep the LocalScene translation context */
+    static QString tr(const char* text) {return QCoreApplication::translate("LocalScene", text);}
+
+    void buildAlbumGrid();
+    void buildAlbumExtended();
+    void buildArtist();
+    void buildTrack();
+    void buildGenre();
+    void buildYear();
+
+    void append(EntryType type, int x, int y, MEDIA::MediaPtr media = MEDIA::MediaPtr(), const QString& text = QString());
+    void append(EntryType type, MEDIA::MediaPtr media, const QString& text = QString());
+
+  private:
+    Request         m_request;
+    QVector<Entry>  m_entries;
+    int             m_height;
+    int             m_infosize;
+};
+
+#endif // _LOCAL_SCENE_LAYOUT_H_
@@ -20,6 +20,7 @@
 #include "models/local/local_track_model.h"
 #include "core/mediaitem/mediaitem.h"
 #include "core/database/database.h"
+#include "smartplaylist/smartplaylist.h"
 
 #include "debug.h"
 
@@ -51,6 +52,8 @@ void LocalScene::rateTrack(QGraphicsItem* gi)
       MEDIA::ArtistPtr artist = MEDIA::ArtistPtr::staticCast(album->parent());
       if(!artist->isUserRating)
          artist->rating = m_localTrackModel->getItemAutoRating(artist);
+
+      SmartPlaylist::invalidateCache(SmartPlaylist::DEP_RATING);
      }
 }
 
@@ -72,6 +75,8 @@ void LocalScene::rateArtist(QGraphicsItem* gi)
       q.bindValue(":rat", artist->rating );
       q.bindValue(":id", artist->id );
       q.exec();
+
+      SmartPlaylist::invalidateCache(SmartPlaylist::DEP_RATING);
      }
 }
 
@@ -107,6 +112,8 @@ void LocalScene::rateAlbum(QGraphicsItem* gi)
         if(!artist->isUserRating)
            artist->rating = m_localTrackModel->getItemAutoRating(artist);
       }
+
+      SmartPlaylist::invalidateCache(SmartPlaylist::DEP_RATING);
    }
 }
 /*******************************************************************************
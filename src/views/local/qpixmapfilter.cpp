@@ -24,13 +24,86 @@
 //! the resulting shadow is not so good as original qt GraphicsEffect
 //! however it's enough for the visual needs for me.
 
+//! the 32 bits half scale kernel uses SSE2 or AVX2 when the compiler
+//! targets them (-msse2 is default on x86_64, -mavx2 must be asked for)
+//! pavgb rounds up, the vector paths take off the carry bit so that they
+//! stay bit-exact with the scalar AVG macro (rounding down)
+
 #include "qpixmapfilter.h"
 #include <QPainter>
 #include "qmath.h"
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 #define AVG(a,b)  ( ((((a)^(b)) & 0xfefefefeUL) >> 1) + ((a)&(b)) )
 #define AVG16(a,b)  ( ((((a)^(b)) & 0xf7deUL) >> 1) + ((a)&(b)) )
 
+#if defined(__AVX2__)
+static inline __m256i avg_floor_256(__m256i a, __m256i b)
+{
+    const __m256i carry = _mm256_and_si256(_mm256_xor_si256(a, b), _mm256_set1_epi8(0x01));
+    return _mm256_sub_epi8(_mm256_avg_epu8(a, b), carry);
+}
+
+/* average of the 8 horizontal pixel pairs at p, in 128 bits lane order */
+static inline __m256i avg_pairs_256(const quint32 *p)
+{
+    const __m256 v0 = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p)));
+    const __m256 v1 = _mm256_castsi256_ps(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(p + 8)));
+
+    const __m256i even = _mm256_castps_si256(_mm256_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0)));
+    const __m256i odd  = _mm256_castps_si256(_mm256_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1)));
+    return avg_floor_256(even, odd);
+}
+#endif
+
+#if defined(__SSE2__)
+static inline __m128i avg_floor_128(__m128i a, __m128i b)
+{
+    const __m128i carry = _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(0x01));
+    return _mm_sub_epi8(_mm_avg_epu8(a, b), carry);
+}
+
+/* average of the 4 horizontal pixel pairs at p */
+static inline __m128i avg_pairs_128(const quint32 *p)
+{
+    const __m128 v0 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p)));
+    const __m128 v1 = _mm_castsi128_ps(_mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 4)));
+
+    const __m128i even = _mm_castps_si128(_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(2, 0, 2, 0)));
+    const __m128i odd  = _mm_castps_si128(_mm_shuffle_ps(v0, v1, _MM_SHUFFLE(3, 1, 3, 1)));
+    return avg_floor_128(even, odd);
+}
+#endif
+
+/* average 2x2 blocks of two source rows into one destination row,
+   horizontal pairs first as the scalar loop does */
+void qt_halfScaledRow(const quint32 *p1, const quint32 *p2, quint32 *q, int ww)
+{
+    int x = 0;
+
+#if defined(__AVX2__)
+    for (; x + 8 <= ww; x += 8, q += 8, p1 += 16, p2 += 16) {
+        // shuffle works inside 128 bits lanes, pixels are put back in order after
+        const __m256i avg = avg_floor_256(avg_pairs_256(p1), avg_pairs_256(p2));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(q), _mm256_permute4x64_epi64(avg, _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+#endif
+
+#if defined(__SSE2__)
+    for (; x + 4 <= ww; x += 4, q += 4, p1 += 8, p2 += 8)
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(q), avg_floor_128(avg_pairs_128(p1), avg_pairs_128(p2)));
+#endif
+
+    for (; x < ww; ++x, ++q, p1 += 2, p2 += 2)
+        *q = AVG(AVG(p1[0], p1[1]), AVG(p2[0], p2[1]));
+}
+
 QImage qt_halfScaled(const QImage &source)
 {
     if (source.width() < 2 || source.height() < 2)
@@ -108,13 +181,8 @@ QImage qt_halfScaled(const QImage &source)
     int ww = dest.width();
     int hh = dest.height();
 
-    for (int y = hh; y; --y, dst += dx, src += sx2) {
-        const quint32 *p1 = src;
-        const quint32 *p2 = src + sx;
-        quint32 *q = dst;
-        for (int x = ww; x; --x, q++, p1 += 2, p2 += 2)
-            *q = AVG(AVG(p1[0], p1[1]), AVG(p2[0], p2[1]));
-    }
+    for (int y = hh; y; --y, dst += dx, src += sx2)
+        qt_halfScaledRow(src, src + sx, dst, ww);
 
     return dest;
 }
@@ -147,11 +215,8 @@ void qt_blurImage(QPainter *p, QImage &blurImage, qreal radius, bool /*quality N
 }
 
 
-void drawShadow(QPainter *p,const QPointF &pos,const QPixmap &px,const QRectF &src)
+static QImage shadowImage(const QPixmap &px)
 {
-    if (px.isNull())
-        return;
-
     qreal _radius = 20;
     QColor _color = QColor(63, 63, 63, 140);
     QPointF _offset = QPointF(2,2);
@@ -180,9 +245,34 @@ void drawShadow(QPainter *p,const QPointF &pos,const QPixmap &px,const QRectF &s
     tmpPainter.fillRect(tmp.rect(), _color);
     tmpPainter.end();
 
-      // draw the blurred drop shadow...
-    p->drawImage(pos, tmp);
+    return tmp;
+}
+
+
+void drawShadow(QPainter *p,const QPointF &pos,const QPixmap &px,const QRectF &src)
+{
+    if (px.isNull())
+        return;
+
+    // draw the blurred drop shadow...
+    p->drawImage(pos, shadowImage(px));
 
     // Draw the actual pixmap...
     p->drawPixmap(pos, px, src);
 }
+
+
+QPixmap shadowedPixmap(const QPixmap &px)
+{
+    if (px.isNull())
+        return px;
+
+    QPixmap result(px.size());
+    result.fill(Qt::transparent);
+
+    QPainter p(&result);
+    drawShadow(&p, QPointF(0,0), px, px.rect());
+    p.end();
+
+    return result;
+}
@@ -25,4 +25,10 @@
 
 void drawShadow(QPainter *p, const QPointF &pos, const QPixmap &px, const QRectF &src = QRectF());
 
+//! pixmap with its drop shadow painted under it, meant to be cached
+QPixmap shadowedPixmap(const QPixmap &px);
+
+//! one 32 bits row of the half scale pass (public for halfscale_bench)
+void qt_halfScaledRow(const quint32 *p1, const quint32 *p2, quint32 *q, int ww);
+
 #endif // _QPIXMAPFILTER_H_
@@ -18,6 +18,8 @@
 #include "mediaitem_edit_dialog.h"
 #include "core/database/database.h"
 #include "core/mediaitem/mediaitem.h"
+#include "covers/coverstore.h"
+#include "smartplaylist/smartplaylist.h"
 #include "utilities.h"
 #include "debug.h"
 
@@ -39,23 +41,11 @@ void recupCoverArt(const QString &newCoverName, const QString &oldCoverName);
 void recupCoverArt(const QString &newCoverName, const QString &oldCoverName)
 {
     //Debug::debug() << " ----recupCoverArt newCoverName + oldCoverName---- " << newCoverName + " - " + oldCoverName;
-    QString storageLocation = UTIL::CONFIGDIR + "/albums/";
-
     //! quit if same filename
     if(newCoverName == oldCoverName) return;
 
-    //! copy old into new
-    QFile oldCoverFile(storageLocation + oldCoverName);
-    if(oldCoverFile.exists()) 
-    {
-      //! remove new cover if already exist
-      QFile newCoverFile(storageLocation + newCoverName);
-      if(newCoverFile.exists()) 
-        newCoverFile.remove();
-
-      //Debug::debug() << " ----recupCoverArt oldCoverName exists COPY ---- ";
-      oldCoverFile.rename(storageLocation + newCoverName);
-    }
+    //! move old into new, replaces new cover if already exist
+    CoverStore::instance()->rename(oldCoverName, newCoverName);
 }
 
 
@@ -501,6 +491,9 @@ void MediaItem_Edit_Dialog::on_buttonBox_accepted()
       default:break;
     }
 
+    /* tags, playcount and rating may have been edited */
+    SmartPlaylist::invalidateCache(SmartPlaylist::DEP_TAGS | SmartPlaylist::DEP_PLAYCOUNT | SmartPlaylist::DEP_RATING);
+
     this->setResult(QDialog::Accepted);
     QDialog::accept();
     this->close();
@@ -49,6 +49,7 @@ class NowPlaying : public QWidget
        connect(Engine::instance(), SIGNAL(mediaChanged()), this, SLOT(update()));
        connect(Engine::instance(), SIGNAL(mediaMetaDataChanged()), this, SLOT(update()));
        connect(Engine::instance(), SIGNAL(engineStateChanged()), this, SLOT(update()));
+       connect(CoverCache::instance(), SIGNAL(coversLoaded()), this, SLOT(update()));
     }
 
   protected:
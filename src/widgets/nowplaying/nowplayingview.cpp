@@ -53,6 +53,7 @@ NowPlayingView::NowPlayingView(QWidget *parent) : QWidget(parent)
     connect(Engine::instance(), SIGNAL(mediaChanged()), this, SLOT(update()));
     connect(Engine::instance(), SIGNAL(mediaMetaDataChanged()), this, SLOT(update()));
     connect(Engine::instance(), SIGNAL(engineStateChanged()), this, SLOT(update()));
+    connect(CoverCache::instance(), SIGNAL(coversLoaded()), this, SLOT(update()));
 }
 
 
@@ -20,6 +20,7 @@
 
 // data model
 #include "models/local/local_track_model.h"
+#include "models/local/suggestion_index.h"
 #include "models/local/histo_model.h"
 #include "models/stream/stream_model.h"
 
@@ -27,6 +28,8 @@
 #include "views.h"
 #include "debug.h"
 
+#include <QtConcurrentRun>
+
 /*
 ********************************************************************************
 *                                                                              *
@@ -36,12 +39,23 @@
 */
 PopupModel::PopupModel(QObject *parent) : QStandardItemModel(parent)
 {
+    m_request = 0;
+
+    connect(&m_watcher, SIGNAL(finished()), this, SLOT(slot_collection_suggestions_ready()));
+}
 
+
+void PopupModel::cancel()
+{
+    /* drop result of pending collection request */
+    m_request++;
 }
 
 
 void PopupModel::populateModel(const QString & query)
 {
+    /* any pending collection request is now obsolete */
+    m_request++;
 
     switch(SETTINGS()->_viewMode)
     {
@@ -53,9 +67,10 @@ void PopupModel::populateModel(const QString & query)
       case VIEW::ViewFavorite  :
       case VIEW::ViewDashBoard :
         getCollectionSuggestions(query);
-        break;
+        return;
 
       case VIEW::ViewHistory   :
+        this->clear();
         getHistorySuggestions(query);
         break;
 
@@ -63,84 +78,84 @@ void PopupModel::populateModel(const QString & query)
       case VIEW::ViewShoutCast     :
       case VIEW::ViewTuneIn        :
       case VIEW::ViewFavoriteRadio :
+        this->clear();
         getStreamSuggestions(query);
         break;
 
       case VIEW::ViewPlaylist      :
       case VIEW::ViewSmartPlaylist :
         getCollectionSuggestions(query);
-        break;
+        return;
 
       default :
+        this->clear();
         break;
     }
 
     emit dataChanged(QModelIndex(), QModelIndex());
+    emit modelPopulated();
 }
 
 /*******************************************************************************
     getCollectionSuggestions
+      lookup is done in a worker thread from the collection suggestion index,
+      results of an obsolete request are dropped
 *******************************************************************************/
 void PopupModel::getCollectionSuggestions(const QString & query)
 {
-    QStandardItem *rootItem = this->invisibleRootItem();
+    QSharedPointer<const SuggestionIndex> index = LocalTrackModel::instance()->suggestionIndex();
 
-    QStringList artists;
-    QStringList albums;
-    QStringList titles;
+    if(index.isNull()) {
+      this->clear();
+      emit modelPopulated();
+      return;
+    }
 
-    // get data from model
-    LocalTrackModel* model = LocalTrackModel::instance();
-    QList<MEDIA::TrackPtr> tracks = model->trackItemHash.values();
+    m_watcher.setFuture( QtConcurrent::run(&PopupModel::findCollectionSuggestions, index, query, m_request) );
+}
 
-    foreach (MEDIA::TrackPtr track, tracks)
-    {
-       bool found = false;
-       if(query.length() < 3)
-        found = track->artist.startsWith ( query, Qt::CaseInsensitive );
-       else
-        found = track->artist.contains ( query, Qt::CaseInsensitive );
 
-       if(found && !artists.contains(track->artist) && artists.count() < 5)
-         artists << track->artist;
+CollectionSuggestions PopupModel::findCollectionSuggestions(
+               QSharedPointer<const SuggestionIndex> index, const QString& query, int request)
+{
+    CollectionSuggestions result;
+    result.request = request;
+    result.artists = index->find(SuggestionIndex::ARTIST, query, 5);
+    result.albums  = index->find(SuggestionIndex::ALBUM,  query, 5);
+    result.titles  = index->find(SuggestionIndex::TITLE,  query, 5);
 
-       found = false;
-       if(query.length() < 3)
-        found = track->album.startsWith ( query, Qt::CaseInsensitive );
-       else
-        found = track->album.contains ( query, Qt::CaseInsensitive );
+    return result;
+}
 
-       if(found && !albums.contains(track->album) && albums.count() < 5)
-         albums << track->album;
 
-       found = false;
-       if(query.length() < 3)
-        found = track->title.startsWith ( query, Qt::CaseInsensitive );
-       else
-        found = track->title.contains ( query, Qt::CaseInsensitive );
+void PopupModel::slot_collection_suggestions_ready()
+{
+    const CollectionSuggestions result = m_watcher.result();
 
-       if(found && !titles.contains(track->title) && titles.count() < 5)
-         titles << track->title;
+    if(result.request != m_request)
+      return;
 
-       if(artists.count() == 5 && albums.count() == 5 && titles.count() == 5)
-         break;
-    }
+    this->clear();
+    QStandardItem *rootItem = this->invisibleRootItem();
 
     // make model item
-    foreach (const QString& artist, artists) {
+    foreach (const QString& artist, result.artists) {
       PopupItem* item = new PopupItem(artist, QIcon(":/images/view-artist.png"));
       rootItem->appendRow(item);
     }
 
-    foreach (const QString& album, albums) {
+    foreach (const QString& album, result.albums) {
       PopupItem* item = new PopupItem(album, QIcon(":/images/album.png"));
       rootItem->appendRow(item);
     }
 
-    foreach (const QString& title, titles) {
+    foreach (const QString& title, result.titles) {
       PopupItem* item = new PopupItem(title, QIcon(":/images/track-48x48.png"));
       rootItem->appendRow(item);
     }
+
+    emit dataChanged(QModelIndex(), QModelIndex());
+    emit modelPopulated();
 }
 
 
@@ -20,6 +20,20 @@
 
 
 #include <QStandardItemModel>
+#include <QStringList>
+#include <QFutureWatcher>
+#include <QSharedPointer>
+
+class SuggestionIndex;
+
+/* collection suggestions computed outside gui thread */
+struct CollectionSuggestions
+{
+    int          request;
+    QStringList  artists;
+    QStringList  albums;
+    QStringList  titles;
+};
 
 /*
 ********************************************************************************
@@ -35,11 +49,25 @@ Q_OBJECT
     PopupModel(QObject *parent = 0);
 
     void populateModel(const QString &);
+    void cancel();
 
   private:
     void getCollectionSuggestions(const QString & );
     void getHistorySuggestions(const QString & );
     void getStreamSuggestions(const QString & );
+
+    static CollectionSuggestions findCollectionSuggestions(
+               QSharedPointer<const SuggestionIndex> index, const QString& query, int request);
+
+  private slots:
+    void slot_collection_suggestions_ready();
+
+  private:
+    int                                    m_request;
+    QFutureWatcher<CollectionSuggestions>  m_watcher;
+
+  signals:
+    void modelPopulated();
 };
 
 #endif // _POPUP_MODEL_H_
@@ -57,7 +57,7 @@ SearchPopup::SearchPopup(ExLineEdit *parent): QFrame(parent),
 
     m_timer = new QTimer(this);
     m_timer->setSingleShot(true);
-    m_timer->setInterval(500);
+    m_timer->setInterval(250);
 
     // connection
     connect(m_line_edit, SIGNAL(textfield_changed()), m_timer, SLOT(start()));
@@ -65,6 +65,7 @@ SearchPopup::SearchPopup(ExLineEdit *parent): QFrame(parent),
 
     connect(m_popup_view, SIGNAL(itemActivated(const QString&)),this, SLOT(slot_popup_item_clicked(const QString&)));
     connect(m_timer, SIGNAL(timeout()),this, SLOT(slot_exec_popup()));
+    connect(m_popup_model, SIGNAL(modelPopulated()),this, SLOT(slot_on_model_populated()));
 
     m_enableUpdate = true;
     MainWindow::instance()->installEventFilter(this);
@@ -108,6 +109,7 @@ void SearchPopup::slot_on_new_search()
 {
     //Debug::debug() << "SearchPopup::slot_on_new_search";
     m_timer->stop();
+    m_popup_model->cancel();
     this->hide();
 }
 
@@ -130,10 +132,24 @@ void SearchPopup::slot_exec_popup()
         return;
     }
 
-    // populate popup model
-    this->setUpdatesEnabled(false);
-    m_popup_model->clear();
+    // populate popup model (may be asynchronous)
     m_popup_model->populateModel(query);
+}
+
+/*******************************************************************************
+ slot_on_model_populated
+*******************************************************************************/
+void SearchPopup::slot_on_model_populated()
+{
+    if (!m_enableUpdate) return;
+    if (!m_line_edit->hasFocus()) return;
+
+    if (m_popup_model->rowCount() == 0) {
+        this->hide();
+        return;
+    }
+
+    this->setUpdatesEnabled(false);
     show_popup();
 }
 
@@ -46,6 +46,7 @@ private slots:
     void slot_popup_item_clicked(const QString&);
     void slot_exec_popup();
     void slot_on_new_search();
+    void slot_on_model_populated();
 
 protected:
     void hideEvent ( QHideEvent * );